@@ -0,0 +1,473 @@
+// libcwav host benchmarks. Results are printed as one JSON object per line.
+#include "cwav.h"
+#include "corpus.h"
+#include "host_sim.h"
+#include "host_mixer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_MIN_TIME_NS 200000000ULL
+#define BENCH_SAMPLE_RATE 32728
+
+static u64 bench_nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static double bench_minTimeNs()
+{
+    const char* env = getenv("CWAV_BENCH_MIN_TIME_MS");
+    return env ? atof(env) * 1000000.0 : (double)BENCH_MIN_TIME_NS;
+}
+
+typedef struct benchSound_s
+{
+    CWAV cwav;
+    u8* file;
+    u32 fileSize;
+} benchSound_t;
+
+static bool bench_loadSound(benchSound_t* sound, cwavAudioEncoding_t encoding, u32 channels, u32 samples, bool looped, u8 maxSPlays)
+{
+    sound->file = corpusMakeCwav(encoding, channels, samples, looped, BENCH_SAMPLE_RATE, &sound->fileSize);
+    cwavLoad(&sound->cwav, sound->file, maxSPlays);
+    return sound->cwav.loadStatus == CWAV_SUCCESS;
+}
+
+static void bench_freeSound(benchSound_t* sound)
+{
+    cwavFree(&sound->cwav);
+    linearFree(sound->file);
+}
+
+static void bench_load(cwavAudioEncoding_t encoding, u32 channels, u32 samples)
+{
+    u32 fileSize = 0;
+    u8* file = corpusMakeCwav(encoding, channels, samples, false, BENCH_SAMPLE_RATE, &fileSize);
+    double minTime = bench_minTimeNs();
+
+    u64 iterations = 0;
+    u64 start = bench_nowNs();
+    u64 elapsed = 0;
+    bool success = true;
+    do
+    {
+        for (u32 i = 0; i < 256; i++)
+        {
+            CWAV cwav;
+            cwavLoad(&cwav, file, 1);
+            success &= cwav.loadStatus == CWAV_SUCCESS;
+            cwavFree(&cwav);
+        }
+        iterations += 256;
+        elapsed = bench_nowNs() - start;
+    } while (elapsed < minTime);
+
+    printf("{\"suite\":\"load\",\"encoding\":\"%s\",\"channels\":%u,\"samples\":%u,\"bytes\":%u,\"success\":%s,\"iterations\":%llu,\"ns_per_op\":%.1f}\n",
+        corpusEncodingName(encoding), channels, samples, fileSize, success ? "true" : "false", (unsigned long long)iterations, (double)elapsed / iterations);
+    linearFree(file);
+}
+
+static void bench_inspect(cwavAudioEncoding_t encoding, u32 channels, u32 samples)
+{
+    u32 fileSize = 0;
+    u8* file = corpusMakeCwav(encoding, channels, samples, false, BENCH_SAMPLE_RATE, &fileSize);
+    double minTime = bench_minTimeNs();
+
+    u64 iterations = 0;
+    u64 start = bench_nowNs();
+    u64 elapsed = 0;
+    u32 valid = 0;
+    do
+    {
+        for (u32 i = 0; i < 1024; i++)
+        {
+            cwavInfo info;
+            valid += cwavInspect(file, fileSize, &info) == CWAV_SUCCESS;
+        }
+        iterations += 1024;
+        elapsed = bench_nowNs() - start;
+    } while (elapsed < minTime);
+
+    printf("{\"suite\":\"inspect\",\"encoding\":\"%s\",\"channels\":%u,\"samples\":%u,\"bytes\":%u,\"success\":%s,\"iterations\":%llu,\"ns_per_op\":%.1f}\n",
+        corpusEncodingName(encoding), channels, samples, fileSize, valid == iterations ? "true" : "false", (unsigned long long)iterations, (double)elapsed / iterations);
+    linearFree(file);
+}
+
+// Plays a sound with registeredAmount sounds loaded and busyVoices voices already playing.
+static void bench_play(cwavAudioEncoding_t encoding, u32 registeredAmount, u32 busyVoices)
+{
+    benchSound_t* sounds = calloc(registeredAmount, sizeof(benchSound_t));
+    for (u32 i = 0; i < registeredAmount; i++)
+        bench_loadSound(&sounds[i], encoding, 1, 4096, true, 1);
+
+    // Looped sounds keep their voices busy until they are stopped.
+    u32 busy = 0;
+    for (u32 i = 1; i < registeredAmount && busy < busyVoices; i++, busy++)
+        cwavPlay(&sounds[i].cwav, 0, -1);
+
+    double minTime = bench_minTimeNs();
+    u64 iterations = 0;
+    u64 start = bench_nowNs();
+    u64 elapsed = 0;
+    u32 succeeded = 0;
+    do
+    {
+        for (u32 i = 0; i < 256; i++)
+            succeeded += cwavPlay(&sounds[0].cwav, 0, -1).playStatus == CWAV_SUCCESS;
+        iterations += 256;
+        elapsed = bench_nowNs() - start;
+    } while (elapsed < minTime);
+
+    printf("{\"suite\":\"play\",\"encoding\":\"%s\",\"registered\":%u,\"busy_voices\":%u,\"success\":%s,\"iterations\":%llu,\"ns_per_op\":%.1f}\n",
+        corpusEncodingName(encoding), registeredAmount, busy, succeeded == iterations ? "true" : "false", (unsigned long long)iterations, (double)elapsed / iterations);
+
+    for (u32 i = 0; i < registeredAmount; i++)
+        bench_freeSound(&sounds[i]);
+    free(sounds);
+}
+
+static void bench_status(u32 registeredAmount, u32 busyVoices)
+{
+    benchSound_t* sounds = calloc(registeredAmount, sizeof(benchSound_t));
+    for (u32 i = 0; i < registeredAmount; i++)
+        bench_loadSound(&sounds[i], CWAV_ENCODING_PCM16, 2, 1024, true, 2);
+    u32 busy = 0;
+    for (u32 i = 0; i < registeredAmount && busy + 2 <= busyVoices; i++, busy += 2)
+        cwavPlay(&sounds[i].cwav, 0, 1);
+
+    double minTime = bench_minTimeNs();
+    u64 iterations = 0;
+    u64 start = bench_nowNs();
+    u64 elapsed = 0;
+    u32 playing = 0;
+    do
+    {
+        for (u32 i = 0; i < 1024; i++)
+            playing += cwavIsPlaying(&sounds[i % registeredAmount].cwav);
+        iterations += 1024;
+        elapsed = bench_nowNs() - start;
+    } while (elapsed < minTime);
+    printf("{\"suite\":\"is_playing\",\"registered\":%u,\"busy_voices\":%u,\"iterations\":%llu,\"ns_per_op\":%.1f}\n",
+        registeredAmount, busy, (unsigned long long)iterations, (double)elapsed / iterations);
+
+    iterations = 0;
+    start = bench_nowNs();
+    u32 channels = 0;
+    do
+    {
+        for (u32 i = 0; i < 1024; i++)
+            channels |= cwavGetEnvironmentPlayingChannels();
+        iterations += 1024;
+        elapsed = bench_nowNs() - start;
+    } while (elapsed < minTime);
+    printf("{\"suite\":\"playing_channels\",\"registered\":%u,\"busy_voices\":%u,\"iterations\":%llu,\"ns_per_op\":%.1f}\n",
+        registeredAmount, busy, (unsigned long long)iterations, (double)elapsed / iterations);
+
+    for (u32 i = 0; i < registeredAmount; i++)
+        bench_freeSound(&sounds[i]);
+    free(sounds);
+}
+
+// Loads and frees a sound while registeredAmount sounds stay loaded.
+static void bench_churn(u32 registeredAmount)
+{
+    benchSound_t* sounds = calloc(registeredAmount, sizeof(benchSound_t));
+    for (u32 i = 0; i < registeredAmount; i++)
+        bench_loadSound(&sounds[i], CWAV_ENCODING_PCM8, 1, 1024, false, 1);
+
+    u32 fileSize = 0;
+    u8* file = corpusMakeCwav(CWAV_ENCODING_PCM8, 1, 1024, false, BENCH_SAMPLE_RATE, &fileSize);
+    double minTime = bench_minTimeNs();
+    u64 iterations = 0;
+    u64 start = bench_nowNs();
+    u64 elapsed = 0;
+    do
+    {
+        for (u32 i = 0; i < 256; i++)
+        {
+            // Free one of the loaded sounds and load it again, so the list position changes.
+            benchSound_t* sound = &sounds[i % registeredAmount];
+            cwavFree(&sound->cwav);
+            cwavLoad(&sound->cwav, sound->file, 1);
+        }
+        iterations += 256;
+        elapsed = bench_nowNs() - start;
+    } while (elapsed < minTime);
+    printf("{\"suite\":\"register_churn\",\"registered\":%u,\"iterations\":%llu,\"ns_per_op\":%.1f}\n",
+        registeredAmount, (unsigned long long)iterations, (double)elapsed / iterations);
+
+    linearFree(file);
+    for (u32 i = 0; i < registeredAmount; i++)
+        bench_freeSound(&sounds[i]);
+    free(sounds);
+}
+
+// Fast-forwards the simulator with all the DSP channels playing looped and one shot sounds.
+static void bench_simulate(u32 simulatedSeconds)
+{
+    benchSound_t looped, oneShot;
+    bench_loadSound(&looped, CWAV_ENCODING_DSP_ADPCM, 1, 48000, true, 12);
+    bench_loadSound(&oneShot, CWAV_ENCODING_PCM16, 2, 16000, false, 6);
+    for (u32 i = 0; i < 12; i++)
+        cwavPlay(&looped.cwav, 0, -1);
+
+    u64 frameStart = hostSimGetFrameCount();
+    u32 finished = 0;
+    u64 start = bench_nowNs();
+    for (u32 ms = 0; ms < simulatedSeconds * 1000; ms += 100)
+    {
+        // Retrigger the one shot sounds as soon as they finish.
+        if (!cwavIsPlaying(&oneShot.cwav))
+        {
+            finished++;
+            for (u32 i = 0; i < 6; i++)
+                cwavPlay(&oneShot.cwav, 0, 1);
+        }
+        hostSimAdvanceMs(100);
+    }
+    u64 elapsed = bench_nowNs() - start;
+    u64 frames = hostSimGetFrameCount() - frameStart;
+
+    printf("{\"suite\":\"simulate\",\"simulated_s\":%u,\"frames\":%llu,\"retriggers\":%u,\"ns_per_frame\":%.1f,\"speedup\":%.1f}\n",
+        simulatedSeconds, (unsigned long long)frames, finished, (double)elapsed / frames, simulatedSeconds * 1e9 / elapsed);
+
+    bench_freeSound(&oneShot);
+    bench_freeSound(&looped);
+}
+
+// Software mixer cost, every voice loops over random data with a pitch that needs resampling.
+static void bench_mixer(u16 format, ndspInterpType interp, u32 voiceCount)
+{
+    static const char* interpNames[] = {"polyphase", "linear", "none"};
+    const u32 sampleCount = 28000; // Multiple of 14, the DSP ADPCM frame size.
+    u8* data = linearAlloc(sampleCount * 2);
+    u32 seed = 0x12345678;
+    for (u32 i = 0; i < sampleCount * 2; i++)
+    {
+        seed = seed * 1664525 + 1013904223;
+        data[i] = seed >> 24;
+    }
+    // Keep the ADPCM scales low so the decoded data stays in range.
+    if (format == NDSP_FORMAT_ADPCM)
+    {
+        for (u32 i = 0; i < sampleCount / 14 * 8; i += 8)
+            data[i] &= 0x77;
+    }
+
+    hostMixerVoice* voices = malloc(sizeof(hostMixerVoice) * voiceCount);
+    ndspWaveBuf* bufs = calloc(voiceCount, sizeof(ndspWaveBuf));
+    ndspAdpcmData adpcmData = {0};
+    for (u32 i = 0; i < voiceCount; i++)
+    {
+        hostMixerVoiceReset(&voices[i]);
+        voices[i].format = format;
+        voices[i].interp = interp;
+        for (u32 j = 0; j < 16; j++)
+            voices[i].adpcmCoefs[j] = (j & 1) ? -1024 : 2048;
+        voices[i].mix[0] = voices[i].mix[2] = 0.01f;
+        voices[i].mix[1] = voices[i].mix[3] = 0.005f;
+        voices[i].mix[4] = 0.002f; // Aux 0 send
+        hostMixerVoiceSetRate(&voices[i], BENCH_SAMPLE_RATE * (0.5f + (i % 16) / 16.f));
+        bufs[i].data_vaddr = data;
+        bufs[i].nsamples = sampleCount;
+        bufs[i].looping = true;
+        bufs[i].adpcm_data = &adpcmData;
+        hostMixerVoiceQueue(&voices[i], &bufs[i]);
+    }
+
+    hostMixerBus buses[HOST_MIXER_BUSES];
+    double minTime = bench_minTimeNs();
+    u64 frames = 0;
+    u64 start = bench_nowNs();
+    u64 elapsed = 0;
+    do
+    {
+        for (u32 i = 0; i < 32; i++)
+            hostMixerRender(voices, voiceCount, buses);
+        frames += 32;
+        elapsed = bench_nowNs() - start;
+    } while (elapsed < minTime);
+
+    double nsPerFrame = (double)elapsed / frames;
+    double frameNs = HOST_SIM_DSP_FRAME_TICKS * 1e9 / SYSCLOCK_ARM11;
+    printf("{\"suite\":\"mixer\",\"format\":\"%s\",\"interp\":\"%s\",\"voices\":%u,\"frames\":%llu,\"ns_per_frame\":%.1f,\"ns_per_voice_frame\":%.1f,\"realtime_load\":%.4f}\n",
+        format == NDSP_FORMAT_ADPCM ? "DSP_ADPCM" : format == NDSP_FORMAT_PCM8 ? "PCM8" : "PCM16", interpNames[interp], voiceCount,
+        (unsigned long long)frames, nsPerFrame, nsPerFrame / voiceCount, nsPerFrame / frameNs);
+
+    free(bufs);
+    free(voices);
+    linearFree(data);
+}
+
+// Spatialization of emitterCount moving emitters, the first 24 drive playing voices.
+static void bench_spatial(u32 emitterCount)
+{
+    benchSound_t sound;
+    bench_loadSound(&sound, CWAV_ENCODING_DSP_ADPCM, 1, 4096, true, 24);
+
+    float* data = calloc(emitterCount * 10, sizeof(float));
+    s8* channels = malloc(emitterCount);
+    cwavEmitters emitters = {emitterCount, data, data + emitterCount, data + emitterCount * 2,
+        data + emitterCount * 3, data + emitterCount * 4, data + emitterCount * 5, channels, NULL, NULL};
+    for (u32 i = 0; i < emitterCount; i++)
+    {
+        data[i] = (float)(i % 7) - 3.f;
+        data[emitterCount + i] = 0.5f;
+        data[emitterCount * 2 + i] = (float)(i % 5) - 2.f;
+        data[emitterCount * 3 + i] = 1.f;
+        channels[i] = i < 24 ? (s8)cwavPlay(&sound.cwav, 0, -1).monoLeftChannel : -1;
+    }
+    cwavListener listener = {{0, 0, 0}, {0, 0, 0}, {1, 0, 0}, {0, 0, 1}};
+    cwavSpatialModel model = {1.f, 50.f, 1.f, 343.f, 1.f};
+
+    double minTime = bench_minTimeNs();
+    u64 iterations = 0;
+    u64 start = bench_nowNs();
+    u64 elapsed = 0;
+    do
+    {
+        for (u32 i = 0; i < 64; i++)
+        {
+            // Move the emitters a bit every update, like a game frame.
+            for (u32 j = 0; j < emitterCount; j++)
+                data[j] += 0.05f;
+            cwavSpatialUpdate(&listener, &model, &emitters);
+        }
+        iterations += 64;
+        elapsed = bench_nowNs() - start;
+    } while (elapsed < minTime);
+
+    printf("{\"suite\":\"spatial\",\"emitters\":%u,\"live_voices\":%u,\"iterations\":%llu,\"ns_per_update\":%.1f,\"ns_per_emitter\":%.1f}\n",
+        emitterCount, emitterCount < 24 ? emitterCount : 24, (unsigned long long)iterations, (double)elapsed / iterations, (double)elapsed / iterations / emitterCount);
+
+    free(channels);
+    free(data);
+    bench_freeSound(&sound);
+}
+
+// Aux bus effect chain run by the simulated ndsp aux callback, on silence (the kernels do not depend on the input).
+static void bench_effects(const char* name, const cwavEffect* effects, u32 count)
+{
+    if (!cwavEffectsSetChain(0, effects, count))
+    {
+        printf("{\"suite\":\"effects\",\"chain\":\"%s\",\"success\":false}\n", name);
+        return;
+    }
+
+    double minTime = bench_minTimeNs();
+    u64 frames = 0;
+    u64 start = bench_nowNs();
+    u64 elapsed = 0;
+    do
+    {
+        hostSimAdvanceFrames(64);
+        frames += 64;
+        elapsed = bench_nowNs() - start;
+    } while (elapsed < minTime);
+    cwavEffectsSetChain(0, NULL, 0);
+
+    double nsPerFrame = (double)elapsed / frames;
+    double frameNs = HOST_SIM_DSP_FRAME_TICKS * 1e9 / SYSCLOCK_ARM11;
+    printf("{\"suite\":\"effects\",\"chain\":\"%s\",\"success\":true,\"frames\":%llu,\"ns_per_frame\":%.1f,\"realtime_load\":%.4f}\n",
+        name, (unsigned long long)frames, nsPerFrame, nsPerFrame / frameNs);
+}
+
+static int bench_writeCorpus(const char* directory)
+{
+    static const u32 sizes[] = {1024, 32768, 1048576};
+    for (u32 encoding = CWAV_ENCODING_PCM8; encoding <= CWAV_ENCODING_IMA_ADPCM; encoding++)
+    {
+        for (u32 s = 0; s < sizeof(sizes) / sizeof(u32); s++)
+        {
+            for (u32 channels = 1; channels <= 2; channels++)
+            {
+                char path[512];
+                u32 fileSize = 0;
+                u8* file = corpusMakeCwav(encoding, channels, sizes[s], s & 1, BENCH_SAMPLE_RATE, &fileSize);
+                snprintf(path, sizeof(path), "%s/%s_%uch_%u%s.bcwav", directory, corpusEncodingName(encoding), channels, sizes[s], (s & 1) ? "_loop" : "");
+                FILE* out = fopen(path, "wb");
+                if (!out || fwrite(file, 1, fileSize, out) != fileSize)
+                {
+                    fprintf(stderr, "Failed to write %s\n", path);
+                    return 1;
+                }
+                fclose(out);
+                linearFree(file);
+            }
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 2 && !strcmp(argv[1], "--write-corpus"))
+        return bench_writeCorpus(argv[2]);
+
+    static const u32 loadSizes[] = {1024, 32768, 1048576};
+
+    // Parse throughput, DSP compatible encodings.
+    cwavUseEnvironment(CWAV_ENV_DSP);
+    for (u32 encoding = CWAV_ENCODING_PCM8; encoding <= CWAV_ENCODING_DSP_ADPCM; encoding++)
+    {
+        for (u32 s = 0; s < sizeof(loadSizes) / sizeof(u32); s++)
+        {
+            bench_load(encoding, 1, loadSizes[s]);
+            bench_load(encoding, 2, loadSizes[s]);
+        }
+    }
+
+    static const u32 registeredAmounts[] = {1, 64, 400};
+    static const u32 busyAmounts[] = {0, 12, 23};
+    for (u32 r = 0; r < sizeof(registeredAmounts) / sizeof(u32); r++)
+    {
+        for (u32 b = 0; b < sizeof(busyAmounts) / sizeof(u32); b++)
+            bench_play(CWAV_ENCODING_DSP_ADPCM, registeredAmounts[r], busyAmounts[b]);
+        bench_status(registeredAmounts[r], 22);
+        bench_churn(registeredAmounts[r]);
+    }
+
+    for (u32 encoding = CWAV_ENCODING_PCM8; encoding <= CWAV_ENCODING_IMA_ADPCM; encoding++)
+        bench_inspect(encoding, 2, 32768);
+
+    bench_simulate(3600);
+    bench_spatial(24);
+    bench_spatial(256);
+
+    static const cwavEffect lowpass = {CWAV_EFFECT_LOWPASS, 3000.f, 0.f, 0.f, 0.f, 0.f, 1.f};
+    static const cwavEffect biquad = {CWAV_EFFECT_BIQUAD_HIGHPASS, 400.f, 0.7071f, 0.f, 0.f, 0.f, 1.f};
+    static const cwavEffect delay = {CWAV_EFFECT_DELAY, 0.f, 0.f, 250.f, 0.4f, 0.f, 1.f};
+    static const cwavEffect reverb = {CWAV_EFFECT_REVERB, 0.f, 0.f, 0.f, 0.7f, 0.5f, 1.f};
+    const cwavEffect chain[] = {biquad, delay, lowpass, reverb};
+    bench_effects("lowpass", &lowpass, 1);
+    bench_effects("biquad", &biquad, 1);
+    bench_effects("delay", &delay, 1);
+    bench_effects("reverb", &reverb, 1);
+    bench_effects("biquad+delay+lowpass+reverb", chain, 4);
+
+    static const u16 mixerFormats[] = {NDSP_FORMAT_PCM16, NDSP_FORMAT_ADPCM};
+    static const u32 mixerVoices[] = {1, 24, 64, 128};
+    for (u32 f = 0; f < sizeof(mixerFormats) / sizeof(u16); f++)
+    {
+        for (u32 interp = NDSP_INTERP_POLYPHASE; interp <= NDSP_INTERP_LINEAR; interp++)
+        {
+            for (u32 v = 0; v < sizeof(mixerVoices) / sizeof(u32); v++)
+                bench_mixer(mixerFormats[f], interp, mixerVoices[v]);
+        }
+    }
+
+    // IMA ADPCM can only be loaded when using CSND.
+    cwavUseEnvironment(CWAV_ENV_CSND);
+    for (u32 s = 0; s < sizeof(loadSizes) / sizeof(u32); s++)
+    {
+        bench_load(CWAV_ENCODING_IMA_ADPCM, 1, loadSizes[s]);
+        bench_load(CWAV_ENCODING_IMA_ADPCM, 2, loadSizes[s]);
+    }
+    bench_play(CWAV_ENCODING_IMA_ADPCM, 64, 16);
+    return 0;
+}
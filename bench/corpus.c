@@ -0,0 +1,148 @@
+#include "corpus.h"
+#include "internal/cwav_defs.h"
+#include <math.h>
+#include <string.h>
+
+#define CORPUS_ALIGN(x, a) (((x) + (a) - 1) & ~((a) - 1))
+
+static u32 g_corpusSeed = 0x12345678;
+
+static u32 corpus_random()
+{
+    g_corpusSeed = g_corpusSeed * 1664525 + 1013904223;
+    return g_corpusSeed >> 8;
+}
+
+static u32 corpus_channelDataSize(cwavAudioEncoding_t encoding, u32 samples)
+{
+    switch (encoding)
+    {
+    case CWAV_ENCODING_PCM8:
+        return samples;
+    case CWAV_ENCODING_PCM16:
+        return samples * 2;
+    case CWAV_ENCODING_DSP_ADPCM:
+        return ((samples + 13) / 14) * 8;
+    case CWAV_ENCODING_IMA_ADPCM:
+        return (samples + 1) / 2;
+    }
+    return 0;
+}
+
+static void corpus_fillSamples(cwavAudioEncoding_t encoding, u8* data, u32 samples, u32 channel)
+{
+    float step = 2.f * 3.14159265f * (220.f * (channel + 1)) / 32728.f;
+    switch (encoding)
+    {
+    case CWAV_ENCODING_PCM8:
+        for (u32 i = 0; i < samples; i++)
+            ((s8*)data)[i] = (s8)(sinf(step * i) * 100.f) + (s8)(corpus_random() % 8);
+        break;
+    case CWAV_ENCODING_PCM16:
+        for (u32 i = 0; i < samples; i++)
+        {
+            s16 sample = (s16)(sinf(step * i) * 20000.f) + (s16)(corpus_random() % 512);
+            memcpy(data + i * 2, &sample, sizeof(s16));
+        }
+        break;
+    case CWAV_ENCODING_DSP_ADPCM:
+        // Each 8 byte frame starts with the predictor (0-7) and scale (0-11) header.
+        for (u32 i = 0; i < corpus_channelDataSize(encoding, samples); i++)
+            data[i] = (i % 8) ? (u8)corpus_random() : (u8)(((corpus_random() % 8) << 4) | (corpus_random() % 12));
+        break;
+    case CWAV_ENCODING_IMA_ADPCM:
+        for (u32 i = 0; i < corpus_channelDataSize(encoding, samples); i++)
+            data[i] = (u8)corpus_random();
+        break;
+    }
+}
+
+u8* corpusMakeCwav(cwavAudioEncoding_t encoding, u32 channels, u32 samples, bool looped, u32 sampleRate, u32* outSize)
+{
+    bool dspAdpcm = encoding == CWAV_ENCODING_DSP_ADPCM;
+    bool imaAdpcm = encoding == CWAV_ENCODING_IMA_ADPCM;
+    u32 adpcmInfoSize = dspAdpcm ? sizeof(cwavDSPADPCMInfo_t) : (imaAdpcm ? sizeof(cwavIMAADPCMInfo_t) : 0);
+    u32 channelDataSize = corpus_channelDataSize(encoding, samples);
+
+    // INFO: block header and fields, reference table, channel infos and ADPCM infos.
+    u32 refTableOffset = offsetof(cwavInfoBlock_t, channelInfoRefs);
+    u32 channelInfosOffset = refTableOffset + sizeof(u32) + channels * sizeof(cwavReference_t);
+    u32 adpcmInfosOffset = channelInfosOffset + channels * sizeof(cwavchannelInfo_t);
+    u32 infoOffset = 0x40;
+    u32 infoSize = CORPUS_ALIGN(adpcmInfosOffset + channels * CORPUS_ALIGN(adpcmInfoSize, 4), 0x20);
+
+    u32 dataOffset = infoOffset + infoSize;
+    u32 channelStride = CORPUS_ALIGN(channelDataSize, 0x20);
+    u32 dataSize = 0x20 + channels * channelStride;
+    u32 fileSize = dataOffset + dataSize;
+
+    u8* file = linearAlloc(fileSize);
+    if (!file)
+        return NULL;
+    memset(file, 0, fileSize);
+
+    cwavHeader_t* header = (cwavHeader_t*)file;
+    header->magic = 0x56415743;
+    header->endian = 0xFEFF;
+    header->headerS = 0x40;
+    header->version = 0x02010000;
+    header->fileSize = fileSize;
+    header->blockCount = 2;
+    header->info_blck.ref.refType = INFO_BLOCK;
+    header->info_blck.ref.offset = infoOffset;
+    header->info_blck.size = infoSize;
+    header->data_blck.ref.refType = DATA_BLOCK;
+    header->data_blck.ref.offset = dataOffset;
+    header->data_blck.size = dataSize;
+
+    u8* infoBase = file + infoOffset;
+    cwavInfoBlock_t* info = (cwavInfoBlock_t*)infoBase;
+    info->header.magic = 0x4F464E49;
+    info->header.size = infoSize;
+    info->encoding = encoding;
+    info->isLooped = looped;
+    info->sampleRate = sampleRate;
+    info->loopStart = looped ? samples / 4 : 0;
+    info->LoopEnd = samples;
+    info->channelInfoRefs.count = channels;
+
+    u8* dataBase = file + dataOffset;
+    ((cwavBlockHeader_t*)dataBase)->magic = 0x41544144;
+    ((cwavBlockHeader_t*)dataBase)->size = dataSize;
+
+    for (u32 i = 0; i < channels; i++)
+    {
+        u32 channelInfoOffset = channelInfosOffset + i * sizeof(cwavchannelInfo_t);
+        info->channelInfoRefs.references[i].refType = CHANNEL_INFO;
+        info->channelInfoRefs.references[i].offset = channelInfoOffset - refTableOffset;
+
+        cwavchannelInfo_t* channelInfo = (cwavchannelInfo_t*)(infoBase + channelInfoOffset);
+        u32 sampleOffset = 0x18 + i * channelStride; // Relative to the DATA block header end, keeps the samples 0x20 aligned.
+        channelInfo->samples.refType = SAMPLE_DATA;
+        channelInfo->samples.offset = sampleOffset;
+        corpus_fillSamples(encoding, dataBase + 8 + sampleOffset, samples, i);
+
+        if (!adpcmInfoSize)
+            continue;
+        u32 adpcmOffset = adpcmInfosOffset + i * CORPUS_ALIGN(adpcmInfoSize, 4);
+        channelInfo->ADPCMInfo.refType = dspAdpcm ? DSP_ADPCM_INFO : IMA_ADPCM_INFO;
+        channelInfo->ADPCMInfo.offset = adpcmOffset - channelInfoOffset;
+        if (dspAdpcm)
+        {
+            cwavDSPADPCMInfo_t* adpcmInfo = (cwavDSPADPCMInfo_t*)(infoBase + adpcmOffset);
+            for (u32 j = 0; j < 16; j++)
+                adpcmInfo->param.coefs[j] = (u16)((j & 1) ? -(s16)(corpus_random() % 2048) : (s16)(corpus_random() % 4096));
+            adpcmInfo->context.predScale = dataBase[8 + sampleOffset];
+            adpcmInfo->loopContext.predScale = dataBase[8 + sampleOffset + (info->loopStart / 14) * 8];
+        }
+    }
+
+    *outSize = fileSize;
+    return file;
+}
+
+const char* corpusEncodingName(cwavAudioEncoding_t encoding)
+{
+    static const char* const names[] = {"PCM8", "PCM16", "DSP_ADPCM", "IMA_ADPCM"};
+    return encoding <= CWAV_ENCODING_IMA_ADPCM ? names[encoding] : "UNKNOWN";
+}
@@ -0,0 +1,11 @@
+#ifndef BENCH_CORPUS_H
+#define BENCH_CORPUS_H
+#include "cwav.h"
+
+// Builds a valid bcwav file in linear memory with synthetic sample data.
+// The returned buffer must be freed with linearFree.
+u8* corpusMakeCwav(cwavAudioEncoding_t encoding, u32 channels, u32 samples, bool looped, u32 sampleRate, u32* outSize);
+
+const char* corpusEncodingName(cwavAudioEncoding_t encoding);
+
+#endif
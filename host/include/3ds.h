@@ -0,0 +1,125 @@
+/**
+ * @file 3ds.h
+ * @brief Host stand-in for the subset of libctru used by libcwav.
+ * 
+ * Only meant to build libcwav with the host compiler for benchmarks and tests.
+ * The declarations match libctru, the implementations are in host/source.
+ * The DSP and the system tick are simulated, see host_sim.h.
+*/
+#pragma once
+#include "3ds/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SYSCLOCK_ARM11 268111856
+#define CPU_TICKS_PER_MSEC (SYSCLOCK_ARM11 / 1000.0)
+
+#define CUR_THREAD_HANDLE 0xFFFF8000
+#define CUR_PROCESS_HANDLE 0xFFFF8001
+
+#define AtomicPostIncrement(ptr) __atomic_fetch_add((u32*)(ptr), 1, __ATOMIC_SEQ_CST)
+
+// Memory
+void* linearAlloc(size_t size);
+void linearFree(void* mem);
+u32 osConvertVirtToPhys(const void* vaddr);
+
+// Kernel
+u64 svcGetSystemTick(void);
+Result svcGetThreadPriority(s32* out, Handle handle);
+Result svcFlushProcessDataCache(Handle process, u32 addr, u32 size);
+void svcSleepThread(s64 ns);
+
+// Threads
+typedef struct Thread_tag* Thread;
+typedef void (*ThreadFunc)(void*);
+Thread threadCreate(ThreadFunc entrypoint, void* arg, size_t stack_size, int prio, int core_id, bool detached);
+Result threadJoin(Thread thread, u64 timeout_ns);
+void threadFree(Thread thread);
+
+// DSP
+enum
+{
+    NDSP_WBUF_FREE = 0,
+    NDSP_WBUF_QUEUED = 1,
+    NDSP_WBUF_PLAYING = 2,
+    NDSP_WBUF_DONE = 3,
+};
+
+#define NDSP_ENCODING_PCM8 0
+#define NDSP_ENCODING_PCM16 1
+#define NDSP_ENCODING_ADPCM 2
+#define NDSP_CHANNELS(n) ((u32)(n) & 3)
+#define NDSP_ENCODING(n) (((u32)(n) & 3) << 2)
+
+enum
+{
+    NDSP_FORMAT_MONO_PCM8 = NDSP_CHANNELS(1) | NDSP_ENCODING(NDSP_ENCODING_PCM8),
+    NDSP_FORMAT_MONO_PCM16 = NDSP_CHANNELS(1) | NDSP_ENCODING(NDSP_ENCODING_PCM16),
+    NDSP_FORMAT_MONO_ADPCM = NDSP_CHANNELS(1) | NDSP_ENCODING(NDSP_ENCODING_ADPCM),
+    NDSP_FORMAT_PCM8 = NDSP_FORMAT_MONO_PCM8,
+    NDSP_FORMAT_PCM16 = NDSP_FORMAT_MONO_PCM16,
+    NDSP_FORMAT_ADPCM = NDSP_FORMAT_MONO_ADPCM,
+};
+
+typedef enum
+{
+    NDSP_INTERP_POLYPHASE = 0,
+    NDSP_INTERP_LINEAR = 1,
+    NDSP_INTERP_NONE = 2,
+} ndspInterpType;
+
+typedef struct
+{
+    u16 index;
+    s16 history0;
+    s16 history1;
+} ndspAdpcmData;
+
+typedef struct tag_ndspWaveBuf ndspWaveBuf;
+
+struct tag_ndspWaveBuf
+{
+    union
+    {
+        s8* data_pcm8;
+        s16* data_pcm16;
+        u8* data_adpcm;
+        u32 data_paddr;
+        void* data_vaddr;
+    };
+    u32 nsamples;
+    ndspAdpcmData* adpcm_data;
+    u32 offset;
+    bool looping;
+    u8 status;
+    u16 sequence_id;
+    ndspWaveBuf* next;
+};
+
+typedef void (*ndspCallback)(void* data);
+typedef void (*ndspAuxCallback)(void* data, int nsamples, void* samples[4]);
+
+void ndspSetCallback(ndspCallback callback, void* data);
+void ndspAuxSetEnable(int id, bool enable);
+void ndspAuxSetVolume(int id, float volume);
+void ndspAuxSetCallback(int id, ndspAuxCallback callback, void* data);
+void ndspChnReset(int id);
+bool ndspChnIsPlaying(int id);
+u32 ndspChnGetSamplePos(int id);
+u16 ndspChnGetWaveBufSeq(int id);
+bool ndspChnIsPaused(int id);
+void ndspChnSetPaused(int id, bool paused);
+void ndspChnSetFormat(int id, u16 format);
+void ndspChnSetRate(int id, float rate);
+void ndspChnSetInterp(int id, ndspInterpType type);
+void ndspChnSetMix(int id, float mix[12]);
+void ndspChnSetAdpcmCoefs(int id, u16 coefs[16]);
+void ndspChnWaveBufClear(int id);
+void ndspChnWaveBufAdd(int id, ndspWaveBuf* buf);
+
+#ifdef __cplusplus
+}
+#endif
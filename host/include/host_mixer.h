@@ -0,0 +1,99 @@
+/**
+ * @file host_mixer.h
+ * @brief Software mixer used by the host DSP simulator.
+ * 
+ * Each voice plays a queue of ndspWaveBuf like a DSP channel: PCM8, PCM16 and DSP ADPCM
+ * are decoded, resampled to the DSP output rate (no interpolation, linear or 4 tap polyphase)
+ * and accumulated into three quad buses (main, aux 0 and aux 1) with the 12 entry
+ * matrix of ndspChnSetMix(). The buses are floating point, so any amount of voices can be
+ * mixed without clipping before the final conversion.
+ * 
+ * Voices are not limited to the 24 DSP channels, hostMixerRender() mixes any amount of them.
+ * The bus accumulation and the polyphase filter use SSE or NEON when available.
+ * 
+ * This is not a libcwav environment: the library only reaches the mixer through the host ndsp
+ * stand-in (CWAV_ENV_DSP linked against the host directory, as cwavrender does). On the 3DS
+ * the DSP does the mixing.
+*/
+#pragma once
+#include "3ds.h"
+#include "host_sim.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Mix buses: main output, aux 0 and aux 1, each with front left, front right, back left and back right.
+#define HOST_MIXER_BUSES 3
+
+/// Quad mix bus of one DSP frame.
+typedef float hostMixerBus[HOST_SIM_DSP_FRAME_SAMPLES][4];
+
+/// Software voice, equivalent to one DSP channel.
+typedef struct hostMixerVoice_s
+{
+    ndspWaveBuf* waveBufs; ///< Wave buffer queue, the first one is the current one.
+    u16 format; ///< NDSP_FORMAT_* value.
+    u8 interp; ///< ndspInterpType value.
+    bool paused; ///< Paused voices keep their position and wave buffers.
+    u64 step; ///< 32.32 fixed point position increment per output sample.
+    u64 position; ///< 32.32 fixed point position inside the current wave buffer.
+    float mix[12]; ///< Mix matrix, same layout as ndspChnSetMix().
+    s16 adpcmCoefs[16];
+
+    // DSP ADPCM decoder state.
+    u32 decodedCount;
+    u8 adpcmPs;
+    s16 adpcmHist1;
+    s16 adpcmHist2;
+    s16 decoded[4]; ///< Last decoded samples, indexed by sample index & 3.
+} hostMixerVoice;
+
+/**
+ * @brief Resets a voice to the default state (no wave buffers, PCM16, linear interpolation, 1:1 rate, left/right mix).
+*/
+void hostMixerVoiceReset(hostMixerVoice* voice);
+
+/**
+ * @brief Sets the sample rate of a voice, like ndspChnSetRate().
+*/
+void hostMixerVoiceSetRate(hostMixerVoice* voice, float rate);
+
+/**
+ * @brief Adds a wave buffer at the end of the queue of a voice.
+*/
+void hostMixerVoiceQueue(hostMixerVoice* voice, ndspWaveBuf* buf);
+
+/**
+ * @brief Marks all the queued wave buffers as free and empties the queue.
+*/
+void hostMixerVoiceClear(hostMixerVoice* voice);
+
+/**
+ * @brief Advances a voice by a DSP frame without rendering it.
+ * @return Whether the voice still has wave buffers queued.
+*/
+bool hostMixerVoiceAdvance(hostMixerVoice* voice);
+
+/**
+ * @brief Renders a DSP frame of a voice and accumulates it into the buses.
+ * @return Whether the voice still has wave buffers queued.
+*/
+bool hostMixerVoiceRender(hostMixerVoice* voice, hostMixerBus* buses);
+
+/**
+ * @brief Renders a DSP frame of several voices.
+ * @param voices Voices to render, voices without wave buffers are skipped.
+ * @param count Amount of voices.
+ * @param buses HOST_MIXER_BUSES buses, cleared before mixing.
+*/
+void hostMixerRender(hostMixerVoice* voices, u32 count, hostMixerBus* buses);
+
+/**
+ * @brief Converts the main bus to interleaved stereo samples, folding the back channels into the front ones.
+*/
+void hostMixerBusToStereo(const hostMixerBus* bus, s16* out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,108 @@
+/**
+ * @file host_sim.h
+ * @brief Control of the host ndsp/ncsnd simulator.
+ * 
+ * The host stand-ins of libctru and libncsnd simulate the DSP and CSND playback
+ * state on a virtual clock, so the results only depend on the calls made and
+ * never on the host speed. The clock only moves when advanced with the functions below,
+ * svcGetSystemTick() returns its current value.
+ * 
+ * DSP: the channels are processed every frame of HOST_SIM_DSP_FRAME_SAMPLES output samples,
+ * like the real DSP. On each frame the first wave buffer of a channel goes from
+ * NDSP_WBUF_QUEUED to NDSP_WBUF_PLAYING, then the channel consumes samples at its rate.
+ * Finished wave buffers become NDSP_WBUF_DONE and the next queued one continues in the
+ * same frame, looping wave buffers restart and stay NDSP_WBUF_PLAYING.
+ * The callback set with ndspSetCallback() is called after every frame.
+ * When an output callback is set, every frame is also rendered: samples are linearly
+ * interpolated at the channel rate, PCM8/PCM16/DSP ADPCM are decoded and the channel
+ * mix (ndspChnSetMix()) is applied, with the back channels folded into the front ones.
+ * Aux buses enabled with ndspAuxSetEnable() are passed to their ndspAuxSetCallback() callback
+ * as s32 samples and mixed back into the output with their ndspAuxSetVolume() volume, disabled
+ * aux buses are dropped. Aux callbacks run every frame even when the output is not rendered.
+ * 
+ * CSND: sounds play at their sample rate from the tick they were started, looped sounds
+ * restart at their loop point and non looped sounds stop after their last sample.
+ * Only the channels set in ncsndChannels can be used.
+*/
+#pragma once
+#include "3ds.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Output samples processed by the DSP every frame.
+#define HOST_SIM_DSP_FRAME_SAMPLES 160
+/// Ticks per DSP output sample (the DSP sample rate is SYSCLOCK_ARM11 / 8192, around 32728Hz).
+#define HOST_SIM_DSP_TICKS_PER_SAMPLE 8192
+/// Ticks per DSP frame.
+#define HOST_SIM_DSP_FRAME_TICKS (HOST_SIM_DSP_FRAME_SAMPLES * HOST_SIM_DSP_TICKS_PER_SAMPLE)
+/// Number of DSP channels.
+#define HOST_SIM_DSP_CHANNELS 24
+
+/**
+ * @brief Called after each DSP frame with the rendered output.
+ * @param samples Interleaved stereo samples.
+ * @param count Amount of stereo samples (HOST_SIM_DSP_FRAME_SAMPLES).
+ * @param userData User data passed to hostSimSetOutputCallback().
+*/
+typedef void (*hostSimOutputCallback)(const s16* samples, u32 count, void* userData);
+
+/**
+ * @brief Resets the virtual clock to 0, stops all the DSP and CSND channels and restores ncsndChannels.
+*/
+void hostSimReset();
+
+/**
+ * @brief Returns the current value of the virtual clock, in ticks.
+*/
+u64 hostSimGetTick();
+
+/**
+ * @brief Returns the amount of DSP frames processed since the last reset.
+*/
+u64 hostSimGetFrameCount();
+
+/**
+ * @brief Advances the virtual clock, processing all the DSP frames that end in that period.
+ * @param ticks Amount of ticks to advance (SYSCLOCK_ARM11 ticks are one second).
+*/
+void hostSimAdvanceTicks(u64 ticks);
+
+/**
+ * @brief Advances the virtual clock by the specified amount of DSP frames.
+ * @param frames Amount of frames to process.
+*/
+void hostSimAdvanceFrames(u64 frames);
+
+/**
+ * @brief Advances the virtual clock by the specified amount of milliseconds.
+ * @param ms Amount of milliseconds to advance.
+*/
+void hostSimAdvanceMs(u64 ms);
+
+/**
+ * @brief Enables rendering of the DSP output (disabled after a reset).
+ * @param callback Function to call with every rendered frame, or NULL to disable rendering.
+ * @param userData Value passed to the callback.
+*/
+void hostSimSetOutputCallback(hostSimOutputCallback callback, void* userData);
+
+/**
+ * @brief Sets the interpolation of the DSP channels when they are reset (NDSP_INTERP_LINEAR by default).
+*/
+void hostSimSetDefaultInterp(ndspInterpType type);
+
+/**
+ * @brief Returns a bitmask of the DSP channels that have wave buffers queued or playing.
+*/
+u32 hostSimGetNdspActiveChannels();
+
+/**
+ * @brief Returns a bitmask of the CSND channels that are playing at the current tick.
+*/
+u32 hostSimGetCsndActiveChannels();
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,90 @@
+/**
+ * @file ncsnd.h
+ * @brief Host stand-in for the subset of libncsnd used by libcwav.
+ * 
+ * The CSND channels are simulated, see host_sim.h.
+*/
+#pragma once
+#include "3ds/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NCSND_NUM_CHANNELS 32
+
+enum
+{
+    NCSND_ENCODING_PCM8 = 0,
+    NCSND_ENCODING_PCM16 = 1,
+    NCSND_ENCODING_ADPCM = 2,
+    NCSND_ENCODING_PSG = 3,
+};
+
+extern u32 ncsndChannels;
+
+typedef struct
+{
+    u16 data;
+    u8 tableIndex;
+    u8 padding;
+} ncsndADPCMContext;
+
+typedef struct
+{
+    bool isPhysAddr;
+    void* sampleData;
+    void* loopSampleData;
+    u32 totalSizeBytes;
+    u32 encoding;
+    bool loopPlayback;
+    ncsndADPCMContext context;
+    ncsndADPCMContext loopContext;
+    float volume;
+    float pitch;
+    float pan;
+    u32 sampleRate;
+    bool linearInterpolation;
+} ncsndSound;
+
+typedef struct
+{
+    float speedMultiplier;
+    s32 channelVolumes[2];
+    u8 unknown0;
+    u8 playOnSleep;
+    u8 ignoreVolumeSlider;
+    u8 forceSpeakerOutput;
+} ncsndDirectSoundModifiers;
+
+typedef struct
+{
+    u8 channelAmount;
+    u8 channelEncoding;
+    u32 sampleRate;
+    u32 sampleDataLength;
+    bool isLeftPhys;
+    void* leftSampleData;
+    ncsndADPCMContext leftAdpcmContext;
+    bool isRightPhys;
+    void* rightSampleData;
+    ncsndADPCMContext rightAdpcmContext;
+} ncsndDirectSoundChannelData;
+
+typedef struct
+{
+    u8 always0;
+    ncsndDirectSoundChannelData channelData;
+    ncsndDirectSoundModifiers soundModifiers;
+} ncsndDirectSound;
+
+void ncsndInitializeSound(ncsndSound* sound);
+Result ncsndPlaySound(u32 chn, ncsndSound* sound);
+void ncsndStopSound(u32 chn);
+bool ncsndIsPlaying(u32 chn);
+void ncsndInitializeDirectSound(ncsndDirectSound* sound);
+Result ncsndPlayDirectSound(u32 chnIndex, u32 prio, ncsndDirectSound* sound);
+
+#ifdef __cplusplus
+}
+#endif
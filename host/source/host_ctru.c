@@ -0,0 +1,81 @@
+// Host implementation of the libctru subset declared in host/include/3ds.h
+// The DSP and svcGetSystemTick are part of the simulator (host_ndsp.c, host_sim.c).
+#include "3ds.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#define HOST_LINEAR_ALIGNMENT 0x80
+
+void* linearAlloc(size_t size)
+{
+    size = (size + HOST_LINEAR_ALIGNMENT - 1) & ~(size_t)(HOST_LINEAR_ALIGNMENT - 1);
+    return aligned_alloc(HOST_LINEAR_ALIGNMENT, size ? size : HOST_LINEAR_ALIGNMENT);
+}
+
+void linearFree(void* mem)
+{
+    free(mem);
+}
+
+u32 osConvertVirtToPhys(const void* vaddr)
+{
+    return (u32)(uintptr_t)vaddr;
+}
+
+Result svcGetThreadPriority(s32* out, Handle handle)
+{
+    *out = 0x30;
+    return 0;
+}
+
+Result svcFlushProcessDataCache(Handle process, u32 addr, u32 size)
+{
+    return 0;
+}
+
+void svcSleepThread(s64 ns)
+{
+    struct timespec ts = { ns / 1000000000, ns % 1000000000 };
+    nanosleep(&ts, NULL);
+}
+
+struct Thread_tag
+{
+    pthread_t thread;
+    ThreadFunc entrypoint;
+    void* arg;
+};
+
+static void* host_threadEntry(void* arg)
+{
+    Thread thread = (Thread)arg;
+    thread->entrypoint(thread->arg);
+    return NULL;
+}
+
+Thread threadCreate(ThreadFunc entrypoint, void* arg, size_t stack_size, int prio, int core_id, bool detached)
+{
+    Thread thread = malloc(sizeof(struct Thread_tag));
+    if (!thread)
+        return NULL;
+    thread->entrypoint = entrypoint;
+    thread->arg = arg;
+    if (pthread_create(&thread->thread, NULL, host_threadEntry, thread))
+    {
+        free(thread);
+        return NULL;
+    }
+    return thread;
+}
+
+Result threadJoin(Thread thread, u64 timeout_ns)
+{
+    return pthread_join(thread->thread, NULL) ? -1 : 0;
+}
+
+void threadFree(Thread thread)
+{
+    free(thread);
+}
@@ -0,0 +1,311 @@
+// Software mixer used by the host DSP simulator, see host/include/host_mixer.h
+#include "host_mixer.h"
+#include <string.h>
+#include <math.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define HOST_MIXER_SSE
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define HOST_MIXER_NEON
+#endif
+
+#define HOST_MIXER_POS_SHIFT 32
+#define HOST_MIXER_PHASE_BITS 6
+#define HOST_MIXER_PHASES (1 << HOST_MIXER_PHASE_BITS)
+
+// 4 tap windowed sinc filter for each phase, taps are applied to samples i - 1 to i + 2.
+static float g_hostMixerPolyphase[HOST_MIXER_PHASES][4];
+static bool g_hostMixerPolyphaseReady = false;
+
+static void host_mixerInitPolyphase()
+{
+    for (int p = 0; p < HOST_MIXER_PHASES; p++)
+    {
+        double t = (double)p / HOST_MIXER_PHASES;
+        double sum = 0;
+        double taps[4];
+        for (int k = 0; k < 4; k++)
+        {
+            double x = (k - 1) - t;
+            double sinc = x == 0 ? 1.0 : sin(M_PI * x) / (M_PI * x);
+            double window = 0.5 * (1.0 + cos(M_PI * x / 2.0));
+            taps[k] = sinc * window;
+            sum += taps[k];
+        }
+        for (int k = 0; k < 4; k++)
+            g_hostMixerPolyphase[p][k] = (float)(taps[k] / sum);
+    }
+    g_hostMixerPolyphaseReady = true;
+}
+
+void hostMixerVoiceReset(hostMixerVoice* voice)
+{
+    memset(voice, 0, sizeof(hostMixerVoice));
+    voice->format = NDSP_FORMAT_PCM16;
+    voice->interp = NDSP_INTERP_LINEAR;
+    voice->step = 1ULL << HOST_MIXER_POS_SHIFT;
+    voice->mix[0] = voice->mix[1] = 1.f;
+}
+
+void hostMixerVoiceSetRate(hostMixerVoice* voice, float rate)
+{
+    double step = (double)rate * HOST_SIM_DSP_TICKS_PER_SAMPLE / SYSCLOCK_ARM11;
+    voice->step = step > 0 ? (u64)(step * (double)(1ULL << HOST_MIXER_POS_SHIFT)) : 0;
+}
+
+void hostMixerVoiceQueue(hostMixerVoice* voice, ndspWaveBuf* buf)
+{
+    buf->status = NDSP_WBUF_QUEUED;
+    buf->next = NULL;
+    ndspWaveBuf** last = &voice->waveBufs;
+    while (*last)
+        last = &(*last)->next;
+    *last = buf;
+}
+
+void hostMixerVoiceClear(hostMixerVoice* voice)
+{
+    for (ndspWaveBuf* buf = voice->waveBufs; buf; buf = buf->next)
+        buf->status = NDSP_WBUF_FREE;
+    voice->waveBufs = NULL;
+    voice->position = 0;
+}
+
+// Called when a wave buffer starts from its beginning, including every loop of a looping buffer.
+static void host_mixerStartWaveBuf(hostMixerVoice* voice, ndspWaveBuf* buf)
+{
+    buf->status = NDSP_WBUF_PLAYING;
+    voice->decodedCount = 0;
+    if (buf->adpcm_data)
+    {
+        voice->adpcmPs = (u8)buf->adpcm_data->index;
+        voice->adpcmHist1 = buf->adpcm_data->history0;
+        voice->adpcmHist2 = buf->adpcm_data->history1;
+    }
+}
+
+// Moves to the next wave buffer once the position is past the end of the current one.
+// Returns false when there is nothing else to play.
+static bool host_mixerHandleEnd(hostMixerVoice* voice)
+{
+    while (voice->waveBufs)
+    {
+        ndspWaveBuf* buf = voice->waveBufs;
+        u64 end = (u64)buf->nsamples << HOST_MIXER_POS_SHIFT;
+        if (voice->position < end)
+            return true;
+
+        if (buf->looping && buf->nsamples)
+        {
+            voice->position %= end;
+            host_mixerStartWaveBuf(voice, buf);
+            return true;
+        }
+
+        voice->position -= end;
+        buf->status = NDSP_WBUF_DONE;
+        voice->waveBufs = buf->next;
+        if (voice->waveBufs)
+            host_mixerStartWaveBuf(voice, voice->waveBufs);
+    }
+    voice->position = 0;
+    return false;
+}
+
+bool hostMixerVoiceAdvance(hostMixerVoice* voice)
+{
+    if (!voice->waveBufs)
+        return false;
+    if (voice->paused)
+        return true;
+    if (voice->waveBufs->status == NDSP_WBUF_QUEUED)
+        host_mixerStartWaveBuf(voice, voice->waveBufs);
+    voice->position += voice->step * HOST_SIM_DSP_FRAME_SAMPLES;
+    return host_mixerHandleEnd(voice);
+}
+
+static void host_mixerDecodeAdpcm(hostMixerVoice* voice, const u8* data)
+{
+    u32 index = voice->decodedCount++;
+    const u8* frame = data + (index / 14) * 8;
+    if (index % 14 == 0)
+        voice->adpcmPs = frame[0];
+
+    u8 byte = frame[1 + (index % 14) / 2];
+    s32 nibble = (index & 1) ? (byte & 0xF) : (byte >> 4);
+    if (nibble >= 8)
+        nibble -= 16;
+
+    s32 predictor = (voice->adpcmPs >> 4) & 7;
+    s32 sample = (nibble * (1 << (voice->adpcmPs & 0xF))) << 11;
+    sample += 1024 + voice->adpcmCoefs[predictor * 2] * voice->adpcmHist1 + voice->adpcmCoefs[predictor * 2 + 1] * voice->adpcmHist2;
+    sample >>= 11;
+    if (sample > 0x7FFF)
+        sample = 0x7FFF;
+    else if (sample < -0x8000)
+        sample = -0x8000;
+
+    voice->adpcmHist2 = voice->adpcmHist1;
+    voice->adpcmHist1 = (s16)sample;
+    voice->decoded[index & 3] = (s16)sample;
+}
+
+// Returns sample index of the current wave buffer, ADPCM samples must have been decoded up to last.
+static inline s32 host_mixerSample(hostMixerVoice* voice, ndspWaveBuf* buf, u32 index)
+{
+    switch ((voice->format >> 2) & 3)
+    {
+    case NDSP_ENCODING_PCM8:
+        return buf->data_pcm8[index] * 256;
+    case NDSP_ENCODING_PCM16:
+        return buf->data_pcm16[index];
+    case NDSP_ENCODING_ADPCM:
+        return voice->decoded[index & 3];
+    default:
+        return 0;
+    }
+}
+
+static inline float host_mixerPolyphase(const s32* samples, u32 phase)
+{
+    const float* taps = g_hostMixerPolyphase[phase];
+#if defined(HOST_MIXER_SSE)
+    __m128 v = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)samples)), _mm_loadu_ps(taps));
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    return _mm_cvtss_f32(_mm_add_ss(v, _mm_shuffle_ps(v, v, 1)));
+#elif defined(HOST_MIXER_NEON)
+    float32x4_t v = vmulq_f32(vcvtq_f32_s32(vld1q_s32(samples)), vld1q_f32(taps));
+    float32x2_t half = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpadd_f32(half, half), 0);
+#else
+    float v[4];
+    for (int k = 0; k < 4; k++)
+        v[k] = (float)samples[k] * taps[k];
+    return (v[0] + v[2]) + (v[1] + v[3]);
+#endif
+}
+
+// Resamples up to one DSP frame of the voice, returns the amount of samples written.
+static u32 host_mixerResample(hostMixerVoice* voice, float* out)
+{
+    if (voice->waveBufs->status == NDSP_WBUF_QUEUED)
+        host_mixerStartWaveBuf(voice, voice->waveBufs);
+
+    bool isAdpcm = ((voice->format >> 2) & 3) == NDSP_ENCODING_ADPCM;
+    for (u32 i = 0; i < HOST_SIM_DSP_FRAME_SAMPLES; i++)
+    {
+        ndspWaveBuf* buf = voice->waveBufs;
+        u32 last = buf->nsamples - 1;
+        u32 index = (u32)(voice->position >> HOST_MIXER_POS_SHIFT);
+        u32 frac = (u32)(voice->position >> (HOST_MIXER_POS_SHIFT - 16)) & 0xFFFF;
+
+        switch (voice->interp)
+        {
+        case NDSP_INTERP_NONE:
+            if (isAdpcm)
+            {
+                while (voice->decodedCount <= index)
+                    host_mixerDecodeAdpcm(voice, buf->data_adpcm);
+            }
+            out[i] = (float)host_mixerSample(voice, buf, index);
+            break;
+        case NDSP_INTERP_POLYPHASE:
+        {
+            // The edges of the wave buffer are repeated.
+            u32 next = index + 1 < last ? index + 1 : last;
+            u32 next2 = index + 2 < last ? index + 2 : last;
+            if (isAdpcm)
+            {
+                while (voice->decodedCount <= next2)
+                    host_mixerDecodeAdpcm(voice, buf->data_adpcm);
+            }
+            s32 samples[4];
+            samples[0] = host_mixerSample(voice, buf, index ? index - 1 : 0);
+            samples[1] = host_mixerSample(voice, buf, index);
+            samples[2] = host_mixerSample(voice, buf, next);
+            samples[3] = host_mixerSample(voice, buf, next2);
+            out[i] = host_mixerPolyphase(samples, frac >> (16 - HOST_MIXER_PHASE_BITS));
+            break;
+        }
+        default:
+        {
+            u32 next = index < last ? index + 1 : index;
+            if (isAdpcm)
+            {
+                while (voice->decodedCount <= next)
+                    host_mixerDecodeAdpcm(voice, buf->data_adpcm);
+            }
+            s32 s0 = host_mixerSample(voice, buf, index);
+            s32 s1 = host_mixerSample(voice, buf, next);
+            out[i] = (float)(s0 + (((s1 - s0) * (s32)frac) >> 16));
+            break;
+        }
+        }
+
+        voice->position += voice->step;
+        if (!host_mixerHandleEnd(voice))
+            return i + 1;
+    }
+    return HOST_SIM_DSP_FRAME_SAMPLES;
+}
+
+static void host_mixerAccumulate(hostMixerBus bus, const float* samples, u32 count, const float* gains)
+{
+#if defined(HOST_MIXER_SSE)
+    __m128 g = _mm_loadu_ps(gains);
+    for (u32 i = 0; i < count; i++)
+        _mm_storeu_ps(bus[i], _mm_add_ps(_mm_loadu_ps(bus[i]), _mm_mul_ps(_mm_set1_ps(samples[i]), g)));
+#elif defined(HOST_MIXER_NEON)
+    float32x4_t g = vld1q_f32(gains);
+    for (u32 i = 0; i < count; i++)
+        vst1q_f32(bus[i], vaddq_f32(vld1q_f32(bus[i]), vmulq_f32(vdupq_n_f32(samples[i]), g)));
+#else
+    for (u32 i = 0; i < count; i++)
+    {
+        for (int j = 0; j < 4; j++)
+            bus[i][j] += samples[i] * gains[j];
+    }
+#endif
+}
+
+bool hostMixerVoiceRender(hostMixerVoice* voice, hostMixerBus* buses)
+{
+    if (!voice->waveBufs)
+        return false;
+    if (voice->paused)
+        return true;
+    if (voice->interp == NDSP_INTERP_POLYPHASE && !g_hostMixerPolyphaseReady)
+        host_mixerInitPolyphase();
+
+    float samples[HOST_SIM_DSP_FRAME_SAMPLES];
+    u32 count = host_mixerResample(voice, samples);
+
+    for (int b = 0; b < HOST_MIXER_BUSES; b++)
+    {
+        const float* gains = &voice->mix[b * 4];
+        if (gains[0] != 0.f || gains[1] != 0.f || gains[2] != 0.f || gains[3] != 0.f)
+            host_mixerAccumulate(buses[b], samples, count, gains);
+    }
+    return voice->waveBufs != NULL;
+}
+
+void hostMixerRender(hostMixerVoice* voices, u32 count, hostMixerBus* buses)
+{
+    memset(buses, 0, sizeof(hostMixerBus) * HOST_MIXER_BUSES);
+    for (u32 i = 0; i < count; i++)
+        hostMixerVoiceRender(&voices[i], buses);
+}
+
+void hostMixerBusToStereo(const hostMixerBus* bus, s16* out)
+{
+    for (u32 i = 0; i < HOST_SIM_DSP_FRAME_SAMPLES; i++)
+    {
+        for (int j = 0; j < 2; j++)
+        {
+            float value = (*bus)[i][j] + (*bus)[i][j + 2];
+            out[i * 2 + j] = value >= 32767.f ? 32767 : value <= -32768.f ? -32768 : (s16)lrintf(value);
+        }
+    }
+}
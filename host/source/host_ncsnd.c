@@ -0,0 +1,118 @@
+// CSND part of the host simulator, see host/include/host_sim.h
+#include "ncsnd.h"
+#include "3ds.h"
+#include "host_sim.h"
+#include "host_sim_internal.h"
+#include <string.h>
+
+#define HOST_CSND_DEFAULT_CHANNELS 0xFFFFFF00
+
+// Same channels as a regular application gets from the CSND service.
+u32 ncsndChannels = HOST_CSND_DEFAULT_CHANNELS;
+
+typedef struct hostCsndChannel_s
+{
+    bool active;
+    bool looped;
+    u64 startTick;
+    double rate;
+    u64 totalSamples;
+    u64 loopStartSample;
+} hostCsndChannel_t;
+
+static hostCsndChannel_t g_hostCsndChannels[NCSND_NUM_CHANNELS];
+
+void hostCsndReset()
+{
+    memset(g_hostCsndChannels, 0, sizeof(g_hostCsndChannels));
+    ncsndChannels = HOST_CSND_DEFAULT_CHANNELS;
+}
+
+static bool host_csndIsPlaying(u32 chn, u64 tick)
+{
+    hostCsndChannel_t* channel = &g_hostCsndChannels[chn];
+    if (!channel->active)
+        return false;
+    if (channel->looped && channel->loopStartSample < channel->totalSamples)
+        return true;
+
+    double elapsedSamples = (double)(tick - channel->startTick) * channel->rate / SYSCLOCK_ARM11;
+    if (elapsedSamples < (double)channel->totalSamples)
+        return true;
+
+    channel->active = false;
+    return false;
+}
+
+u32 hostCsndGetActiveChannels(u64 tick)
+{
+    u32 mask = 0;
+    for (u32 i = 0; i < NCSND_NUM_CHANNELS; i++)
+    {
+        if (host_csndIsPlaying(i, tick))
+            mask |= 1u << i;
+    }
+    return mask;
+}
+
+static u64 host_csndBytesToSamples(u32 encoding, u64 bytes)
+{
+    switch (encoding)
+    {
+    case NCSND_ENCODING_PCM8:
+        return bytes;
+    case NCSND_ENCODING_PCM16:
+        return bytes / 2;
+    case NCSND_ENCODING_ADPCM:
+        return bytes * 2;
+    default:
+        return 0;
+    }
+}
+
+void ncsndInitializeSound(ncsndSound* sound)
+{
+    memset(sound, 0, sizeof(ncsndSound));
+    sound->volume = 1.f;
+    sound->pitch = 1.f;
+}
+
+Result ncsndPlaySound(u32 chn, ncsndSound* sound)
+{
+    if (chn >= NCSND_NUM_CHANNELS || !((ncsndChannels >> chn) & 1))
+        return -1;
+
+    hostCsndChannel_t* channel = &g_hostCsndChannels[chn];
+    channel->startTick = hostSimGetTick();
+    channel->rate = (double)sound->sampleRate * sound->pitch;
+    channel->totalSamples = host_csndBytesToSamples(sound->encoding, sound->totalSizeBytes);
+    channel->looped = sound->loopPlayback;
+    channel->loopStartSample = 0;
+    if (sound->loopPlayback && sound->loopSampleData)
+        channel->loopStartSample = host_csndBytesToSamples(sound->encoding, (u8*)sound->loopSampleData - (u8*)sound->sampleData);
+    channel->active = channel->totalSamples && channel->rate > 0;
+    return 0;
+}
+
+void ncsndStopSound(u32 chn)
+{
+    if (chn < NCSND_NUM_CHANNELS)
+        g_hostCsndChannels[chn].active = false;
+}
+
+bool ncsndIsPlaying(u32 chn)
+{
+    return chn < NCSND_NUM_CHANNELS && host_csndIsPlaying(chn, hostSimGetTick());
+}
+
+void ncsndInitializeDirectSound(ncsndDirectSound* sound)
+{
+    memset(sound, 0, sizeof(ncsndDirectSound));
+    sound->soundModifiers.speedMultiplier = 1.f;
+    sound->soundModifiers.channelVolumes[0] = sound->soundModifiers.channelVolumes[1] = 32768;
+}
+
+Result ncsndPlayDirectSound(u32 chnIndex, u32 prio, ncsndDirectSound* sound)
+{
+    return chnIndex < 4 ? 0 : -1;
+}
@@ -0,0 +1,262 @@
+// DSP part of the host simulator, see host/include/host_sim.h
+// The channels are software voices of the host mixer (host_mixer.c).
+#include "3ds.h"
+#include "host_sim.h"
+#include "host_mixer.h"
+#include "host_sim_internal.h"
+#include <string.h>
+#include <math.h>
+
+typedef struct hostNdspChannel_s
+{
+    hostMixerVoice voice;
+    u16 sequenceId;
+} hostNdspChannel_t;
+
+typedef struct hostNdspAux_s
+{
+    bool enabled;
+    float volume;
+    ndspAuxCallback callback;
+    void* data;
+} hostNdspAux_t;
+
+static hostNdspChannel_t g_hostNdspChannels[HOST_SIM_DSP_CHANNELS];
+static u32 g_hostNdspActiveChannels = 0;
+static ndspCallback g_hostNdspCallback = NULL;
+static void* g_hostNdspCallbackData = NULL;
+static hostSimOutputCallback g_hostNdspOutputCallback = NULL;
+static void* g_hostNdspOutputData = NULL;
+static ndspInterpType g_hostNdspDefaultInterp = NDSP_INTERP_LINEAR;
+static hostNdspAux_t g_hostNdspAux[2];
+
+static void host_ndspResetChannel(int id)
+{
+    g_hostNdspChannels[id].sequenceId = 0;
+    hostMixerVoiceReset(&g_hostNdspChannels[id].voice);
+    g_hostNdspChannels[id].voice.interp = g_hostNdspDefaultInterp;
+}
+
+void hostNdspReset()
+{
+    g_hostNdspDefaultInterp = NDSP_INTERP_LINEAR;
+    for (int i = 0; i < HOST_SIM_DSP_CHANNELS; i++)
+        host_ndspResetChannel(i);
+    g_hostNdspActiveChannels = 0;
+    g_hostNdspCallback = NULL;
+    g_hostNdspCallbackData = NULL;
+    g_hostNdspOutputCallback = NULL;
+    g_hostNdspOutputData = NULL;
+    for (int i = 0; i < 2; i++)
+    {
+        g_hostNdspAux[i].enabled = false;
+        g_hostNdspAux[i].volume = 1.f;
+        g_hostNdspAux[i].callback = NULL;
+        g_hostNdspAux[i].data = NULL;
+    }
+}
+
+u32 hostNdspGetActiveChannels()
+{
+    return g_hostNdspActiveChannels;
+}
+
+static inline bool host_ndspAuxHasCallback(int id)
+{
+    return g_hostNdspAux[id].enabled && g_hostNdspAux[id].callback;
+}
+
+bool hostNdspNeedsFrames()
+{
+    return g_hostNdspActiveChannels || g_hostNdspCallback || g_hostNdspOutputCallback ||
+        host_ndspAuxHasCallback(0) || host_ndspAuxHasCallback(1);
+}
+
+// Runs the callback of an aux bus on its s32 samples (one array per output, like the DSP intermediate buffers).
+static void host_ndspRunAuxCallback(int id, hostMixerBus bus)
+{
+    s32 planar[4][HOST_SIM_DSP_FRAME_SAMPLES];
+    void* samples[4] = { planar[0], planar[1], planar[2], planar[3] };
+    for (u32 i = 0; i < HOST_SIM_DSP_FRAME_SAMPLES; i++)
+    {
+        for (int j = 0; j < 4; j++)
+            planar[j][i] = (s32)lrintf(bus[i][j]);
+    }
+
+    g_hostNdspAux[id].callback(g_hostNdspAux[id].data, HOST_SIM_DSP_FRAME_SAMPLES, samples);
+
+    for (u32 i = 0; i < HOST_SIM_DSP_FRAME_SAMPLES; i++)
+    {
+        for (int j = 0; j < 4; j++)
+            bus[i][j] = (float)planar[j][i];
+    }
+}
+
+void hostSimSetOutputCallback(hostSimOutputCallback callback, void* userData)
+{
+    g_hostNdspOutputCallback = callback;
+    g_hostNdspOutputData = userData;
+}
+
+void hostSimSetDefaultInterp(ndspInterpType type)
+{
+    g_hostNdspDefaultInterp = type;
+    for (int i = 0; i < HOST_SIM_DSP_CHANNELS; i++)
+    {
+        if (!((g_hostNdspActiveChannels >> i) & 1))
+            g_hostNdspChannels[i].voice.interp = type;
+    }
+}
+
+void hostNdspRunFrame()
+{
+    if (g_hostNdspOutputCallback)
+    {
+        hostMixerBus buses[HOST_MIXER_BUSES];
+        s16 out[HOST_SIM_DSP_FRAME_SAMPLES * 2];
+        memset(buses, 0, sizeof(buses));
+
+        u32 active = g_hostNdspActiveChannels;
+        for (int i = 0; active; i++, active >>= 1)
+        {
+            if ((active & 1) && !hostMixerVoiceRender(&g_hostNdspChannels[i].voice, buses))
+                g_hostNdspActiveChannels &= ~(1u << i);
+        }
+
+        // Enabled aux buses go through their callback and are mixed back into the main output.
+        for (int b = 0; b < 2; b++)
+        {
+            if (!g_hostNdspAux[b].enabled)
+                continue;
+            if (g_hostNdspAux[b].callback)
+                host_ndspRunAuxCallback(b, buses[b + 1]);
+            float volume = g_hostNdspAux[b].volume;
+            for (u32 i = 0; i < HOST_SIM_DSP_FRAME_SAMPLES; i++)
+            {
+                for (int j = 0; j < 4; j++)
+                    buses[0][i][j] += buses[b + 1][i][j] * volume;
+            }
+        }
+
+        hostMixerBusToStereo(&buses[0], out);
+        g_hostNdspOutputCallback(out, HOST_SIM_DSP_FRAME_SAMPLES, g_hostNdspOutputData);
+    }
+    else
+    {
+        u32 active = g_hostNdspActiveChannels;
+        for (int i = 0; active; i++, active >>= 1)
+        {
+            if ((active & 1) && !hostMixerVoiceAdvance(&g_hostNdspChannels[i].voice))
+                g_hostNdspActiveChannels &= ~(1u << i);
+        }
+
+        // Without rendering, the aux callbacks still run every frame, on silence.
+        for (int b = 0; b < 2; b++)
+        {
+            if (host_ndspAuxHasCallback(b))
+            {
+                hostMixerBus bus;
+                memset(bus, 0, sizeof(bus));
+                host_ndspRunAuxCallback(b, bus);
+            }
+        }
+    }
+
+    if (g_hostNdspCallback)
+        g_hostNdspCallback(g_hostNdspCallbackData);
+}
+
+void ndspSetCallback(ndspCallback callback, void* data)
+{
+    g_hostNdspCallback = callback;
+    g_hostNdspCallbackData = data;
+}
+
+void ndspAuxSetEnable(int id, bool enable)
+{
+    g_hostNdspAux[id].enabled = enable;
+}
+
+void ndspAuxSetVolume(int id, float volume)
+{
+    g_hostNdspAux[id].volume = volume;
+}
+
+void ndspAuxSetCallback(int id, ndspAuxCallback callback, void* data)
+{
+    g_hostNdspAux[id].callback = callback;
+    g_hostNdspAux[id].data = data;
+}
+
+void ndspChnReset(int id)
+{
+    ndspChnWaveBufClear(id);
+    host_ndspResetChannel(id);
+}
+
+bool ndspChnIsPlaying(int id)
+{
+    return (g_hostNdspActiveChannels >> id) & 1;
+}
+
+u32 ndspChnGetSamplePos(int id)
+{
+    return (u32)(g_hostNdspChannels[id].voice.position >> 32);
+}
+
+u16 ndspChnGetWaveBufSeq(int id)
+{
+    ndspWaveBuf* buf = g_hostNdspChannels[id].voice.waveBufs;
+    return buf && buf->status == NDSP_WBUF_PLAYING ? buf->sequence_id : 0;
+}
+
+bool ndspChnIsPaused(int id)
+{
+    return g_hostNdspChannels[id].voice.paused;
+}
+
+void ndspChnSetPaused(int id, bool paused)
+{
+    g_hostNdspChannels[id].voice.paused = paused;
+}
+
+void ndspChnSetFormat(int id, u16 format)
+{
+    g_hostNdspChannels[id].voice.format = format;
+}
+
+void ndspChnSetInterp(int id, ndspInterpType type)
+{
+    g_hostNdspChannels[id].voice.interp = type;
+}
+
+void ndspChnSetRate(int id, float rate)
+{
+    hostMixerVoiceSetRate(&g_hostNdspChannels[id].voice, rate);
+}
+
+void ndspChnSetMix(int id, float mix[12])
+{
+    memcpy(g_hostNdspChannels[id].voice.mix, mix, sizeof(float) * 12);
+}
+
+void ndspChnSetAdpcmCoefs(int id, u16 coefs[16])
+{
+    memcpy(g_hostNdspChannels[id].voice.adpcmCoefs, coefs, sizeof(u16) * 16);
+}
+
+void ndspChnWaveBufClear(int id)
+{
+    hostMixerVoiceClear(&g_hostNdspChannels[id].voice);
+    g_hostNdspActiveChannels &= ~(1u << id);
+}
+
+void ndspChnWaveBufAdd(int id, ndspWaveBuf* buf)
+{
+    hostNdspChannel_t* chn = &g_hostNdspChannels[id];
+    buf->sequence_id = ++chn->sequenceId;
+    if (!buf->sequence_id)
+        buf->sequence_id = ++chn->sequenceId;
+    hostMixerVoiceQueue(&chn->voice, buf);
+    g_hostNdspActiveChannels |= 1u << id;
+}
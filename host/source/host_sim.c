@@ -0,0 +1,72 @@
+// Virtual clock driving the host ndsp/ncsnd simulator, see host/include/host_sim.h
+#include "host_sim.h"
+#include "host_sim_internal.h"
+#include "3ds.h"
+
+static u64 g_hostSimTick = 0;
+static u64 g_hostSimFrameCount = 0;
+
+void hostSimReset()
+{
+    g_hostSimTick = 0;
+    g_hostSimFrameCount = 0;
+    hostNdspReset();
+    hostCsndReset();
+}
+
+u64 hostSimGetTick()
+{
+    return g_hostSimTick;
+}
+
+u64 svcGetSystemTick(void)
+{
+    return g_hostSimTick;
+}
+
+u64 hostSimGetFrameCount()
+{
+    return g_hostSimFrameCount;
+}
+
+void hostSimAdvanceTicks(u64 ticks)
+{
+    u64 target = g_hostSimTick + ticks;
+    u64 nextFrameTick = (g_hostSimFrameCount + 1) * HOST_SIM_DSP_FRAME_TICKS;
+
+    while (nextFrameTick <= target)
+    {
+        // Nothing can change while the DSP is idle, so the idle frames are skipped at once.
+        if (!hostNdspNeedsFrames())
+        {
+            g_hostSimFrameCount = target / HOST_SIM_DSP_FRAME_TICKS;
+            break;
+        }
+
+        g_hostSimTick = nextFrameTick;
+        g_hostSimFrameCount++;
+        hostNdspRunFrame();
+        nextFrameTick += HOST_SIM_DSP_FRAME_TICKS;
+    }
+    g_hostSimTick = target;
+}
+
+void hostSimAdvanceFrames(u64 frames)
+{
+    hostSimAdvanceTicks((g_hostSimFrameCount + frames) * HOST_SIM_DSP_FRAME_TICKS - g_hostSimTick);
+}
+
+void hostSimAdvanceMs(u64 ms)
+{
+    hostSimAdvanceTicks(ms * SYSCLOCK_ARM11 / 1000);
+}
+
+u32 hostSimGetNdspActiveChannels()
+{
+    return hostNdspGetActiveChannels();
+}
+
+u32 hostSimGetCsndActiveChannels()
+{
+    return hostCsndGetActiveChannels(g_hostSimTick);
+}
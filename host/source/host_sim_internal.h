@@ -0,0 +1,11 @@
+// Shared between the host simulator sources, not part of the host API.
+#pragma once
+#include "3ds/types.h"
+
+void hostNdspReset();
+void hostNdspRunFrame();
+u32 hostNdspGetActiveChannels();
+bool hostNdspNeedsFrames();
+
+void hostCsndReset();
+u32 hostCsndGetActiveChannels(u64 tick);
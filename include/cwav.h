@@ -36,6 +36,29 @@ typedef enum
 
 } cwavStatus_t;
 
+/// Amount of CSND direct sound channels.
+#define CWAV_DIRECT_SOUND_CHANNELS 4
+/// Maximum amount of direct sounds waiting for a channel.
+#define CWAV_DIRECT_SOUND_QUEUE_SIZE 8
+
+/// Results of cwavDirectSoundPlay.
+typedef enum
+{
+    CWAV_DIRECT_SOUND_FAILED = 0, ///< The sound could not be played nor queued.
+    CWAV_DIRECT_SOUND_PLAYING = 1, ///< The sound is playing.
+    CWAV_DIRECT_SOUND_QUEUED = 2 ///< The sound waits for a direct sound channel.
+} cwavDirectSoundStatus_t;
+
+/// Samples per value of the level envelopes, see cwavEnableLevelEnvelopes.
+#define CWAV_LEVEL_BLOCK_SAMPLES 512
+
+/// Level of a playing voice, relative to the full scale of the samples.
+typedef struct cwavLevel_s
+{
+    float peak; ///< Peak level of the current block.
+    float rms;  ///< RMS level of the current block.
+} cwavLevel;
+
 /// Possible environments.
 typedef enum
 {
@@ -43,6 +66,113 @@ typedef enum
     CWAV_ENV_CSND = 1 // CSND Service, only available for applets and 3GX plugins.
 } cwavEnvMode_t;
 
+/// Possible audio encodings.
+typedef enum
+{
+    CWAV_ENCODING_PCM8 = 0, ///< 8 bit PCM.
+    CWAV_ENCODING_PCM16 = 1, ///< 16 bit PCM.
+    CWAV_ENCODING_DSP_ADPCM = 2, ///< DSP ADPCM, transcoded to IMA ADPCM the first time it is played while using CSND.
+    CWAV_ENCODING_IMA_ADPCM = 3 ///< IMA ADPCM, only playable with CSND.
+} cwavAudioEncoding_t;
+
+/// Sound categories, each one with its own volume, mute, pause and ducking state.
+typedef enum
+{
+    CWAV_CATEGORY_SFX = 0, ///< Sound effects (default).
+    CWAV_CATEGORY_VOICE = 1, ///< Voices and dialogue.
+    CWAV_CATEGORY_MUSIC = 2, ///< Music.
+    CWAV_CATEGORY_UI = 3, ///< User interface sounds.
+    CWAV_CATEGORY_COUNT = 4 ///< Amount of categories.
+} cwavCategory_t;
+
+/// Listener used by cwavSpatialUpdate.
+typedef struct cwavListener_s
+{
+    float position[3];  ///< Position of the listener.
+    float velocity[3];  ///< Velocity of the listener in units per second, used for Doppler.
+    float right[3];     ///< Unit vector pointing to the right ear.
+    float forward[3];   ///< Unit vector pointing to the front.
+} cwavListener;
+
+/// Distance attenuation and Doppler settings used by cwavSpatialUpdate.
+typedef struct cwavSpatialModel_s
+{
+    float minDistance;  ///< Distance under which the volume is not attenuated (should be >0).
+    float maxDistance;  ///< Distance from which the volume is not attenuated further.
+    float rolloff;      ///< Inverse distance rolloff factor, 1.0 halves the volume each time the distance doubles.
+    float speedOfSound; ///< Speed of sound in units per second. 0.0 disables Doppler.
+    float doppler;      ///< Doppler effect multiplier, 1.0 for a physical effect.
+} cwavSpatialModel;
+
+/// Emitters in structure-of-arrays form, all the arrays must have count elements.
+typedef struct cwavEmitters_s
+{
+    u32             count;      ///< Amount of emitters.
+    const float*    x;          ///< X positions.
+    const float*    y;          ///< Y positions.
+    const float*    z;          ///< Z positions.
+    const float*    vx;         ///< X velocities in units per second. The velocity arrays can be NULL for static emitters.
+    const float*    vy;         ///< Y velocities.
+    const float*    vz;         ///< Z velocities.
+    const s8*       channels;   ///< DSP/CSND channel each emitter plays on (e.g: cwavPlayResult monoLeftChannel), -1 for none.
+    float*          gains;      ///< [Out] Optional (can be NULL), count * 4 gains: front left, front right, back left and back right.
+    float*          pitch;      ///< [Out] Optional (can be NULL), Doppler pitch multipliers.
+} cwavEmitters;
+
+/// Maximum amount of effects in the chain of an aux bus.
+#define CWAV_EFFECTS_MAX_CHAIN 8
+/// Maximum delay time of CWAV_EFFECT_DELAY, in milliseconds.
+#define CWAV_EFFECTS_MAX_DELAY_MS 2000
+
+/// Effects that can be applied to the DSP aux buses, see cwavEffectsSetChain.
+typedef enum cwavEffectType_e
+{
+    CWAV_EFFECT_LOWPASS = 0,            ///< One pole low pass filter (frequency).
+    CWAV_EFFECT_BIQUAD_LOWPASS = 1,     ///< Biquad low pass filter (frequency, q).
+    CWAV_EFFECT_BIQUAD_HIGHPASS = 2,    ///< Biquad high pass filter (frequency, q).
+    CWAV_EFFECT_DELAY = 3,              ///< Feedback delay (timeMs, feedback, wet).
+    CWAV_EFFECT_REVERB = 4,             ///< Schroeder reverb (feedback as the room size, damping, wet).
+} cwavEffectType_t;
+
+/// Effect of an aux bus chain, only the values used by the effect type are read.
+typedef struct cwavEffect_s
+{
+    cwavEffectType_t    type;       ///< Value from the cwavEffectType_t enum.
+    float               frequency;  ///< Cutoff frequency of the filters, in Hz.
+    float               q;          ///< Quality factor of the biquad filters (0.7071 for no resonance).
+    float               timeMs;     ///< Delay time, in milliseconds. Range (0-CWAV_EFFECTS_MAX_DELAY_MS].
+    float               feedback;   ///< Delay feedback or reverb room size. Range [0-1).
+    float               damping;    ///< High frequency damping of the reverb. Range [0-1].
+    float               wet;        ///< Level of the delayed or reverberated signal, the input keeps 1 - wet. Range [0-1].
+} cwavEffect;
+
+/// CPU usage of an aux bus effect chain, returned by cwavEffectsGetStats.
+typedef struct cwavEffectsStats_s
+{
+    u32     frames;         ///< DSP frames processed since the chain was set.
+    u32     lastTicks;      ///< CPU ticks used by the last frame.
+    u32     peakTicks;      ///< Most CPU ticks used by a single frame.
+    float   averageLoad;    ///< Average processing time of a frame, as a fraction of the DSP frame duration.
+    float   peakLoad;       ///< peakTicks as a fraction of the DSP frame duration.
+} cwavEffectsStats;
+
+/// Information returned by cwavInspect.
+typedef struct cwavInfo_s
+{
+    cwavAudioEncoding_t encoding;           ///< Audio encoding of the sample data.
+    u8                  numChannels;        ///< Number of CWAV channels stored in the file.
+    u8                  isLooped;           ///< Whether the file is looped or not.
+    u32                 sampleRate;         ///< The sample rate of the audio data.
+    u32                 loopStart;          ///< Loop start position, in samples.
+    u32                 loopEnd;            ///< Loop end position (or total length if not looped), in samples.
+    float               duration;           ///< Duration of the audio data until the loop end, in seconds.
+    u32                 linearMemorySize;   ///< Linear memory needed to load the file, in bytes.
+    u32                 sampleDataSize;     ///< Size of the sample data of all the channels, in bytes.
+    u32                 heapMemorySize;     ///< Heap memory allocated by cwavLoad, in bytes (without the per play memory, with the level envelope if enabled).
+    u32                 heapMemoryPerPlay;  ///< Heap memory allocated by cwavLoad for each simultaneous play (maxSPlays), in bytes.
+    u32                 csndMemorySize;     ///< Linear memory allocated the first time the file is played with CSND (IMA ADPCM copy of DSP ADPCM files), in bytes.
+} cwavInfo;
+
 /// Information returned by cwavPlay.
 typedef struct cwavPlayResult_s
 {
@@ -63,11 +193,137 @@ typedef struct CWAV_s
     u32             sampleRate;     ///< [R] The sample rate of the audio data.
     u8              numChannels;    ///< [R] Number of CWAV channels stored in the file.
     u8              isLooped;       ///< [R] Whether the file is looped or not.
+    u8              category;       ///< [RW] Value from the cwavCategory_t enum, applied to the next plays. Default: CWAV_CATEGORY_SFX
 } CWAV;
 
+/// Timed play event for cwavSequencerSubmit.
+typedef struct cwavSeqEvent_s
+{
+    u64     samplePosition; ///< Sample clock position at which the sound starts (see cwavGetSampleClock).
+    CWAV*   cwav;           ///< The CWAV to play. Its volume, pan, pitch and category are read when the event is committed.
+    s8      leftChannel;    ///< The CWAV channel to play on the left ear.
+    s8      rightChannel;   ///< The CWAV channel to play on the right ear, -1 to play leftChannel in mono.
+} cwavSeqEvent;
+
+/// Maximum length of a region name, including the null terminator.
+#define CWAV_REGION_NAME_SIZE 32
+
+/// Sample range of a CWAV for cwavAddRegion.
+typedef struct cwavRegion_s
+{
+    u32     start;      ///< First sample of the region.
+    u32     end;        ///< Sample after the last sample of the region, up to the end of the CWAV samples.
+    bool    isLooped;   ///< Whether the region loops from loopStart to end.
+    u32     loopStart;  ///< First sample of the loop, between start and end. Ignored if the region is not looped.
+} cwavRegion;
+
+/// Amount of segment players.
+#define CWAV_SEGMENT_PLAYERS 4
+
+/// Shortest part of a segment queued at once, in samples of the CWAV.
+#define CWAV_SEGMENT_MIN_SAMPLES 1024
+
+/// When a segment queued with cwavSegmentQueue starts.
+typedef enum
+{
+    CWAV_SEGMENT_AT_END = 0,    ///< At the end of the current segment, or of the current loop of a looped segment.
+    CWAV_SEGMENT_AT_BEAT = 1    ///< At the next beat of the current segment, see cwavSegmentPlay.
+} cwavSegmentTransition_t;
+
+/// Amount of stem groups.
+#define CWAV_STEM_GROUPS 4
+
+/// Maximum amount of layers in a stem group.
+#define CWAV_STEM_MAX_LAYERS 8
+
+/// Layer of a stem group for cwavStemPlay.
+typedef struct cwavStemLayer_s
+{
+    CWAV*   cwav;           ///< The CWAV to play. Its volume, pan, pitch and category are used like with cwavPlay.
+    s8      leftChannel;    ///< The CWAV channel to play on the left ear.
+    s8      rightChannel;   ///< The CWAV channel to play on the right ear, -1 to play leftChannel in mono.
+    float   volume;         ///< Initial layer volume. Layers at 0.0 keep playing silently, so they can be faded in.
+} cwavStemLayer;
+
+/// Runtime statistics returned by cwavGetStats. Tick values are in system ticks (SYSCLOCK_ARM11).
+typedef struct cwavStats_s
+{
+    u32 playsRequested;         ///< Amount of cwavPlay calls.
+    u32 playsSucceeded;         ///< Amount of cwavPlay calls that succeeded.
+    u32 playsFailedNoChannel;   ///< Amount of cwavPlay calls that failed with CWAV_NO_CHANNEL_AVAILABLE.
+    u32 voicesStolen;           ///< Amount of still playing voices stopped to reuse a simultaneous play slot (maxSPlays).
+    u32 activeVoices;           ///< Amount of voices playing, as of the last cwavPlay call.
+    u32 peakVoices;             ///< Maximum amount of voices playing at the same time.
+    u32 registeredCwavs;        ///< Amount of CWAVs currently loaded.
+    u32 sampleBytes;            ///< Size of the sample data of the loaded CWAVs, in bytes (deduplicated data counted once).
+    u32 metadataBytes;          ///< Heap memory used by the loaded CWAVs, in bytes.
+    u32 loads;                  ///< Amount of cwavLoad calls (including file loads).
+    u32 channelStateSkips;      ///< Amount of DSP channel settings (format, rate, mix and ADPCM coefficients) not sent again by plays because they did not change.
+    u64 playTicks;              ///< Time spent in cwavPlay.
+    u64 updateTicks;            ///< Time spent updating the playing status of the loaded CWAVs.
+    u64 loadTicks;              ///< Time spent parsing CWAVs in cwavLoad.
+    u64 fileReadTicks;          ///< Time spent reading files in the file load functions.
+} cwavStats;
+
+/// Types of the events recorded by the event trace.
+typedef enum
+{
+    CWAV_TRACE_LOAD = 0, ///< cwavLoad call. channels: unused.
+    CWAV_TRACE_PLAY = 1, ///< cwavPlay call. channels: assigned DSP/CSND channels.
+    CWAV_TRACE_STOP = 2, ///< cwavStop call. channels: CWAV channels to stop.
+    CWAV_TRACE_VOICE_END = 3, ///< A voice was found to have finished playing. channels[0]: DSP/CSND channel.
+    CWAV_TRACE_ENV_PLAY = 4, ///< A voice was started in the environment. channels[0]: DSP/CSND channel.
+    CWAV_TRACE_ENV_STOP = 5, ///< A voice was stopped in the environment. channels[0]: DSP/CSND channel.
+} cwavTraceEventType_t;
+
+/// Event recorded by the event trace.
+typedef struct cwavTraceEvent_s
+{
+    u64         tick;           ///< System tick when the event started.
+    u32         duration;       ///< Duration of the event in system ticks, 0 for instant events.
+    const void* cwav;           ///< CWAV the event belongs to, or NULL.
+    u8          type;           ///< Value from the cwavTraceEventType_t enum.
+    u8          status;         ///< Value from the cwavStatus_t enum, for the events that return a status.
+    s8          channels[2];    ///< Channels involved in the event (depends on the type), -1 if not used.
+} cwavTraceEvent;
+
+/// Play latency report returned by cwavLatencyGetReport. Latencies are in microseconds.
+typedef struct cwavLatencyReport_s
+{
+    u32         samples;        ///< Amount of voices measured.
+    u32         minUs;          ///< Minimum latency.
+    u32         maxUs;          ///< Maximum latency.
+    u32         p50Us;          ///< Median latency (upper bound of the histogram bucket).
+    u32         p99Us;          ///< 99th percentile latency (upper bound of the histogram bucket).
+    u32         bucketUs;       ///< Width of each histogram bucket.
+    u32         bucketCount;    ///< Amount of histogram buckets, the last one also counts all the bigger latencies.
+    const u32*  histogram;      ///< Amount of voices measured in each bucket. Valid until the next cwavLatencyReset or cwavLatencyStart.
+    bool        approximate;    ///< True for CSND, which does not report the play position: the latencies are rounded up to the cwavLatencyUpdate calls.
+} cwavLatencyReport;
+
 /// vAddr to pAddr conversion callback definition.
 typedef u32(*vaToPaCallback_t)(const void*);
 
+/// Linear memory allocator used for the buffers allocated by the library.
+typedef struct cwavAllocator_s
+{
+    void*   (*alloc)(void* userData, size_t size);  ///< Allocates size bytes of linear memory, returns NULL on failure.
+    void    (*free)(void* userData, void* mem);     ///< Frees a buffer returned by alloc.
+    void*   userData;                               ///< User pointer passed to the callbacks.
+} cwavAllocator;
+
+/// Amount of size classes used by cwavArena free lists.
+#define CWAV_ARENA_SIZE_CLASSES 16
+
+/// Built-in linear memory arena, the struct members should not be used.
+typedef struct cwavArena_s
+{
+    u8*     base;
+    size_t  size;
+    size_t  top;
+    void*   freeLists[CWAV_ARENA_SIZE_CLASSES];
+} cwavArena;
+
 /**
  * @brief Sets the environment that libcwav will use.
  * 
@@ -86,6 +342,93 @@ void cwavUseEnvironment(cwavEnvMode_t envMode);
 */
 void cwavSetVAToPACallback(vaToPaCallback_t callback);
 
+/**
+ * @brief Sets the ndsp frame callback of the application (only available if using DSP).
+ * @param callback Function called after every DSP frame, NULL to remove it.
+ * @param data Value passed to the callback.
+ * @return Whether the callback was set or not.
+ * 
+ * The scheduler, segment players, stems and the latency measurement run from the ndsp frame callback, so
+ * applications using them must set their own frame callback with this function instead of ndspSetCallback,
+ * which would replace the libcwav one. The application callback runs after the libcwav ones.
+*/
+bool cwavSetFrameCallback(ndspCallback callback, void* data);
+
+/**
+ * @brief Sets the allocator used for the linear memory buffers allocated by the library.
+ * @param allocator Allocator callbacks to use, the struct is copied.
+ * 
+ * By default, linearAlloc and linearFree are used. Use NULL to reset to default.
+ * Buffers must be freed with the same allocator they were allocated with, so
+ * the allocator should only be changed while no CWAV loaded from a file is alive.
+*/
+void cwavSetAllocator(const cwavAllocator* allocator);
+
+/**
+ * @brief Initializes an arena that suballocates sample buffers from a bigger linear memory buffer.
+ * @param arena The arena to initialize.
+ * @param buffer Linear memory buffer (e.g.: linearAlloc()) used as the arena storage.
+ * @param size Size of the buffer in bytes.
+ * @return Whether the arena was initialized or not.
+ * 
+ * Allocations are bumped from the top of the arena. Freed blocks are merged and kept
+ * in size class free lists, so they can be reused by later allocations.
+ * The buffer must be manually freed by the user after all the CWAVs using the arena are freed.
+*/
+bool cwavArenaInit(cwavArena* arena, void* buffer, size_t size);
+
+/**
+ * @brief Gets an allocator that allocates from the arena, to be used with cwavSetAllocator.
+ * @param arena The arena to allocate from.
+ * @param out Pointer to the allocator to fill.
+*/
+void cwavArenaGetAllocator(cwavArena* arena, cwavAllocator* out);
+
+/**
+ * @brief Moves the arena buffers together to remove the free space between them.
+ * @param arena The arena to compact.
+ * @return Amount of bytes given back to the top of the arena.
+ * 
+ * Only buffers owned by a single CWAV loaded with cwavFileLoad or cwavFileObjectLoad
+ * that are not currently playing are moved, the rest stay in place.
+ * The dataBuffer member of the moved CWAVs is updated with the new address.
+*/
+size_t cwavArenaCompact(cwavArena* arena);
+
+/**
+ * @brief Enables or disables the deduplication of identical sample data between loaded CWAVs.
+ * @param enable Whether to enable deduplication or not.
+ * 
+ * When enabled, cwavFileLoad and cwavFileObjectLoad hash the sample data of each channel and store it in a linear buffer
+ * shared by all the loaded channels with identical sample data, then shrink the file buffer to only keep the metadata,
+ * so the duplicated data does not use memory. cwavLoad and cwavFileLoadBatch do not deduplicate, as the buffers they load
+ * from stay allocated. Only affects the CWAVs loaded after the call. Disabled by default.
+*/
+void cwavEnableDeduplication(bool enable);
+
+/**
+ * @brief Enables or disables the computation of level envelopes when loading CWAVs, used by cwavGetLevel.
+ * @param enable Whether to compute the envelopes or not.
+ * 
+ * The envelope stores the peak and RMS level of every CWAV_LEVEL_BLOCK_SAMPLES samples of each channel
+ * (4 bytes per block and channel, in the heap). ADPCM channels are decoded once to compute it, which makes
+ * loading slower. Only affects the CWAVs loaded after the call. Disabled by default.
+*/
+void cwavEnableLevelEnvelopes(bool enable);
+
+/**
+ * @brief Validates a (b)cwav file and gets its information, without loading it.
+ * @param bcwavFileBuffer Pointer to the buffer containing the CWAV file (does not need to be in linear memory).
+ * @param bufferSize Size of the buffer, every access is checked against it.
+ * @param out Pointer to the cwavInfo struct to fill.
+ * @return CWAV_SUCCESS if the file is valid, otherwise the status that cwavLoad would fail with.
+ * 
+ * This function makes no allocations and does not modify the library state, so it can be used
+ * to scan many files quickly (e.g.: to build asset lists) and it does not require the environment to be set.
+ * Whether the encoding can be played with the current environment is not checked.
+*/
+cwavStatus_t cwavInspect(const void* bcwavFileBuffer, size_t bufferSize, cwavInfo* out);
+
 /**
  * @brief Loads a CWAV from a buffer in linear memory.
  * @param bcwavFileBuffer Pointer to the buffer in linear memory (e.g.: linearAlloc()) containing the CWAV file.
@@ -107,6 +450,9 @@ void cwavLoad(CWAV* out, const void* bcwavFileBuffer, u8 maxSPlays);
  * Wether the load was successful or not, cwavFileFree must be always called to clean up and free the memory.
  * Do not use cwavFree, as it will not properly free the bcwav buffer.
  * 
+ * The buffer is allocated with the allocator set with cwavSetAllocator.
+ * Files compressed with the cwavlz tool are decompressed while they are read.
+ * 
  * This function does not work with 3GX plugins.
  */
 void cwavFileLoad(CWAV* out, const char* bcwavFileName, u8 maxSPlays);
@@ -119,6 +465,7 @@ void cwavFileLoad(CWAV* out, const char* bcwavFileName, u8 maxSPlays);
  * Use the loadStatus struct member to determine if the load was successful.
  * Wether the load was successful or not, cwavFileFree must be always called to clean up and free the memory.
  * Do not use cwavFree, as it will not properly free the bcwav buffer.
+ * Files compressed with the cwavlz tool are decompressed while they are read.
  * Once this function is used, you can call fclose on the FILE object.
  * 
  * This function does not work with 3GX plugins.
@@ -145,6 +492,32 @@ void cwavFree(CWAV* cwav);
 */
 void cwavFileFree(CWAV* cwav);
 
+/**
+ * @brief Loads multiple CWAVs from the file system in parallel.
+ * @param out Array of pointers to the CWAV structs to load into, one for each file.
+ * @param bcwavFileNames Array of paths to the (b)CWAV files in the filesystem.
+ * @param maxSPlays Array with the amount of times each CWAV can be played simultaneously (should be >0).
+ * @param count Amount of files to load.
+ * 
+ * The files are read by a small thread pool spread over the CPU cores available to the application,
+ * and all of them are placed in a single linear memory allocation.
+ * Use the loadStatus struct member of each CWAV to determine if its load was successful.
+ * Wether the loads were successful or not, cwavFileFreeBatch must be always called with the same array and count.
+ * Do not use cwavFree or cwavFileFree on the CWAVs loaded with this function.
+ * 
+ * This function does not work with 3GX plugins.
+ */
+void cwavFileLoadBatch(CWAV** out, const char** bcwavFileNames, const u8* maxSPlays, u32 count);
+
+/**
+ * @brief Frees the CWAVs loaded with cwavFileLoadBatch.
+ * @param cwavs The same array of CWAV pointers passed to cwavFileLoadBatch.
+ * @param count The same count passed to cwavFileLoadBatch.
+ * 
+ * The CWAV* structs themselves must be freed manually if they have been allocated.
+*/
+void cwavFileFreeBatch(CWAV** cwavs, u32 count);
+
 #ifndef CWAV_DISABLE_CSND
 /**
  * @brief Plays the CWAV channels as a direct sound (only available if using CSND).
@@ -153,12 +526,57 @@ void cwavFileFree(CWAV* cwav);
  * @param rigtChannel The CWAV channel to play on the right ear.
  * @param directSoundChannel The direct sound channel to play the sound on. Range [0-3].
  * @param directSoundPrioriy The direct sound priority to use if the specified channel is in use (smaller value -> higher priority). Range [0-31].
- * @param soundModifiers CSND direct sound modifiers to apply to the sound.
+ * @param soundModifiers CSND direct sound modifiers to apply to the sound, NULL for the defaults.
  * 
  * To play a single channel in mono for both ears, set rightChannel to -1.
- * The individual channel volumes are multiplied by the CWAV volume.
+ * The individual channel volumes are multiplied by the CWAV volume (soundModifiers is not modified).
+ * The sound is not tracked by the direct sound scheduler, see cwavDirectSoundPlay.
+ * Direct sounds cannot loop, so looped CWAVs are rejected: cwavDirectSoundPlay plays them with loop emulation.
+*/
+bool cwavPlayAsDirectSound(CWAV* cwav, int leftChannel, int rightChannel, u32 directSoundChannel, u32 directSoundPriority, const ncsndDirectSoundModifiers* soundModifiers);
+
+/**
+ * @brief Plays the CWAV channels as a direct sound on a channel picked by the direct sound scheduler (only available if using CSND).
+ * @param cwav The CWAV to play.
+ * @param leftChannel The CWAV channel to play on the left ear.
+ * @param rightChannel The CWAV channel to play on the right ear, -1 to play the left one in mono.
+ * @param priority The priority of the sound (smaller value -> higher priority). Range [0-31].
+ * @param soundModifiers CSND direct sound modifiers to apply to the sound (copied), NULL for the defaults.
+ * @param maxWaitMs How long the sound can wait in the queue for a channel, 0 to never queue it.
+ * @return Whether the sound is playing, queued or failed (invalid arguments, or no channel and no room to wait).
+ * 
+ * The sound plays on a free direct sound channel, or replaces the sound with the lowest priority if it is lower
+ * than its own. Otherwise it waits in a queue (highest priority first) until cwavDirectSoundUpdate finds a free channel.
+ * The end of the sounds is estimated from their length, as CSND does not report it.
+ * Direct sounds cannot loop: looped CWAVs are played again from their loop start at the estimated end of the previous
+ * pass by a thread created while direct sounds loop (at a higher priority than the calling thread), until
+ * cwavDirectSoundStop is called or a higher priority sound takes the channel. The loops are not gapless, the gap is the
+ * thread wake up and CSND latency. If the thread cannot be created, cwavDirectSoundUpdate sends the next passes instead.
+*/
+cwavDirectSoundStatus_t cwavDirectSoundPlay(CWAV* cwav, int leftChannel, int rightChannel, u32 priority, const ncsndDirectSoundModifiers* soundModifiers, u32 maxWaitMs);
+
+/**
+ * @brief Plays the queued direct sounds on the channels that became free and drops the ones that waited too long.
+ * 
+ * Should be called regularly (e.g: once per frame) while sounds are queued.
+*/
+void cwavDirectSoundUpdate();
+
+/**
+ * @brief Stops looping the direct sounds of a CWAV (the current pass plays until its end) and drops its queued ones.
+ * @param cwav The CWAV, NULL for all of them.
 */
-bool cwavPlayAsDirectSound(CWAV* cwav, int leftChannel, int rightChannel, u32 directSoundChannel, u32 directSoundPriority, ncsndDirectSoundModifiers* soundModifiers);
+void cwavDirectSoundStop(CWAV* cwav);
+
+/**
+ * @brief Returns the amount of direct sounds waiting for a channel.
+*/
+u32 cwavDirectSoundGetQueued();
+
+/**
+ * @brief Drops all the direct sounds waiting for a channel.
+*/
+void cwavDirectSoundClearQueue();
 #endif
 
 /**
@@ -172,6 +590,225 @@ bool cwavPlayAsDirectSound(CWAV* cwav, int leftChannel, int rightChannel, u32 di
 */
 cwavPlayResult cwavPlay(CWAV* cwav, int leftChannel, int rightChannel);
 
+/**
+ * @brief Plays the specified channels in the bcwav file with a custom mix matrix.
+ * @param cwav The CWAV to play.
+ * @param leftChannel The CWAV channel to play on the left ear.
+ * @param rigtChannel The CWAV channel to play on the right ear.
+ * @param leftMix Mix of the left channel, 12 gains or NULL to use the default mix.
+ * @param rightMix Mix of the right channel, 12 gains or NULL to use the default mix.
+ * @return A cwavPlayResult struct with the status code and which audio channels were assigned.
+ * 
+ * The gains use the ndspChnSetMix layout: front left, front right, back left and back right
+ * for the main output, followed by the same four outputs for aux 0 and aux 1. The aux buses
+ * must be enabled with ndspAuxSetEnable (and usually given an effect with ndspAuxSetCallback).
+ * The gains are multiplied by the CWAV volume and the category volume, the pan is ignored.
+ * 
+ * CSND has no aux buses, the aux gains are ignored and the back outputs are folded into the front ones.
+*/
+cwavPlayResult cwavPlayWithMix(CWAV* cwav, int leftChannel, int rightChannel, const float* leftMix, const float* rightMix);
+
+/**
+ * @brief Starts the sample clock used by scheduled plays (only available if using DSP).
+ * @return Whether the scheduler is running or not.
+ * 
+ * The clock counts the DSP output samples (SYSCLOCK_ARM11 / 8192 per second, around 32728) from 0
+ * and is updated from the ndsp frame callback, so the application must use cwavSetFrameCallback instead of ndspSetCallback.
+*/
+bool cwavSchedulerStart();
+
+/**
+ * @brief Stops the sample clock. Scheduled sounds that did not start yet are stopped and the sequencer is cleared.
+*/
+void cwavSchedulerStop();
+
+/**
+ * @brief Returns the sample clock: the position of the first sample of the next DSP frame.
+*/
+u64 cwavGetSampleClock();
+
+/**
+ * @brief Plays the specified channels in the bcwav file at a sample clock position.
+ * @param cwav The CWAV to play.
+ * @param leftChannel The CWAV channel to play on the left ear.
+ * @param rigtChannel The CWAV channel to play on the right ear.
+ * @param samplePosition The sample clock position at which the sound starts.
+ * @return A cwavPlayResult struct with the status code and which audio channels were assigned.
+ * 
+ * The channels are assigned right away and wait paused until the DSP frame samplePosition falls into,
+ * where the frame callback releases them. The start inside the frame is delayed with silence, so sounds
+ * scheduled on the same clock keep their spacing to the nearest sample of the sound. The play must be done
+ * at least one frame (160 samples) ahead, later sounds start as soon as possible.
+ * Returns CWAV_INVALID_ARGUMENT if the scheduler is not running.
+*/
+cwavPlayResult cwavPlayAtTime(CWAV* cwav, int leftChannel, int rightChannel, u64 samplePosition);
+
+/**
+ * @brief Adds timed play events to the sequencer queue.
+ * @param events The events, sorted by samplePosition.
+ * @param count Amount of events.
+ * @return Amount of events added. Stops at the first event that is earlier than the last queued one or when the queue (256 events) is full.
+ * 
+ * The CWAVs must stay loaded until their events are committed or the sequencer is cleared.
+*/
+u32 cwavSequencerSubmit(const cwavSeqEvent* events, u32 count);
+
+/**
+ * @brief Commits the queued events that start before the sample clock + lookaheadSamples with cwavPlayAtTime.
+ * @param lookaheadSamples How far ahead the events are committed.
+ * 
+ * Call it periodically from the application thread, with a lookahead longer than the time between calls
+ * plus a DSP frame (e.g.: 2000 samples when called every 60Hz frame). Committed events hold their
+ * channels until they start, so longer lookaheads use more channels.
+*/
+void cwavSequencerUpdate(u32 lookaheadSamples);
+
+/**
+ * @brief Removes all the events from the sequencer queue. Committed events are not affected.
+*/
+void cwavSequencerClear();
+
+/**
+ * @brief Returns the amount of events in the sequencer queue.
+*/
+u32 cwavSequencerGetPendingEvents();
+
+/**
+ * @brief Defines a named region of the samples of a CWAV, that can be played as a separate sound.
+ * @param cwav The CWAV to add the region to.
+ * @param name The name of the region, truncated to CWAV_REGION_NAME_SIZE - 1 characters. Can be NULL.
+ * @param region The sample range of the region.
+ * @return The index of the region, to use with cwavPlayRegion, or -1 if the range is invalid.
+ * 
+ * The region start and loop start are aligned down to the encoding: 14 samples (one frame) for DSP ADPCM
+ * and 2 samples for IMA ADPCM. The ADPCM contexts at the region start and loop start are decoded here once,
+ * so this takes time proportional to the position of the region in the CWAV: add the regions at load time.
+ * Fails for DSP ADPCM CWAVs loaded while using CSND.
+*/
+int cwavAddRegion(CWAV* cwav, const char* name, const cwavRegion* region);
+
+/**
+ * @brief Returns the index of the first region of a CWAV with the specified name, or -1 if there is none.
+*/
+int cwavFindRegion(CWAV* cwav, const char* name);
+
+/**
+ * @brief Returns the amount of regions of a CWAV.
+*/
+u32 cwavGetRegionCount(CWAV* cwav);
+
+/**
+ * @brief Stops the CWAV and removes all its regions. The regions are also removed when the CWAV is freed.
+*/
+void cwavClearRegions(CWAV* cwav);
+
+/**
+ * @brief Plays a region of the specified channels in the bcwav file, like cwavPlay.
+ * @param cwav The CWAV to play.
+ * @param region The index of the region, returned by cwavAddRegion or cwavFindRegion.
+ * @param leftChannel The CWAV channel to play on the left ear.
+ * @param rigtChannel The CWAV channel to play on the right ear.
+ * @return A cwavPlayResult struct with the status code and which audio channels were assigned.
+ * 
+ * The plays of the regions share the maxSPlays slots of the CWAV. Returns CWAV_INVALID_ARGUMENT if the region does not exist.
+*/
+cwavPlayResult cwavPlayRegion(CWAV* cwav, int region, int leftChannel, int rightChannel);
+
+/**
+ * @brief Starts playing regions of a CWAV one after the other on a segment player (DSP only).
+ * @param player The segment player, from 0 to CWAV_SEGMENT_PLAYERS - 1. A segment already playing on it is stopped.
+ * @param cwav The CWAV to play. All the segments of the player are regions of this CWAV.
+ * @param region The index of the first region.
+ * @param leftChannel The CWAV channel to play on the left ear.
+ * @param rigtChannel The CWAV channel to play on the right ear.
+ * @param beatSamples Length of a beat in samples of the CWAV, the segments are queued one beat at a time so
+ * transitions can happen on beats. 0 queues whole segments, shorter beats are extended to CWAV_SEGMENT_MIN_SAMPLES.
+ * @return A cwavPlayResult struct with the status code and which audio channels were assigned.
+ * 
+ * Instead of a looping wave buffer, the segments are queued as non-looping wave buffers from the ndsp frame
+ * callback, one part ahead of the playing one. A looped region is queued again from its loop start (with its
+ * ADPCM loop context) until another segment is queued, a region that is not looped is followed by the segment
+ * queued before its end, or ends the playback. Transitions are gapless and sample accurate, without stopping the voices.
+ * Uses the ndsp frame callback, so the application must use cwavSetFrameCallback instead of ndspSetCallback.
+ * Returns CWAV_INVALID_ARGUMENT if the player or the region do not exist or the environment is not DSP.
+*/
+cwavPlayResult cwavSegmentPlay(u32 player, CWAV* cwav, int region, int leftChannel, int rightChannel, u32 beatSamples);
+
+/**
+ * @brief Sets the segment that follows the current one on a segment player.
+ * @param player The segment player.
+ * @param region The index of the region of the CWAV of the player.
+ * @param transition When the segment starts.
+ * @return Whether the segment was queued. Fails if the player is not playing or the region does not exist.
+ * 
+ * Replaces the segment queued before if it did not start yet. The part of the current segment that is already
+ * queued plays before the transition, so it happens at the end of the next beat (or segment) at the latest.
+*/
+bool cwavSegmentQueue(u32 player, int region, cwavSegmentTransition_t transition);
+
+/**
+ * @brief Returns the region of the last part queued on a segment player, or -1 if the player is not playing.
+*/
+int cwavSegmentGetCurrent(u32 player);
+
+/**
+ * @brief Returns whether a segment player is playing. It stops at the end of a region that is not looped with no segment queued, or if its channels are stopped.
+*/
+bool cwavSegmentIsPlaying(u32 player);
+
+/**
+ * @brief Stops a segment player and its voices.
+*/
+void cwavSegmentStop(u32 player);
+
+/**
+ * @brief Plays stems (layers of interactive music) locked together on a stem group (DSP only).
+ * @param group The stem group, from 0 to CWAV_STEM_GROUPS - 1. Stems already playing on it are stopped.
+ * @param layers The layers to play, separate CWAVs or channels of one multichannel CWAV.
+ * @param count Amount of layers, up to CWAV_STEM_MAX_LAYERS.
+ * @return CWAV_SUCCESS, or the error of the first layer that failed. Nothing plays if any layer fails.
+ * 
+ * The voices of all the layers are reserved first (CWAV_NO_CHANNEL_AVAILABLE if there are not enough free
+ * channels) and wait paused, then they are released together from the ndsp frame callback, so all the stems
+ * start in the same DSP frame. Plays of the same CWAV channel in several layers need enough maxSPlays.
+ * Returns CWAV_INVALID_ARGUMENT if the environment is not DSP, as CSND sounds cannot wait paused.
+*/
+cwavStatus_t cwavStemPlay(u32 group, const cwavStemLayer* layers, u32 count);
+
+/**
+ * @brief Changes the volume of a layer of a stem group.
+ * @param group The stem group.
+ * @param layer The index of the layer in the array passed to cwavStemPlay.
+ * @param volume The new layer volume.
+ * @param fadeMs Duration of a linear fade to the new volume, 0 to change it right away. Fades advance in cwavStemUpdate.
+*/
+void cwavStemSetLayerVolume(u32 group, u32 layer, float volume, u32 fadeMs);
+
+/**
+ * @brief Changes the volume of a whole stem group, multiplied with the layer volumes.
+ * @param group The stem group.
+ * @param volume The new group volume.
+ * @param fadeMs Duration of a linear fade to the new volume, 0 to change it right away.
+*/
+void cwavStemSetVolume(u32 group, float volume, u32 fadeMs);
+
+/**
+ * @brief Stops all the layers of a stem group.
+ * @param group The stem group.
+ * @param fadeMs Duration of a fade out before stopping, 0 to stop right away.
+*/
+void cwavStemStop(u32 group, u32 fadeMs);
+
+/**
+ * @brief Returns whether any layer of a stem group is playing.
+*/
+bool cwavStemIsPlaying(u32 group);
+
+/**
+ * @brief Advances the stem fades, should be called periodically (e.g.: once per frame) if fades are used.
+*/
+void cwavStemUpdate();
+
 /**
  * @brief Stops the specified channels in the bcwav file.
  * @param cwav The CWAV to play.
@@ -188,12 +825,281 @@ void cwavStop(CWAV* cwav, int leftChannel, int rightChannel);
 */
 bool cwavIsPlaying(CWAV* cwav);
 
+/**
+ * @brief Gets the level of a playing voice from the level envelope of the CWAV (see cwavEnableLevelEnvelopes).
+ * @param cwav The CWAV the voice plays.
+ * @param channel The DSP/CSND channel of the voice (e.g: cwavPlayResult monoLeftChannel).
+ * @param out Pointer to the cwavLevel struct to fill.
+ * @return False if the CWAV has no level envelope or the channel is not playing it.
+ * 
+ * The level is the one of the block at the play position, scaled by the volume of the voice (CWAV volume, category
+ * and stem gains), the pan and mix are not applied. It is 0 before the voice starts and for music segments. With CSND
+ * the play position is estimated from the elapsed time. Useful for meters or to cull quiet voices without decoding audio.
+*/
+bool cwavGetVoiceLevel(CWAV* cwav, u32 channel, cwavLevel* out);
+
+/**
+ * @brief Gets the level of the loudest playing voice of the CWAV, like cwavGetVoiceLevel (0 if none is playing).
+ * @return False if the CWAV has no level envelope.
+*/
+bool cwavGetLevel(CWAV* cwav, cwavLevel* out);
+
 /**
  * @brief Gets a bitmap representing the playing state of the channels for the selected environment.
  * @return Bitmap of the playing channels. First channel is the LSB.
 */
 u32 cwavGetEnvironmentPlayingChannels();
 
+/**
+ * @brief Reserves DSP/CSND channels for the plays of a CWAV.
+ * @param channelMask The channels to reserve, bit N is channel N.
+ * @param cwav The CWAV the channels are reserved for.
+ * @return Whether the channels were reserved. Fails if a channel is not available in the current environment.
+ * 
+ * The plays of the CWAV use its free reserved channels first and then the channels that are not reserved,
+ * other sounds never use them. As the same sound replays on the same channels, the DSP channel settings
+ * that did not change (format, rate, mix and ADPCM coefficients) are not sent again, which keeps the play
+ * latency low for frequent sounds. Reserving a channel again replaces its owner. The reservation is removed
+ * when the CWAV is freed.
+*/
+bool cwavReserveChannels(u32 channelMask, CWAV* cwav);
+
+/**
+ * @brief Reserves DSP/CSND channels for the plays of all the CWAVs of a category, like cwavReserveChannels.
+ * 
+ * Channels reserved for a CWAV are used before the ones reserved for its category.
+*/
+bool cwavReserveCategoryChannels(u32 channelMask, cwavCategory_t category);
+
+/**
+ * @brief Removes the reservation of DSP/CSND channels. Playing voices are not stopped.
+*/
+void cwavUnreserveChannels(u32 channelMask);
+
+/**
+ * @brief Returns the mask of the reserved DSP/CSND channels.
+*/
+u32 cwavGetReservedChannels();
+
+/**
+ * @brief Sets the DSP/CSND channels libcwav is allowed to use.
+ * @param channelMask The allowed channels, bit N is channel N. Default: all the channels.
+ * 
+ * Channels outside of the mask are left to the application (for example, its own ndsp streaming code):
+ * libcwav never plays, stops or resets them. The libcwav voices playing on channels removed from the mask
+ * are stopped, as well as the reservations of those channels.
+*/
+void cwavSetChannelMask(u32 channelMask);
+
+/**
+ * @brief Returns the mask of the DSP/CSND channels libcwav is allowed to use.
+*/
+u32 cwavGetChannelMask();
+
+/// Channel budget without limit.
+#define CWAV_UNLIMITED_CHANNELS 0xFFFFFFFF
+
+/**
+ * @brief Limits the amount of DSP/CSND channels playing at the same time for all the CWAVs.
+ * @param maxChannels Maximum amount of channels (a stereo play uses 2), or CWAV_UNLIMITED_CHANNELS (default).
+ * 
+ * Plays that would go over the budget fail with CWAV_NO_CHANNEL_AVAILABLE, reserved channels count as well.
+*/
+void cwavSetChannelBudget(u32 maxChannels);
+
+/**
+ * @brief Limits the amount of DSP/CSND channels playing at the same time for the CWAVs of a category, like cwavSetChannelBudget.
+ * 
+ * Combined with cwavReserveCategoryChannels, each category can get its own pool of channels and a maximum share of the other ones.
+*/
+void cwavSetCategoryChannelBudget(cwavCategory_t category, u32 maxChannels);
+
+/**
+ * @brief Sets the volume of a sound category.
+ * @param category Value from the cwavCategory_t enum.
+ * @param volume Value in the range [0.0, 1.0], multiplied by the volume of each CWAV. Default: 1.0
+ * 
+ * The volume of all the playing voices in the category is updated immediately. With CSND, playing sounds
+ * cannot be changed, so only the sounds played afterwards use the new volume (also for mute and ducking).
+*/
+void cwavCategorySetVolume(cwavCategory_t category, float volume);
+
+/**
+ * @brief Gets the volume of a sound category, without mute and ducking applied.
+*/
+float cwavCategoryGetVolume(cwavCategory_t category);
+
+/**
+ * @brief Mutes or unmutes a sound category. The voices keep playing while muted.
+*/
+void cwavCategorySetMute(cwavCategory_t category, bool mute);
+
+/**
+ * @brief Pauses or resumes all the voices of a sound category (only available if using DSP).
+ * @param category Value from the cwavCategory_t enum.
+ * @param paused Whether to pause or resume.
+ * @return Whether the category pause state was set or not. Always false with CSND, which cannot pause playing sounds.
+ * 
+ * Paused voices keep their play position and their DSP channels, which are not reused until the voices
+ * are stopped or resumed. Sounds played while their category is paused start paused.
+*/
+bool cwavCategorySetPaused(cwavCategory_t category, bool paused);
+
+/**
+ * @brief Checks whether a sound category is paused or not.
+*/
+bool cwavCategoryIsPaused(cwavCategory_t category);
+
+/**
+ * @brief Lowers the volume of a category while another category is playing (e.g.: SFX while there is dialogue).
+ * @param category The category to lower the volume of.
+ * @param trigger The category that triggers the ducking while any of its voices is playing.
+ * @param duckVolume Volume multiplier applied while ducked, in the range [0.0, 1.0]. Use 1.0 to remove the ducking.
+ * 
+ * If multiple triggers are playing, the lowest multiplier is used. Ducking starts as soon as a trigger voice
+ * is played, the end of the trigger voices is detected by cwavCategoryUpdate.
+*/
+void cwavCategorySetDucking(cwavCategory_t category, cwavCategory_t trigger, float duckVolume);
+
+/**
+ * @brief Updates the ducking state, should be called periodically (e.g.: once per frame) if ducking is used.
+ * 
+ * Only the voices whose volume changed are updated.
+*/
+void cwavCategoryUpdate();
+
+/**
+ * @brief Computes the spatialization of a batch of emitters and applies it to their playing voices.
+ * @param listener The listener.
+ * @param model Distance attenuation and Doppler settings.
+ * @param emitters The emitters, the output arrays are filled if set.
+ * 
+ * For each emitter, the volume is attenuated with the inverse distance model, the sound is panned
+ * left/right and front/back in the DSP front/back outputs (straight ahead uses the usual 0.8/0.2 split)
+ * and the Doppler pitch is computed. With CSND, playing sounds cannot be changed, so only the output arrays are filled.
+ * The result is multiplied by the CWAV volume and the category volume of each voice, and only the
+ * voices whose mix or pitch changed are updated.
+ * 
+ * Channels are reused by other sounds once their voice ends, so emitters whose sound is no longer
+ * playing (see cwavIsPlaying) should be set to -1. Voices are no longer spatialized once they are played again.
+*/
+void cwavSpatialUpdate(const cwavListener* listener, const cwavSpatialModel* model, cwavEmitters* emitters);
+
+/**
+ * @brief Changes the mix matrix of a playing channel without restarting it.
+ * @param channel The audio channel, as returned in cwavPlayResult.
+ * @param mix 12 gains in the cwavPlayWithMix layout, or NULL to restore the default mix.
+ * @return Whether the channel is playing a CWAV voice and the mix was applied. Always false with CSND when
+ * the mix changes, as playing sounds cannot be changed.
+ * 
+ * Spatialized voices keep their main output gains from cwavSpatialUpdate, only the aux sends are used.
+*/
+bool cwavSetChannelMix(u32 channel, const float* mix);
+
+/**
+ * @brief Sets the effects applied to a DSP aux bus (only available if using DSP).
+ * @param auxBus The aux bus, 0 or 1.
+ * @param effects The effects, applied in order. Can be NULL if count is 0.
+ * @param count Amount of effects, up to CWAV_EFFECTS_MAX_CHAIN. 0 removes the chain.
+ * @return Whether the chain was set or not.
+ * 
+ * The chain runs from the ndsp aux callback of the bus, which is enabled with ndspAuxSetEnable.
+ * Removing the chain disables the bus and its callback. The aux bus volume (ndspAuxSetVolume)
+ * is left to the application. Sounds are sent to the bus with the aux gains of cwavPlayWithMix.
+ * 
+ * The back outputs of the bus are folded into the front ones before the effects. As the input
+ * of the bus is also in the main output, delays and reverbs are usually fully wet (wet = 1).
+ * Setting a chain resets the state of the effects (delay lines and reverb tails).
+*/
+bool cwavEffectsSetChain(u32 auxBus, const cwavEffect* effects, u32 count);
+
+/**
+ * @brief Gets the CPU usage of the effect chain of a DSP aux bus.
+ * @param auxBus The aux bus, 0 or 1.
+ * @param out Pointer to the cwavEffectsStats struct to fill. All the values are 0 if the bus has no chain.
+ * 
+ * The DSP processes a frame every 160 samples (around 4.9ms), the loads tell how much of that time
+ * the effects take on the ndsp thread.
+*/
+void cwavEffectsGetStats(u32 auxBus, cwavEffectsStats* out);
+
+/**
+ * @brief Gets the runtime statistics of the library.
+ * @param out Pointer to the cwavStats struct to fill.
+ * 
+ * Statistics can be removed at compile time by building the library with CWAV_DISABLE_STATS defined,
+ * in that case all the values are 0.
+*/
+void cwavGetStats(cwavStats* out);
+
+/**
+ * @brief Resets the runtime statistics counters.
+ * 
+ * The values that represent the current state (active voices, loaded CWAVs and memory usage) are kept.
+*/
+void cwavResetStats();
+
+/**
+ * @brief Starts recording the library events into a ring buffer.
+ * @param buffer Buffer to store the events in, must be kept allocated until cwavTraceDumpJson is no longer used.
+ * @param capacity Amount of events the buffer can hold, must be a power of two.
+ * @return Whether the trace was started or not.
+ * 
+ * Once the buffer is full, the oldest events are overwritten. Events can be recorded from any thread without locks.
+ * Tracing can be removed at compile time by building the library with CWAV_DISABLE_TRACE defined.
+*/
+bool cwavTraceStart(cwavTraceEvent* buffer, u32 capacity);
+
+/**
+ * @brief Stops recording events. The recorded events are kept in the buffer.
+*/
+void cwavTraceStop();
+
+/**
+ * @brief Writes the recorded events as Chrome trace event JSON (compatible with Perfetto and chrome://tracing).
+ * @param file FILE object obtained with fopen. Must have write permissions.
+ * @return Whether the events were written successfully or not.
+ * 
+ * Timestamps are in microseconds since the system boot, so they can be aligned with other captures using svcGetSystemTick.
+ * Call cwavTraceStop before dumping, so the events are not overwritten while they are written.
+*/
+bool cwavTraceDumpJson(FILE* file);
+
+/**
+ * @brief Starts measuring the time from cwavPlay to the first samples of each voice being consumed.
+ * @param useNdspCallback If true and using DSP, the measurements are updated from the ndsp frame callback.
+ * 
+ * When using the ndsp frame callback, the application must use cwavSetFrameCallback instead of ndspSetCallback. Otherwise, cwavLatencyUpdate
+ * must be called periodically (e.g.: from your own ndsp callback, or every frame when using CSND).
+ * The precision of the measurement is limited by how often cwavLatencyUpdate is called. With CSND, a voice counts as
+ * started the first time cwavLatencyUpdate sees it playing, so its measurements are approximate.
+ * Scheduled (cwavPlayAtTime), held (stem) and paused voices wait on purpose and are not measured.
+ * Measurements are stored separately for each environment. Previous measurements are reset.
+*/
+void cwavLatencyStart(bool useNdspCallback);
+
+/**
+ * @brief Stops measuring the play latency. The measurements are kept.
+*/
+void cwavLatencyStop();
+
+/**
+ * @brief Checks the voices waiting for their first samples to be consumed and records their latency.
+*/
+void cwavLatencyUpdate();
+
+/**
+ * @brief Resets the play latency measurements.
+*/
+void cwavLatencyReset();
+
+/**
+ * @brief Gets the play latency measurements for an environment.
+ * @param env The environment to get the measurements for.
+ * @param out Pointer to the cwavLatencyReport struct to fill.
+*/
+void cwavLatencyGetReport(cwavEnvMode_t env, cwavLatencyReport* out);
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
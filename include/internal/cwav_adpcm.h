@@ -0,0 +1,40 @@
+#ifndef CWAVADPCM_H
+#define CWAVADPCM_H
+#include "cwav.h"
+#include "internal/cwav_defs.h"
+
+#define CWAV_DSP_ADPCM_FRAME_SAMPLES 14
+#define CWAV_DSP_ADPCM_FRAME_BYTES 8
+
+// Decodes a sample of DSP ADPCM channel data. hist1 and hist2 are the two previous samples and are updated.
+s16 cwavAdpcmDecodeDsp(const u8* data, u32 sample, const u16* coefs, s32* hist1, s32* hist2);
+// Decodes an IMA ADPCM nibble, the predictor and table index are updated.
+s16 cwavAdpcmDecodeIma(u8 nibble, s32* predictor, s32* tableIndex);
+// Encodes a sample to an IMA ADPCM nibble, the state is updated the same way the decoder does.
+u8 cwavAdpcmEncodeIma(s16 sample, s32* predictor, s32* tableIndex);
+
+#ifndef CWAV_DISABLE_CSND
+// CSND cannot play DSP ADPCM, the channels are transcoded to IMA ADPCM (transcodedData and transcodedInfos).
+bool cwavAdpcmTranscode(cwav_t* cwav);
+void cwavAdpcmFreeTranscoded(cwav_t* cwav);
+// Transcodes DSP ADPCM CWAVs the first time they are played with CSND. False if the CWAV cannot be played with CSND.
+bool cwavAdpcmPrepareCsnd(cwav_t* cwav);
+#endif
+
+// Encoding, channel data and IMA ADPCM info to play, the transcoded ones if there are.
+static inline u32 cwavAdpcmPlayEncoding(const cwav_t* cwav)
+{
+    return cwav->transcodedData ? IMA_ADPCM : cwav->cwavInfo->encoding;
+}
+
+static inline void* cwavAdpcmPlayData(const cwav_t* cwav, int channel)
+{
+    return cwav->transcodedData ? cwav->transcodedData[channel] : cwav->sampleData[channel];
+}
+
+static inline cwavIMAADPCMInfo_t* cwavAdpcmPlayImaInfo(const cwav_t* cwav, int channel)
+{
+    return cwav->transcodedData ? &cwav->transcodedInfos[channel] : cwav->IMAADPCMInfos[channel];
+}
+
+#endif
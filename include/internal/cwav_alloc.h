@@ -0,0 +1,12 @@
+#ifndef CWAVALLOC_H
+#define CWAVALLOC_H
+#include "cwav.h"
+
+void* cwavAllocLinear(size_t size);
+void cwavAllocFree(void* mem);
+
+// Implemented in cwav.c, used to patch the CWAVs when their buffer is moved.
+CWAV* cwav_GetRelocatable(void* buffer, size_t size);
+void cwav_Relocate(CWAV* cwav, void* newBuffer);
+
+#endif
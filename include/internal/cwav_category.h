@@ -0,0 +1,10 @@
+#ifndef CWAVCATEGORY_H
+#define CWAVCATEGORY_H
+#include "cwav.h"
+
+float cwavCategoryGetGain(u8 category);
+// Records the voice before it is played, returns whether it has to be paused once started.
+bool cwavCategoryVoiceStarted(u32 channel, u8 category, float volume, float pan, const float* mix, float rate, float gain);
+void cwavCategoryPlayFinished(u8 category);
+
+#endif
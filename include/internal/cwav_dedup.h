@@ -0,0 +1,9 @@
+#ifndef CWAVDEDUP_H
+#define CWAVDEDUP_H
+#include "cwav.h"
+
+bool cwavDedupIsEnabled();
+void* cwavDedupAcquire(const void* sampleData, u32 size);
+void cwavDedupRelease(void* sharedData);
+
+#endif
@@ -119,6 +119,8 @@ typedef struct  cwavHeader_s
     cwavSizedReference_t data_blck;
 } cwavHeader_t;
 
+struct cwavRegionImpl_s;
+
 typedef struct cwav_s
 {
     void* fileBuf;
@@ -128,7 +130,17 @@ typedef struct cwav_s
     cwavchannelInfo_t** channelInfos;
     cwavIMAADPCMInfo_t** IMAADPCMInfos;
     cwavDSPADPCMInfo_t** DSPADPCMInfos;
+    void** sampleData;
     int** playingChanIds;
+    // Channel serial of each playingChanIds entry when it was played (play after play), the entry is stale once it changes.
+    u32* playingSerials;
+    struct cwavRegionImpl_s* regions;
+    u32 regionCount;
+    // DSP ADPCM channels transcoded to IMA ADPCM once played with CSND, NULL otherwise.
+    void** transcodedData;
+    cwavIMAADPCMInfo_t* transcodedInfos;
+    // Peak and RMS of every CWAV_LEVEL_BLOCK_SAMPLES samples, channel after channel. NULL if not computed.
+    u16* levelEnvelope;
     u8 channelcount;
     u8 totalMultiplePlay;
     u8 currMultiplePlay;
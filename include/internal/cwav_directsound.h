@@ -0,0 +1,10 @@
+#ifndef CWAVDIRECTSOUND_H
+#define CWAVDIRECTSOUND_H
+#include "cwav.h"
+
+#ifndef CWAV_DISABLE_CSND
+// Drops the queued direct sounds of a CWAV that is being freed.
+void cwavDirectSoundForget(const CWAV* cwav);
+#endif
+
+#endif
@@ -12,14 +12,50 @@ void cwavEnvFinalize();
 bool cwavEnvCompatibleEncoding(cwavEncoding_t encoding);
 
 u32 cwavEnvGetChannelAmount();
+// Channels outside of the mask are not available, never reported as playing and never stopped.
+void cwavEnvSetChannelMask(u32 channelMask);
+u32 cwavEnvGetChannelMask();
 bool cwavEnvIsChannelAvailable(u32 channel);
 
 #ifndef CWAV_DISABLE_CSND
-bool cwavEnvPlayDirectSound(CWAV* cwav, int leftChannel, int rightChannel, u32 directSoundChannel, u32 directSoundPriority, ncsndDirectSoundModifiers* soundModifiers);
+// loopPass plays from the loop start to the end with the loop ADPCM contexts, used to emulate loops.
+bool cwavEnvPlayDirectSound(CWAV* cwav, int leftChannel, int rightChannel, u32 directSoundChannel, u32 directSoundPriority, const ncsndDirectSoundModifiers* soundModifiers, bool loopPass);
 #endif
 
-void cwavEnvPlay(u32 channel, bool isLooped, cwavEncoding_t encoding, u32 sampleRate, float volume, float pan, float pitch, void* block0, void* block1, u32 loopStart, u32 loopEnd, u32 totalSize, cwavIMAADPCMInfo_t* IMAADPCMInfos, cwavDSPADPCMInfo_t* DSPADPCMInfos);
+// startDelay: DSP output samples of silence played before the sound (DSP only).
+void cwavEnvPlay(u32 channel, bool isLooped, cwavEncoding_t encoding, u32 sampleRate, const float* mix, float pitch, void* block0, void* block1, u32 loopStart, u32 loopEnd, u32 totalSize, cwavIMAADPCMInfo_t* IMAADPCMInfos, cwavDSPADPCMInfo_t* DSPADPCMInfos, u32 startDelay);
 bool cwavEnvChannelIsPlaying(u32 channel);
+bool cwavEnvChannelHasStarted(u32 channel);
 void cwavEnvStop(u32 channel);
+// Fails with CSND, the volume and pan are only set when the sound is played.
+bool cwavEnvSetMix(u32 channel, const float* mix);
+// Fails with CSND, the rate is only set when the sound is played.
+bool cwavEnvSetRate(u32 channel, float rate);
+// Fails with CSND, which cannot pause playing sounds.
+bool cwavEnvSetPaused(u32 channel, bool paused);
+bool cwavEnvChannelIsPaused(u32 channel);
+// Held channels stay paused until released, independently of cwavEnvSetPaused (DSP only).
+// Holding must be done before cwavEnvPlay, releasing can be done from the ndsp thread.
+void cwavEnvSetHeld(u32 channel, bool held);
+bool cwavEnvChannelIsHeld(u32 channel);
+// Releases the held channels of the mask at the same time (in the same DSP frame if called from a frame hook).
+void cwavEnvReleaseHeld(u32 channels);
+// Sample position of the playing voice from the start of block0, estimated from the elapsed time with CSND.
+// Fails if the voice is not playing, not started yet or playing segment buffers.
+bool cwavEnvGetPlayPosition(u32 channel, u32* position);
+// Changes with every play and stop of the channel.
+u32 cwavEnvGetChannelSerial(u32 channel);
+// Queues a non-looping wave buffer after the ones of the playing voice (DSP only). A NULL context
+// continues the ADPCM decoding of the previous buffer, which must end where data starts.
+bool cwavEnvQueueSegment(u32 channel, void* data, u32 samples, cwavDSPADPCMContext_t* context);
+// Wave buffers of the channel waiting to be played.
+u32 cwavEnvGetQueuedBuffers(u32 channel);
+
+// Functions called after every DSP frame from the ndsp callback (DSP only), which replaces the ndspSetCallback one.
+// The application callback set with cwavSetFrameCallback runs after them.
+typedef void (*cwavEnvFrameHook)(void);
+bool cwavEnvAddFrameHook(cwavEnvFrameHook hook);
+void cwavEnvRemoveFrameHook(cwavEnvFrameHook hook);
+bool cwavEnvSetAppFrameCallback(ndspCallback callback, void* data);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,15 @@
+#ifndef CWAVLATENCY_H
+#define CWAVLATENCY_H
+#include "cwav.h"
+
+extern bool g_cwavLatencyEnabled;
+
+void cwavLatencyPlayBegin();
+void cwavLatencyVoiceStarted(u32 channel);
+void cwavLatencyVoiceIgnored(u32 channel);
+
+#define CWAV_LATENCY_PLAY_BEGIN() do { if (g_cwavLatencyEnabled) cwavLatencyPlayBegin(); } while (0)
+#define CWAV_LATENCY_VOICE_STARTED(channel) do { if (g_cwavLatencyEnabled) cwavLatencyVoiceStarted(channel); } while (0)
+#define CWAV_LATENCY_VOICE_IGNORED(channel) do { if (g_cwavLatencyEnabled) cwavLatencyVoiceIgnored(channel); } while (0)
+
+#endif
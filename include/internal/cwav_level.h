@@ -0,0 +1,13 @@
+#ifndef CWAVLEVEL_H
+#define CWAVLEVEL_H
+#include "cwav.h"
+#include "internal/cwav_defs.h"
+
+bool cwavLevelIsEnabled();
+// Computes the level envelope of the channels, leaves it NULL if there is not enough memory.
+void cwavLevelBuild(cwav_t* cwav);
+void cwavLevelFree(cwav_t* cwav);
+// Heap memory used by the level envelope.
+u32 cwavLevelEnvelopeSize(const cwav_t* cwav);
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef CWAVLZ4_H
+#define CWAVLZ4_H
+#include "3ds/types.h"
+#include <stdio.h>
+
+// Compressed (b)cwav container:
+// - cwavLz4Header_t
+// - Blocks, each one decompresses to blockSize bytes (except the last one):
+//   - u32 with the compressed size of the block. If CWAV_LZ4_BLOCK_STORED is set, the block is not compressed.
+//     CWAV_LZ4_BLOCK_DELTA8 and CWAV_LZ4_BLOCK_DELTA16 tell which pre-filter to undo after decompressing.
+//   - LZ4 compressed block data.
+// Pre-filters:
+// - DELTA8: each byte is the difference with the previous one (PCM8).
+// - DELTA16: the differences between 16 bit samples, as a plane of the low bytes followed by a plane
+//   of the high bytes (PCM16). An odd last byte is kept as is.
+
+#define CWAV_LZ4_MAGIC 0x5A4C5743 // "CWLZ"
+#define CWAV_LZ4_BLOCK_STORED 0x80000000
+#define CWAV_LZ4_BLOCK_DELTA8 0x40000000
+#define CWAV_LZ4_BLOCK_DELTA16 0x20000000
+#define CWAV_LZ4_BLOCK_FLAGS (CWAV_LZ4_BLOCK_STORED | CWAV_LZ4_BLOCK_DELTA8 | CWAV_LZ4_BLOCK_DELTA16)
+
+typedef struct cwavLz4Header_s
+{
+    u32 magic;
+    u32 decompressedSize;
+    u32 blockSize;
+} cwavLz4Header_t;
+
+int cwavLz4DecompressBlock(const u8* src, u32 srcSize, u8* dst, u32 dstCapacity);
+
+bool cwavLz4ReadHeader(FILE* file, cwavLz4Header_t* header);
+bool cwavLz4ReadFile(FILE* file, const cwavLz4Header_t* header, u8* dst);
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef CWAVREGION_H
+#define CWAVREGION_H
+#include "cwav.h"
+#include "internal/cwav_defs.h"
+
+typedef struct cwavRegionImpl_s
+{
+    char name[CWAV_REGION_NAME_SIZE];
+    // Aligned to the encoding, see cwavAddRegion.
+    u32 start;
+    u32 loopStart;
+    u32 end;
+    bool isLooped;
+    // One per channel with the contexts at the region start and loop start, NULL if the encoding is not ADPCM.
+    cwavIMAADPCMInfo_t* IMAADPCMInfos;
+    cwavDSPADPCMInfo_t* DSPADPCMInfos;
+} cwavRegionImpl_t;
+
+// Offset in bytes of a sample in the data of a channel. Must be aligned for ADPCM.
+u32 cwavRegionSampleOffset(u32 encoding, u32 sample);
+// Aligns a sample down to where playback can start: a DSP ADPCM frame or an IMA ADPCM byte.
+u32 cwavRegionAlign(u32 encoding, u32 sample);
+// Returns the region or NULL if the index is out of range.
+const cwavRegionImpl_t* cwavRegionGet(cwav_t* cwav, int index);
+void cwavRegionFreeAll(cwav_t* cwav);
+// Plays a region like cwavPlayRegion, the region does not need to be stored in the CWAV (defined in cwav.c).
+cwavPlayResult cwavRegionPlay(CWAV* cwav, const cwavRegionImpl_t* region, int leftChannel, int rightChannel);
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef CWAVRESERVE_H
+#define CWAVRESERVE_H
+#include "cwav.h"
+
+// Channels reserved for the CWAV or for the category, its plays use them first.
+u32 cwavReserveGetOwnChannels(const CWAV* cwav, u8 category);
+// Releases the channels reserved for a CWAV that is being freed.
+void cwavReserveForget(const CWAV* cwav);
+// Whether channelCount more voices of the category fit in the global and category channel budgets.
+bool cwavReserveWithinBudget(u8 category, u32 channelCount);
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef CWAVSCHED_H
+#define CWAVSCHED_H
+#include "cwav.h"
+
+#define CWAV_SCHED_FRAME_SAMPLES 160
+
+bool cwavSchedIsRunning();
+// Silence to play before a sound starting at samplePosition, so it starts at the right sample of its frame.
+u32 cwavSchedGetStartDelay(u64 samplePosition);
+// The channel must be held (cwavEnvSetHeld), it is released in the DSP frame samplePosition falls into.
+void cwavSchedVoiceQueued(u32 channel, u64 samplePosition);
+
+#endif
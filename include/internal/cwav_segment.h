@@ -0,0 +1,8 @@
+#ifndef CWAVSEGMENT_H
+#define CWAVSEGMENT_H
+#include "cwav.h"
+
+// Stops the segment players playing a CWAV that is being freed, once the frame hook is done with them.
+void cwavSegmentForget(const CWAV* cwav);
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef CWAVSTATS_H
+#define CWAVSTATS_H
+#include "cwav.h"
+
+#ifndef CWAV_DISABLE_STATS
+extern cwavStats g_cwavStats;
+
+#define CWAV_STATS_ADD(field, value) (g_cwavStats.field += (value))
+#define CWAV_STATS_SUB(field, value) (g_cwavStats.field -= (value))
+#define CWAV_STATS_MAX(field, value) do { if ((value) > g_cwavStats.field) g_cwavStats.field = (value); } while (0)
+#define CWAV_STATS_SET(field, value) (g_cwavStats.field = (value))
+#define CWAV_STATS_GET(field) (g_cwavStats.field)
+#define CWAV_STATS_TICK_START(name) u64 name = svcGetSystemTick()
+#define CWAV_STATS_TICK_END(field, name) (g_cwavStats.field += svcGetSystemTick() - (name))
+#else
+#define CWAV_STATS_ADD(field, value) ((void)(value))
+#define CWAV_STATS_SUB(field, value) ((void)(value))
+#define CWAV_STATS_MAX(field, value) ((void)(value))
+#define CWAV_STATS_SET(field, value) ((void)(value))
+#define CWAV_STATS_GET(field) 0
+#define CWAV_STATS_TICK_START(name) do {} while (0)
+#define CWAV_STATS_TICK_END(field, name) do {} while (0)
+#endif
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef CWAVSTEM_H
+#define CWAVSTEM_H
+#include "cwav.h"
+
+// Plays like cwavPlay, the voices stay held until released with cwavEnvReleaseHeld (defined in cwav.c).
+cwavPlayResult cwavStemPlayHeld(CWAV* cwav, int leftChannel, int rightChannel);
+
+#endif
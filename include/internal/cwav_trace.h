@@ -0,0 +1,21 @@
+#ifndef CWAVTRACE_H
+#define CWAVTRACE_H
+#include "cwav.h"
+
+#ifndef CWAV_DISABLE_TRACE
+extern cwavTraceEvent* g_cwavTraceEvents;
+
+void cwavTraceRecord(cwavTraceEventType_t type, u64 startTick, const void* cwav, u32 status, int channel0, int channel1);
+
+// Events with a start tick get a duration, the rest are instant events.
+// The macros only skip the call cheaply, cwavTraceRecord checks the buffer again.
+#define CWAV_TRACE_BEGIN(name) u64 name = g_cwavTraceEvents ? svcGetSystemTick() : 0
+#define CWAV_TRACE_END(name, type, cwav, status, channel0, channel1) do { if (g_cwavTraceEvents) cwavTraceRecord(type, name, cwav, status, channel0, channel1); } while (0)
+#define CWAV_TRACE_INSTANT(type, cwav, status, channel0, channel1) do { if (g_cwavTraceEvents) cwavTraceRecord(type, 0, cwav, status, channel0, channel1); } while (0)
+#else
+#define CWAV_TRACE_BEGIN(name) do {} while (0)
+#define CWAV_TRACE_END(name, type, cwav, status, channel0, channel1) do {} while (0)
+#define CWAV_TRACE_INSTANT(type, cwav, status, channel0, channel1) do {} while (0)
+#endif
+
+#endif
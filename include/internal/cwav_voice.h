@@ -0,0 +1,41 @@
+#ifndef CWAVVOICE_H
+#define CWAVVOICE_H
+#include "cwav.h"
+
+#define CWAV_VOICE_MAX 32
+#define CWAV_VOICE_MIX_SIZE 12
+
+// State of the last voice started on each environment channel, used to update
+// playing voices without restarting them. Entries are dropped once the channel stops playing.
+typedef struct cwavVoice_s
+{
+    bool active;
+    u8 category;
+    float volume; // CWAV volume when played.
+    float pan;
+    float rate; // Sample rate * pitch when played.
+    u32 firstSample; // Sample of the CWAV the voice started at (the region start).
+    bool customMix;
+    float mix[CWAV_VOICE_MIX_SIZE]; // Custom mix matrix, replaces the pan.
+
+    // Modifiers, combined by cwavVoiceCommit.
+    float categoryGain;
+    float stemGain; // Layer and group volume of a stem group voice.
+    bool spatial;
+    float spatialGains[4]; // Front left, front right, back left, back right.
+    float spatialPitch;
+
+    // Last values sent to the environment.
+    float appliedMix[CWAV_VOICE_MIX_SIZE];
+    float appliedRate;
+} cwavVoice_t;
+
+void cwavVoiceStarted(u32 channel, u8 category, float volume, float pan, const float* mix, float rate, float categoryGain);
+const float* cwavVoiceGetAppliedMix(u32 channel);
+void cwavVoiceSetCustomMix(cwavVoice_t* voice, const float* mix);
+cwavVoice_t* cwavVoiceGetLive(u32 channel);
+cwavVoice_t* cwavVoiceGetActive(u32 channel);
+// Sends the changed mix and rate to the environment, returns false if a change could not be applied (CSND).
+bool cwavVoiceCommit(u32 channel, cwavVoice_t* voice);
+
+#endif
@@ -1,6 +1,22 @@
 #include "cwav.h"
 #include "internal/cwav_defs.h"
 #include "internal/cwav_env.h"
+#include "internal/cwav_alloc.h"
+#include "internal/cwav_dedup.h"
+#include "internal/cwav_lz4.h"
+#include "internal/cwav_stats.h"
+#include "internal/cwav_trace.h"
+#include "internal/cwav_latency.h"
+#include "internal/cwav_category.h"
+#include "internal/cwav_voice.h"
+#include "internal/cwav_sched.h"
+#include "internal/cwav_region.h"
+#include "internal/cwav_stem.h"
+#include "internal/cwav_segment.h"
+#include "internal/cwav_reserve.h"
+#include "internal/cwav_directsound.h"
+#include "internal/cwav_adpcm.h"
+#include "internal/cwav_level.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -45,10 +61,12 @@ static void cwav_DeRegister(CWAV* cwav)
     {
         if (cwavList[i] == cwav)
         {
-            cwavList[i] = NULL;
             cwavAddedToList--;
-            for (int j = i; j < cwavListCount - 1 && cwavList[j+1] != NULL; j++)
+            // The list stays packed, the last moved entry leaves its slot empty.
+            int j = i;
+            for (; j < cwavListCount - 1 && cwavList[j+1] != NULL; j++)
                 cwavList[j] = cwavList[j+1];
+            cwavList[j] = NULL;
             break;
         }
     }
@@ -63,6 +81,8 @@ static void cwav_DeRegister(CWAV* cwav)
 
 static void cwav_UpdatePlayingStatus()
 {
+    CWAV_STATS_TICK_START(startTick);
+    u32 activeVoices = 0;
     for (int i = 0; i < cwavListCount && cwavList[i] != NULL; i++)
     {
         cwav_t* currCwav = CWAVTOIMPL(cwavList[i]);
@@ -73,16 +93,23 @@ static void cwav_UpdatePlayingStatus()
                 if (currCwav->playingChanIds[j][k] == -1)
                     continue;
                 if (!cwavEnvChannelIsPlaying(currCwav->playingChanIds[j][k]))
+                {
+                    CWAV_TRACE_INSTANT(CWAV_TRACE_VOICE_END, cwavList[i], 0, currCwav->playingChanIds[j][k], -1);
                     currCwav->playingChanIds[j][k] = -1;
+                }
+                else
+                    activeVoices++;
             }
         }
     }
+    CWAV_STATS_SET(activeVoices, activeVoices);
+    CWAV_STATS_TICK_END(updateTicks, startTick);
 }
 
 static u32 cwav_parseInfoBlock(cwav_t* cwav)
 {
     u32 infoSize = cwav->cwavHeader->info_blck.size;
-    cwav->cwavInfo = (cwavInfoBlock_t *)((u32)(cwav->fileBuf) + cwav->cwavHeader->info_blck.ref.offset);
+    cwav->cwavInfo = (cwavInfoBlock_t *)((u8*)(cwav->fileBuf) + cwav->cwavHeader->info_blck.ref.offset);
     if (cwav->cwavInfo->header.magic != 0x4F464E49 || cwav->cwavInfo->header.size != infoSize)
         return CWAV_INVAID_INFO_BLOCK;
 
@@ -92,7 +119,7 @@ static u32 cwav_parseInfoBlock(cwav_t* cwav)
     if (!cwavEnvCompatibleEncoding(encoding))
         return CWAV_UNSUPPORTED_AUDIO_ENCODING;
     
-    cwav->channelInfos = (cwavchannelInfo_t**)malloc(4 * cwav->channelcount);
+    cwav->channelInfos = (cwavchannelInfo_t**)malloc(sizeof(cwavchannelInfo_t*) * cwav->channelcount);
 
     for (int i = 0; i < cwav->channelcount; i++)
     {
@@ -107,7 +134,7 @@ static u32 cwav_parseInfoBlock(cwav_t* cwav)
     }
     if (encoding == IMA_ADPCM)
     {
-        cwav->IMAADPCMInfos = (cwavIMAADPCMInfo_t**)malloc(4 * cwav->channelcount);
+        cwav->IMAADPCMInfos = (cwavIMAADPCMInfo_t**)malloc(sizeof(cwavIMAADPCMInfo_t*) * cwav->channelcount);
         for (int i = 0; i < cwav->channelcount; i++)
         {
             if (cwav->channelInfos[i]->ADPCMInfo.refType != IMA_ADPCM_INFO)
@@ -117,7 +144,7 @@ static u32 cwav_parseInfoBlock(cwav_t* cwav)
     } 
     else if (encoding == DSP_ADPCM)
     {
-        cwav->DSPADPCMInfos = (cwavDSPADPCMInfo_t**)malloc(4 * cwav->channelcount);
+        cwav->DSPADPCMInfos = (cwavDSPADPCMInfo_t**)malloc(sizeof(cwavDSPADPCMInfo_t*) * cwav->channelcount);
         for (int i = 0; i < cwav->channelcount; i++)
         {
             if (cwav->channelInfos[i]->ADPCMInfo.refType != DSP_ADPCM_INFO)
@@ -128,13 +155,117 @@ static u32 cwav_parseInfoBlock(cwav_t* cwav)
     return CWAV_SUCCESS;
 }
 
-static void cwav_initialize(CWAV* out, u8 maxSPlays)
+static u32 cwav_encodingDataSize(u32 encoding, u32 samples)
+{
+    switch (encoding)
+    {
+    case DSP_ADPCM:
+        return ((samples + 13) / 14) * 8;
+    case IMA_ADPCM:
+        return (samples + 1) / 2;
+    case PCM8:
+        return samples;
+    case PCM16:
+        return samples * 2;
+    default:
+        return 0;
+    }
+}
+
+static inline u32 cwav_channelDataSize(cwav_t* cwav)
+{
+    return cwav_encodingDataSize(cwav->cwavInfo->encoding, cwav->cwavInfo->LoopEnd);
+}
+
+static inline void* cwav_fileSampleData(cwav_t* cwav, int channel)
+{
+    return (u8*)(cwav->channelInfos[channel]->samples.offset + (u8*)(&(cwav->cwavData->data)));
+}
+
+// Releases the shared copies and points all the channels back to the sample data in the file.
+static void cwav_unshareSampleData(cwav_t* cwav, int channelCount)
+{
+    for (int i = 0; i < channelCount; i++)
+    {
+        void* fileData = cwav_fileSampleData(cwav, i);
+        if (cwav->sampleData[i] != fileData)
+        {
+            cwavDedupRelease(cwav->sampleData[i]);
+            cwav->sampleData[i] = fileData;
+        }
+    }
+}
+
+static void cwav_resolveSampleData(cwav_t* cwav, bool dedup)
+{
+    cwav->sampleData = (void**)malloc(sizeof(void*) * cwav->channelcount);
+    u32 size = cwav_channelDataSize(cwav);
+    for (int i = 0; i < cwav->channelcount; i++)
+    {
+        cwav->sampleData[i] = cwav_fileSampleData(cwav, i);
+        if (!dedup)
+            continue;
+
+        // The file buffer can only be freed if every channel is shared, otherwise the copies would
+        // only add memory: all the channels keep using the sample data in the file.
+        void* shared = cwavDedupAcquire(cwav->sampleData[i], size);
+        if (!shared)
+        {
+            cwav_unshareSampleData(cwav, i);
+            dedup = false;
+            continue;
+        }
+        cwav->sampleData[i] = shared;
+    }
+}
+
+static inline bool cwav_isFileSampleData(cwav_t* cwav, int channel)
+{
+    u8* fileStart = (u8*)cwav->fileBuf;
+    u8* fileEnd = fileStart + cwav->cwavHeader->fileSize;
+    return (u8*)cwav->sampleData[channel] >= fileStart && (u8*)cwav->sampleData[channel] < fileEnd;
+}
+
+static bool cwav_usesFileSampleData(cwav_t* cwav)
+{
+    for (int i = 0; i < cwav->channelcount; i++)
+    {
+        if (cwav_isFileSampleData(cwav, i))
+            return true;
+    }
+    return false;
+}
+
+// Includes the IMA ADPCM copy of transcoded CWAVs. Shared copies are counted once by the deduplication.
+static u32 cwav_sampleBytes(cwav_t* cwav)
+{
+    u32 size = 0;
+    for (int i = 0; i < cwav->channelcount; i++)
+    {
+        if (cwav_isFileSampleData(cwav, i))
+            size += cwav_channelDataSize(cwav);
+    }
+    if (cwav->transcodedData)
+        size += cwav_encodingDataSize(IMA_ADPCM, cwav->cwavInfo->LoopEnd) * cwav->channelcount;
+    return size;
+}
+
+static u32 cwav_metadataSize(cwav_t* cwav)
+{
+    u32 pointerArrays = (cwav->IMAADPCMInfos || cwav->DSPADPCMInfos) ? 3 : 2;
+    return sizeof(cwav_t) + cwav->channelcount * sizeof(void*) * pointerArrays +
+        cwav->totalMultiplePlay * (sizeof(int*) + cwav->channelcount * (sizeof(int) + sizeof(u32))) +
+        (cwav->levelEnvelope ? cwavLevelEnvelopeSize(cwav) : 0);
+}
+
+static void cwav_initialize(CWAV* out, u8 maxSPlays, bool dedup)
 {
     cwav_t* cwav = CWAVTOIMPL(out);
 
     out->monoPan = 0.f;
     out->volume = 1.f;
     out->pitch = 1.f;
+    out->category = CWAV_CATEGORY_SFX;
 
     if (maxSPlays == 0)
     {
@@ -156,13 +287,18 @@ static void cwav_initialize(CWAV* out, u8 maxSPlays)
         return;
     }
 
-    cwav->cwavData = (cwavDataBlock_t*)((u32)(cwav->fileBuf) + cwav->cwavHeader->data_blck.ref.offset); 
+    cwav->cwavData = (cwavDataBlock_t*)((u8*)(cwav->fileBuf) + cwav->cwavHeader->data_blck.ref.offset); 
     if (cwav->cwavData->header.magic != 0x41544144)
     {
         out->loadStatus = CWAV_INVAID_DATA_BLOCK;
         return;
     }
 
+    cwav_resolveSampleData(cwav, dedup);
+
+    if (cwavLevelIsEnabled())
+        cwavLevelBuild(cwav);
+
     cwav->totalMultiplePlay = maxSPlays;
     cwav->playingChanIds = (int**)malloc(cwav->totalMultiplePlay * sizeof(int*));
     for (int i = 0; i < cwav->totalMultiplePlay; i++)
@@ -171,6 +307,7 @@ static void cwav_initialize(CWAV* out, u8 maxSPlays)
         for (int j = 0; j < cwav->channelcount; j++)
             cwav->playingChanIds[i][j] = -1;
     }
+    cwav->playingSerials = (u32*)calloc(cwav->totalMultiplePlay * cwav->channelcount, sizeof(u32));
     
     cwav->currMultiplePlay = 0;
     out->sampleRate = cwav->cwavInfo->sampleRate;
@@ -179,11 +316,10 @@ static void cwav_initialize(CWAV* out, u8 maxSPlays)
 
     cwav_Register(out);
     out->loadStatus = CWAV_SUCCESS;
-}
 
-static inline u32 cwavDspSamplesToBytes(u32 samples)
-{
-    return (samples / 14) * 8;
+    CWAV_STATS_ADD(registeredCwavs, 1);
+    CWAV_STATS_ADD(sampleBytes, cwav_sampleBytes(cwav));
+    CWAV_STATS_ADD(metadataBytes, cwav_metadataSize(cwav));
 }
 
 static void cwav_stopImpl(cwav_t* cwav, int leftChannel, int rightChannel, u8 multipleID)
@@ -220,6 +356,61 @@ static void cwav_stopImpl(cwav_t* cwav, int leftChannel, int rightChannel, u8 mu
     }
 }
 
+CWAV* cwav_GetRelocatable(void* buffer, size_t size)
+{
+    CWAV* owner = NULL;
+    for (int i = 0; i < cwavListCount && cwavList[i] != NULL; i++)
+    {
+        u8* fileBuf = (u8*)CWAVTOIMPL(cwavList[i])->fileBuf;
+        if (fileBuf < (u8*)buffer || fileBuf >= (u8*)buffer + size)
+            continue;
+        // Buffers shared by multiple CWAVs (e.g: batch loads) are never moved.
+        if (owner)
+            return NULL;
+        owner = cwavList[i];
+    }
+    if (!owner || CWAVTOIMPL(owner)->fileBuf != buffer || owner->dataBuffer != buffer || cwavIsPlaying(owner))
+        return NULL;
+    return owner;
+}
+
+#define CWAV_REBASE(ptr, delta) ptr = (void*)((u8*)(ptr) + (delta))
+
+void cwav_Relocate(CWAV* cwav, void* newBuffer)
+{
+    cwav_t* cwav_ = CWAVTOIMPL(cwav);
+    ptrdiff_t delta = (u8*)newBuffer - (u8*)cwav_->fileBuf;
+
+    // Only the sample data stored in the file buffer moves, shared copies stay in place.
+    u8* fileStart = (u8*)cwav_->fileBuf;
+    u8* fileEnd = fileStart + cwav_->cwavHeader->fileSize;
+    for (int i = 0; i < cwav_->channelcount; i++)
+    {
+        if ((u8*)cwav_->sampleData[i] >= fileStart && (u8*)cwav_->sampleData[i] < fileEnd)
+            CWAV_REBASE(cwav_->sampleData[i], delta);
+    }
+
+    CWAV_REBASE(cwav_->fileBuf, delta);
+    CWAV_REBASE(cwav_->cwavHeader, delta);
+    CWAV_REBASE(cwav_->cwavInfo, delta);
+    if (cwav_->cwavData)
+        CWAV_REBASE(cwav_->cwavData, delta);
+    for (int i = 0; i < cwav_->channelcount; i++)
+    {
+        CWAV_REBASE(cwav_->channelInfos[i], delta);
+        if (cwav_->IMAADPCMInfos)
+            CWAV_REBASE(cwav_->IMAADPCMInfos[i], delta);
+        if (cwav_->DSPADPCMInfos)
+            CWAV_REBASE(cwav_->DSPADPCMInfos[i], delta);
+    }
+    cwav->dataBuffer = newBuffer;
+}
+
+bool cwavSetFrameCallback(ndspCallback callback, void* data)
+{
+    return cwavEnvSetAppFrameCallback(callback, data);
+}
+
 void cwavUseEnvironment(cwavEnvMode_t envMode)
 {
     cwavEnvUseEnvironment(envMode);
@@ -236,7 +427,8 @@ void cwavSetVAToPACallback(vaToPaCallback_t callback)
         cwavCurrentVAPAConvCallback = cwav_defaultVAToPA;
 }
 
-void cwavLoad(CWAV* out, const void* bcwavFileBuffer, u8 maxSPlays)
+// Deduplication copies the sample data out of the buffer, so it is only done when the buffer is shrunk afterwards.
+static void cwav_loadImpl(CWAV* out, const void* bcwavFileBuffer, u8 maxSPlays, bool dedup)
 {
     if (!out) return;
     cwav_t* cwav = malloc(sizeof(cwav_t));
@@ -251,7 +443,17 @@ void cwavLoad(CWAV* out, const void* bcwavFileBuffer, u8 maxSPlays)
 
     cwav->fileBuf = (void*)bcwavFileBuffer;
 
-    cwav_initialize(out, maxSPlays);
+    CWAV_TRACE_BEGIN(traceTick);
+    CWAV_STATS_TICK_START(startTick);
+    cwav_initialize(out, maxSPlays, dedup);
+    CWAV_STATS_TICK_END(loadTicks, startTick);
+    CWAV_STATS_ADD(loads, 1);
+    CWAV_TRACE_END(traceTick, CWAV_TRACE_LOAD, out, out->loadStatus, -1, -1);
+}
+
+void cwavLoad(CWAV* out, const void* bcwavFileBuffer, u8 maxSPlays)
+{
+    cwav_loadImpl(out, bcwavFileBuffer, maxSPlays, false);
 }
 
 void cwavFree(CWAV* cwav)
@@ -266,32 +468,170 @@ void cwavFree(CWAV* cwav)
         {
             cwavStop(cwav, -1, -1);
             cwav_DeRegister(cwav);
+            cwavReserveForget(cwav);
+            cwavSegmentForget(cwav);
+#ifndef CWAV_DISABLE_CSND
+            cwavDirectSoundForget(cwav);
+#endif
+
+            CWAV_STATS_SUB(registeredCwavs, 1);
+            CWAV_STATS_SUB(sampleBytes, cwav_sampleBytes(cwav_));
+            CWAV_STATS_SUB(metadataBytes, cwav_metadataSize(cwav_));
 
             for (int i = 0; i < cwav_->totalMultiplePlay; i++)
                 free(cwav_->playingChanIds[i]);
             
             free(cwav_->playingChanIds);
+            free(cwav_->playingSerials);
         }
+        cwavRegionFreeAll(cwav_);
+#ifndef CWAV_DISABLE_CSND
+        cwavAdpcmFreeTranscoded(cwav_);
+#endif
+        cwavLevelFree(cwav_);
         if (cwav_->channelInfos)
             free(cwav_->channelInfos);
         if (cwav_->IMAADPCMInfos)
             free(cwav_->IMAADPCMInfos);
         if (cwav_->DSPADPCMInfos)
             free(cwav_->DSPADPCMInfos);
+        if (cwav_->sampleData)
+        {
+            for (int i = 0; i < cwav_->channelcount; i++)
+                cwavDedupRelease(cwav_->sampleData[i]);
+            free(cwav_->sampleData);
+        }
         free(cwav_);
         cwav->cwav = NULL;
     }
     cwav->loadStatus = CWAV_NOT_ALLOCATED;
 }
 
-#if defined(_MSC_VER)
-#define __cwav__weak // This fixes intellisense
-#else
-#define __cwav__weak __attribute__((weak))
-#endif
-// By defining these as weak and in the case they are not defined, they won't be called instead of the compiler erroring.
-void* __cwav__weak linearAlloc(size_t size);
-void  __cwav__weak linearFree(void* mem);
+// Checks that [offset, offset + size) is inside [0, limit) without overflowing.
+static inline bool cwav_inBounds(u32 offset, u32 size, u32 limit)
+{
+    return offset <= limit && size <= limit - offset;
+}
+
+cwavStatus_t cwavInspect(const void* bcwavFileBuffer, size_t bufferSize, cwavInfo* out)
+{
+    if (!bcwavFileBuffer || !out || ((uintptr_t)bcwavFileBuffer & 3))
+        return CWAV_INVALID_ARGUMENT;
+
+    const u8* file = (const u8*)bcwavFileBuffer;
+    const cwavHeader_t* header = (const cwavHeader_t*)file;
+    if (bufferSize < sizeof(cwavHeader_t) || header->magic != 0x56415743 || header->endian != 0xFEFF || header->version != 0x02010000 || header->blockCount != 2)
+        return CWAV_UNKNOWN_FILE_FORMAT;
+    if (header->fileSize > bufferSize)
+        return CWAV_FILE_READ_FAILED;
+    u32 fileSize = header->fileSize;
+
+    // INFO block
+    u32 infoOffset = header->info_blck.ref.offset;
+    u32 infoSize = header->info_blck.size;
+    if ((infoOffset & 3) || !cwav_inBounds(infoOffset, infoSize, fileSize) || infoSize < sizeof(cwavInfoBlock_t))
+        return CWAV_INVAID_INFO_BLOCK;
+    const cwavInfoBlock_t* info = (const cwavInfoBlock_t*)(file + infoOffset);
+    if (info->header.magic != 0x4F464E49 || info->header.size != infoSize)
+        return CWAV_INVAID_INFO_BLOCK;
+    if (info->encoding > IMA_ADPCM)
+        return CWAV_UNSUPPORTED_AUDIO_ENCODING;
+    if (info->sampleRate == 0 || info->loopStart > info->LoopEnd)
+        return CWAV_INVAID_INFO_BLOCK;
+
+    // References inside the INFO block are relative to the start of the reference table.
+    // The blocks and channel infos must be 4 byte aligned and the ADPCM infos 2 byte aligned, as they are accessed as structs.
+    u32 tableOffset = (u32)((const u8*)&info->channelInfoRefs - (const u8*)info);
+    u32 tableSize = infoSize - tableOffset;
+    u32 channelCount = info->channelInfoRefs.count;
+    if (channelCount == 0 || channelCount > 0xFF || channelCount > (tableSize - sizeof(u32)) / sizeof(cwavReference_t))
+        return CWAV_INVAID_INFO_BLOCK;
+
+    // DATA block
+    u32 dataOffset = header->data_blck.ref.offset;
+    u32 dataSize = header->data_blck.size;
+    if ((dataOffset & 3) || !cwav_inBounds(dataOffset, dataSize, fileSize) || dataSize < sizeof(cwavBlockHeader_t))
+        return CWAV_INVAID_DATA_BLOCK;
+    const cwavBlockHeader_t* data = (const cwavBlockHeader_t*)(file + dataOffset);
+    if (data->magic != 0x41544144)
+        return CWAV_INVAID_DATA_BLOCK;
+
+    // Sample offsets are relative to the end of the DATA block header.
+    u32 samplesSize = dataSize - sizeof(cwavBlockHeader_t);
+    u32 channelDataSize = cwav_encodingDataSize(info->encoding, info->LoopEnd);
+    const u8* table = (const u8*)&info->channelInfoRefs;
+    for (u32 i = 0; i < channelCount; i++)
+    {
+        const cwavReference_t* ref = &info->channelInfoRefs.references[i];
+        if (ref->refType != CHANNEL_INFO || (ref->offset & 3) || !cwav_inBounds(ref->offset, sizeof(cwavchannelInfo_t), tableSize))
+            return CWAV_INVAID_INFO_BLOCK;
+
+        const cwavchannelInfo_t* channelInfo = (const cwavchannelInfo_t*)(table + ref->offset);
+        if (channelInfo->samples.refType != SAMPLE_DATA || !cwav_inBounds(channelInfo->samples.offset, channelDataSize, samplesSize))
+            return CWAV_INVAID_INFO_BLOCK;
+
+        // ADPCM info references are relative to the start of the channel info.
+        u32 channelInfoOffset = ref->offset;
+        if (info->encoding == DSP_ADPCM)
+        {
+            if (channelInfo->ADPCMInfo.refType != DSP_ADPCM_INFO || (channelInfo->ADPCMInfo.offset & 1) ||
+                !cwav_inBounds(channelInfo->ADPCMInfo.offset, sizeof(cwavDSPADPCMInfo_t), tableSize - channelInfoOffset))
+                return CWAV_INVAID_INFO_BLOCK;
+        }
+        else if (info->encoding == IMA_ADPCM)
+        {
+            if (channelInfo->ADPCMInfo.refType != IMA_ADPCM_INFO || (channelInfo->ADPCMInfo.offset & 1) ||
+                !cwav_inBounds(channelInfo->ADPCMInfo.offset, sizeof(cwavIMAADPCMInfo_t), tableSize - channelInfoOffset))
+                return CWAV_INVAID_INFO_BLOCK;
+        }
+    }
+
+    out->encoding = (cwavAudioEncoding_t)info->encoding;
+    out->numChannels = (u8)channelCount;
+    out->isLooped = info->isLooped != 0;
+    out->sampleRate = info->sampleRate;
+    out->loopStart = info->loopStart;
+    out->loopEnd = info->LoopEnd;
+    out->duration = (float)info->LoopEnd / (float)info->sampleRate;
+    out->linearMemorySize = fileSize;
+    out->sampleDataSize = channelDataSize * channelCount;
+    // Pointer arrays allocated by cwavLoad: channel infos, sample data and ADPCM infos.
+    out->heapMemorySize = sizeof(cwav_t) + channelCount * sizeof(void*) * ((info->encoding == DSP_ADPCM || info->encoding == IMA_ADPCM) ? 3 : 2);
+    if (cwavLevelIsEnabled())
+        out->heapMemorySize += ((info->LoopEnd + CWAV_LEVEL_BLOCK_SAMPLES - 1) / CWAV_LEVEL_BLOCK_SAMPLES) * channelCount * 2 * sizeof(u16);
+    out->heapMemoryPerPlay = sizeof(int*) + channelCount * (sizeof(int) + sizeof(u32));
+    out->csndMemorySize = info->encoding == DSP_ADPCM ? cwav_encodingDataSize(IMA_ADPCM, info->LoopEnd) * channelCount : 0;
+    return CWAV_SUCCESS;
+}
+
+// Gets the size the file takes once loaded, which is the decompressed size for compressed files.
+// Leaves the file positioned at the start of the data to pass to cwav_fileRead.
+static bool cwav_fileGetLoadSize(FILE* file, size_t* size, cwavLz4Header_t* lz4Header)
+{
+    if (cwavLz4ReadHeader(file, lz4Header))
+    {
+        *size = lz4Header->decompressedSize;
+        return true;
+    }
+
+    if (fseek(file, 0, SEEK_END))
+        return false;
+
+    long end = ftell(file);
+    if (end < 0 || fseek(file, 0, SEEK_SET))
+        return false;
+
+    *size = (size_t)end;
+    return true;
+}
+
+static bool cwav_fileRead(FILE* file, void* buffer, size_t size, const cwavLz4Header_t* lz4Header)
+{
+    if (lz4Header->magic == CWAV_LZ4_MAGIC)
+        return cwavLz4ReadFile(file, lz4Header, (u8*)buffer);
+
+    return fread(buffer, 1, size, file) == size;
+}
 
 void cwavFileLoad(CWAV* out, const char* bcwavFileName, u8 maxSPlays)
 {
@@ -306,6 +646,7 @@ void cwavFileObjectLoad(CWAV* out, FILE* bcwavFileObject, u8 maxSPlays) {
     FILE* file = bcwavFileObject;
     size_t fileSize = 0;
     void* buffer = NULL;
+    cwavLz4Header_t lz4Header = {0};
 
     if (!out)
         goto exit;
@@ -318,31 +659,58 @@ void cwavFileObjectLoad(CWAV* out, FILE* bcwavFileObject, u8 maxSPlays) {
         goto exit;
     }
 
-    if (fseek(file, 0, SEEK_END)) {
+    if (!cwav_fileGetLoadSize(file, &fileSize, &lz4Header)) {
         out->loadStatus = CWAV_FILE_OPEN_FAILED;
         goto exit;
     }
-        
-    fileSize = ftell(file);
-    fseek(file, 0, SEEK_SET);
 
-    buffer = linearAlloc(fileSize); // In the case linearAlloc is not defined, buffer will keep it's NULL value.
+    buffer = cwavAllocLinear(fileSize);
     if (!buffer)
     {
         out->loadStatus = CWAV_FILE_READ_FAILED;
         goto exit;   
     }
 
-    if (fread(buffer, 1, fileSize, file) != fileSize)
+    CWAV_STATS_TICK_START(startTick);
+    bool readSuccess = cwav_fileRead(file, buffer, fileSize, &lz4Header);
+    CWAV_STATS_TICK_END(fileReadTicks, startTick);
+    if (!readSuccess)
     {
         out->loadStatus = CWAV_FILE_READ_FAILED;
-        linearFree(buffer);
+        cwavAllocFree(buffer);
         goto exit;
     }
 
-    cwavLoad(out, buffer, maxSPlays);
+    // The buffer can only be shrunk to the metadata if the INFO block comes before the sample data.
+    const cwavHeader_t* header = (const cwavHeader_t*)buffer;
+    bool dedup = cwavDedupIsEnabled() && fileSize >= sizeof(cwavHeader_t) &&
+        header->info_blck.ref.offset + header->info_blck.size <= header->data_blck.ref.offset;
+    cwav_loadImpl(out, buffer, maxSPlays, dedup);
     out->dataBuffer = buffer;
 
+    // If all the channels use shared sample data, only the header and INFO block need to be kept.
+    if (out->loadStatus == CWAV_SUCCESS && dedup && !cwav_usesFileSampleData(CWAVTOIMPL(out)))
+    {
+        cwav_t* cwav = CWAVTOIMPL(out);
+        u32 metadataSize = cwav->cwavHeader->data_blck.ref.offset;
+        void* metadataBuffer = cwavAllocLinear(metadataSize);
+        if (metadataBuffer)
+        {
+            memcpy(metadataBuffer, buffer, metadataSize);
+            cwav_Relocate(out, metadataBuffer);
+            cwav->cwavHeader->fileSize = metadataSize;
+            cwav->cwavData = NULL;
+            cwavAllocFree(buffer);
+        }
+        else
+        {
+            // The whole file stays loaded, so the shared copies would only add memory.
+            CWAV_STATS_SUB(sampleBytes, cwav_sampleBytes(cwav));
+            cwav_unshareSampleData(cwav, cwav->channelcount);
+            CWAV_STATS_ADD(sampleBytes, cwav_sampleBytes(cwav));
+        }
+    }
+
 exit:
     return;
 }
@@ -355,20 +723,212 @@ void cwavFileFree(CWAV* cwav)
     cwavFree(cwav);
 
     if (cwav->dataBuffer)
-        linearFree(cwav->dataBuffer);
+        cwavAllocFree(cwav->dataBuffer);
+}
+
+#define CWAV_BATCH_MAX_THREADS 4
+#define CWAV_BATCH_STACK_SIZE 0x2000
+#define CWAV_BATCH_ALIGNMENT 0x80
+
+typedef struct cwavBatchLoad_s
+{
+    CWAV** out;
+    const char** fileNames;
+    size_t* fileSizes;
+    u8* linearBlock;
+    u32 count;
+    u32 nextFile;
+    bool readPass;
+} cwavBatchLoad_t;
+
+static inline size_t cwav_batchAlign(size_t size)
+{
+    return (size + CWAV_BATCH_ALIGNMENT - 1) & ~(CWAV_BATCH_ALIGNMENT - 1);
+}
+
+static void cwav_batchWorker(void* arg)
+{
+    cwavBatchLoad_t* batch = (cwavBatchLoad_t*)arg;
+    while (true)
+    {
+        u32 i = AtomicPostIncrement(&batch->nextFile);
+        if (i >= batch->count)
+            break;
+
+        CWAV* out = batch->out[i];
+        if (!batch->readPass)
+        {
+            // First pass, only get the file sizes so the linear block can be allocated.
+            batch->fileSizes[i] = 0;
+            cwavLz4Header_t lz4Header;
+            FILE* file = fopen(batch->fileNames[i], "rb");
+            if (!file || !cwav_fileGetLoadSize(file, &batch->fileSizes[i], &lz4Header))
+                out->loadStatus = CWAV_FILE_OPEN_FAILED;
+            else
+                out->loadStatus = CWAV_SUCCESS;
+            if (file)
+                fclose(file);
+        }
+        else if (out->loadStatus == CWAV_SUCCESS)
+        {
+            // Second pass, read the file into its slot of the linear block. The files are opened again instead of
+            // staying open since the first pass, so a batch never holds more FS handles than there are workers.
+            // Compressed files are decompressed while reading, overlapping with the other workers I/O.
+            cwavLz4Header_t lz4Header;
+            size_t size = 0;
+            FILE* file = fopen(batch->fileNames[i], "rb");
+            if (!file || !cwav_fileGetLoadSize(file, &size, &lz4Header) || size != batch->fileSizes[i] ||
+                !cwav_fileRead(file, out->dataBuffer, size, &lz4Header))
+                out->loadStatus = CWAV_FILE_READ_FAILED;
+            if (file)
+                fclose(file);
+        }
+    }
+}
+
+static void cwav_batchRun(cwavBatchLoad_t* batch)
+{
+    // Try to spawn one worker per core. Cores that are not available to the
+    // application (e.g: syscore without APT_SetAppCpuTimeLimit) make threadCreate fail.
+    static const int batchCores[CWAV_BATCH_MAX_THREADS] = {0, 1, 2, 3};
+    Thread threads[CWAV_BATCH_MAX_THREADS] = {0};
+    s32 prio = 0x30;
+    svcGetThreadPriority(&prio, CUR_THREAD_HANDLE);
+
+    batch->nextFile = 0;
+    u32 threadAmount = batch->count < CWAV_BATCH_MAX_THREADS ? batch->count : CWAV_BATCH_MAX_THREADS;
+    for (u32 i = 0; i < threadAmount; i++)
+        threads[i] = threadCreate(cwav_batchWorker, batch, CWAV_BATCH_STACK_SIZE, prio, batchCores[i], false);
+
+    // The calling thread also takes work, so the batch completes even if no thread could be created.
+    cwav_batchWorker(batch);
+
+    for (u32 i = 0; i < threadAmount; i++)
+    {
+        if (!threads[i])
+            continue;
+        threadJoin(threads[i], U64_MAX);
+        threadFree(threads[i]);
+    }
+}
+
+void cwavFileLoadBatch(CWAV** out, const char** bcwavFileNames, const u8* maxSPlays, u32 count)
+{
+    if (!out || !bcwavFileNames || !maxSPlays || !count)
+        return;
+
+    cwavBatchLoad_t batch = {0};
+    batch.out = out;
+    batch.fileNames = bcwavFileNames;
+    batch.count = count;
+    batch.fileSizes = malloc(count * sizeof(size_t));
+    if (!batch.fileSizes)
+    {
+        for (u32 i = 0; i < count; i++)
+        {
+            out[i]->cwav = NULL;
+            out[i]->dataBuffer = NULL;
+            out[i]->loadStatus = CWAV_FILE_READ_FAILED;
+        }
+        return;
+    }
+
+    for (u32 i = 0; i < count; i++)
+    {
+        out[i]->cwav = NULL;
+        out[i]->dataBuffer = NULL;
+    }
+
+    CWAV_STATS_TICK_START(startTick);
+    batch.readPass = false;
+    cwav_batchRun(&batch);
+
+    size_t totalSize = 0;
+    for (u32 i = 0; i < count; i++)
+        totalSize += cwav_batchAlign(batch.fileSizes[i]);
+
+    if (totalSize)
+        batch.linearBlock = cwavAllocLinear(totalSize);
+
+    // Every file that could be opened gets its slot, even if the read fails later.
+    // This way the first non NULL dataBuffer is always the start of the linear block.
+    size_t offset = 0;
+    for (u32 i = 0; i < count; i++)
+    {
+        if (out[i]->loadStatus != CWAV_SUCCESS)
+            continue;
+        if (!batch.linearBlock)
+        {
+            out[i]->loadStatus = CWAV_FILE_READ_FAILED;
+            continue;
+        }
+        out[i]->dataBuffer = batch.linearBlock + offset;
+        offset += cwav_batchAlign(batch.fileSizes[i]);
+    }
+
+    if (batch.linearBlock)
+    {
+        batch.readPass = true;
+        cwav_batchRun(&batch);
+    }
+    CWAV_STATS_TICK_END(fileReadTicks, startTick);
+
+    // Parsing registers the CWAVs globally, so it is done from the calling thread.
+    for (u32 i = 0; i < count; i++)
+    {
+        if (out[i]->loadStatus != CWAV_SUCCESS)
+            continue;
+        void* buffer = out[i]->dataBuffer;
+        cwavLoad(out[i], buffer, maxSPlays[i]);
+        out[i]->dataBuffer = buffer;
+    }
+
+    free(batch.fileSizes);
+}
+
+void cwavFileFreeBatch(CWAV** cwavs, u32 count)
+{
+    if (!cwavs)
+        return;
+
+    void* linearBlock = NULL;
+    for (u32 i = 0; i < count; i++)
+    {
+        if (!cwavs[i])
+            continue;
+        cwavFree(cwavs[i]);
+        if (!linearBlock)
+            linearBlock = cwavs[i]->dataBuffer;
+        cwavs[i]->dataBuffer = NULL;
+    }
+
+    if (linearBlock)
+        cwavAllocFree(linearBlock);
 }
 
 #ifndef CWAV_DISABLE_CSND
-bool cwavPlayAsDirectSound(CWAV* cwav, int leftChannel, int rightChannel, u32 directSoundChannel, u32 directSoundPriority, ncsndDirectSoundModifiers* soundModifiers)
+bool cwavPlayAsDirectSound(CWAV* cwav, int leftChannel, int rightChannel, u32 directSoundChannel, u32 directSoundPriority, const ncsndDirectSoundModifiers* soundModifiers)
 {
-    if (cwavEnvGetEnvironment() != CWAV_ENV_CSND || !cwav || cwav->loadStatus != CWAV_SUCCESS)
+    if (cwavEnvGetEnvironment() != CWAV_ENV_CSND || !cwav || cwav->loadStatus != CWAV_SUCCESS || cwav->isLooped)
         return false;
     
-    return cwavEnvPlayDirectSound(cwav, leftChannel, rightChannel, directSoundChannel, directSoundPriority, soundModifiers);
+    return cwavEnvPlayDirectSound(cwav, leftChannel, rightChannel, directSoundChannel, directSoundPriority, soundModifiers, false);
 }
 #endif
 
-cwavPlayResult cwavPlay(CWAV* cwav, int leftChannel, int rightChannel)
+// Sample position of the plays that are not scheduled.
+#define CWAV_PLAY_NOW UINT64_MAX
+
+typedef struct cwav_playOptions_s
+{
+    const float* leftMix;
+    const float* rightMix;
+    u64 samplePosition;
+    const cwavRegionImpl_t* region; // NULL to play the whole CWAV.
+    bool held; // The voices wait until released with cwavEnvReleaseHeld.
+} cwav_playOptions_t;
+
+static cwavPlayResult cwav_playImpl(CWAV* cwav, int leftChannel, int rightChannel, const cwav_playOptions_t* options)
 {
     cwavPlayResult ret;
     if (!cwav || cwav->loadStatus != CWAV_SUCCESS)
@@ -390,101 +950,82 @@ cwavPlayResult cwavPlay(CWAV* cwav, int leftChannel, int rightChannel)
         return ret;
     }
 
+#ifndef CWAV_DISABLE_CSND
+    if (cwavEnvGetEnvironment() == CWAV_ENV_CSND && !cwavAdpcmPrepareCsnd(cwav_))
+    {
+        ret.playStatus = CWAV_UNSUPPORTED_AUDIO_ENCODING;
+        return ret;
+    }
+#endif
+
     cwav_UpdatePlayingStatus();
 
     cwav_->currMultiplePlay++;
     if (cwav_->currMultiplePlay >= cwav_->totalMultiplePlay)
         cwav_->currMultiplePlay = 0;
+
+    u32 stolenVoices = (cwav_->playingChanIds[cwav_->currMultiplePlay][leftChannel] != -1) +
+        (stereo && cwav_->playingChanIds[cwav_->currMultiplePlay][rightChannel] != -1);
+    CWAV_STATS_ADD(voicesStolen, stolenVoices);
+    CWAV_STATS_SUB(activeVoices, stolenVoices);
     
     cwav_stopImpl(cwav_, leftChannel, rightChannel, cwav_->currMultiplePlay);
 
+    // Sample range to play, the loop start of the whole CWAV is passed as is even if it does not loop.
+    const cwavRegionImpl_t* region = options->region;
+    u32 encoding = cwavAdpcmPlayEncoding(cwav_);
+    u32 start = region ? region->start : 0;
+    u32 loopStart = region ? region->loopStart : cwav_->cwavInfo->loopStart;
+    u32 end = region ? region->end : cwav_->cwavInfo->LoopEnd;
+    bool isLooped = region ? region->isLooped : cwav_->cwavInfo->isLooped;
+    u32 startOffset = cwavRegionSampleOffset(encoding, start);
+    u32 size = cwavRegionSampleOffset(encoding, end) - startOffset;
+
+    if (!cwavReserveWithinBudget(cwav->category, stereo ? 2 : 1))
+    {
+        ret.playStatus = CWAV_NO_CHANNEL_AVAILABLE;
+        return ret;
+    }
+
+    // Channels reserved for this CWAV or its category are used first, the ones reserved for others never.
+    u32 ownChannels = cwavReserveGetOwnChannels(cwav, cwav->category);
+    u32 otherChannels = cwavGetReservedChannels() & ~ownChannels;
+
     int prevchan = -1;
     for (int i = 0; i < ((stereo) ? 2 : 1); i++)
     {
+        int cwavChannel = i ? rightChannel : leftChannel;
 
-        cwav_->playingChanIds[cwav_->currMultiplePlay][i ? rightChannel : leftChannel] = -1;
+        cwav_->playingChanIds[cwav_->currMultiplePlay][cwavChannel] = -1;
         u32 totChanAm = cwavEnvGetChannelAmount();
-        for (int j = 0; j < totChanAm; j++)
+        for (int pass = ownChannels ? 0 : 1; pass < 2 && cwav_->playingChanIds[cwav_->currMultiplePlay][cwavChannel] == -1; pass++)
         {
-            if (!cwavEnvIsChannelAvailable(j) || j == prevchan || cwavEnvChannelIsPlaying(j)) 
-                continue;
-            cwav_->playingChanIds[cwav_->currMultiplePlay][i ? rightChannel : leftChannel] = j;
-            break;
+            u32 skipped = pass == 0 ? ~ownChannels : ownChannels | otherChannels;
+            for (int j = 0; j < totChanAm; j++)
+            {
+                if (((skipped >> j) & 1) || !cwavEnvIsChannelAvailable(j) || j == prevchan || cwavEnvChannelIsPlaying(j)) 
+                    continue;
+                cwav_->playingChanIds[cwav_->currMultiplePlay][cwavChannel] = j;
+                break;
+            }
         }
-        if (cwav_->playingChanIds[cwav_->currMultiplePlay][i ? rightChannel : leftChannel] == -1)
+        if (cwav_->playingChanIds[cwav_->currMultiplePlay][cwavChannel] == -1)
         {
             ret.playStatus = CWAV_NO_CHANNEL_AVAILABLE;
             return ret;
         }
 
-        prevchan = cwav_->playingChanIds[cwav_->currMultiplePlay][i ? rightChannel : leftChannel];
+        prevchan = cwav_->playingChanIds[cwav_->currMultiplePlay][cwavChannel];
 
-        u8* block0 = NULL;
-        u8* block1 = NULL;
-        u32 size = 0;
-        u32 encoding = cwav_->cwavInfo->encoding;
+        u8* data = (u8*)cwavAdpcmPlayData(cwav_, cwavChannel);
+        u8* block0 = data + startOffset;
+        u8* block1 = isLooped ? data + cwavRegionSampleOffset(encoding, loopStart) : block0;
         cwavIMAADPCMInfo_t* IMAADPCMInfos = NULL;
         cwavDSPADPCMInfo_t* DSPADPCMInfos = NULL;
-
-        block0 = (u8*)((u32)cwav_->channelInfos[i ? rightChannel : leftChannel]->samples.offset + (u8*)(&(cwav_->cwavData->data)));
-
-        switch (encoding)
-        {
-        case DSP_ADPCM:
-            size = cwavDspSamplesToBytes(cwav_->cwavInfo->LoopEnd);
-            if (cwav_->cwavInfo->isLooped)
-            {
-                block1 = cwavDspSamplesToBytes(cwav_->cwavInfo->loopStart) + block0;
-            }
-            else
-            {
-                block1 = block0;
-            }
-
-            DSPADPCMInfos = cwav_->DSPADPCMInfos[i ? rightChannel : leftChannel];
-
-            break;
-        case IMA_ADPCM:
-            size = (cwav_->cwavInfo->LoopEnd / 2);
-            if (cwav_->cwavInfo->isLooped)
-            {
-                block1 = ((cwav_->cwavInfo->loopStart) / 2) + block0;
-            }
-            else
-            {
-                block1 = block0;
-            }
-
-            IMAADPCMInfos = cwav_->IMAADPCMInfos[i ? rightChannel : leftChannel];
-
-            break;
-        case PCM8:
-            size = (cwav_->cwavInfo->LoopEnd);
-            if (cwav_->cwavInfo->isLooped)
-            {
-                block1 = (cwav_->cwavInfo->loopStart) + block0;
-            }
-            else
-            {
-                block1 = block0;
-            }
-
-            break;
-        case PCM16:
-            size = (cwav_->cwavInfo->LoopEnd * 2);
-            if (cwav_->cwavInfo->isLooped)
-            {
-                block1 = ((cwav_->cwavInfo->loopStart) * 2) + block0;
-            }
-            else
-            {
-                block1 = block0;
-            }
-
-            break;
-        default:
-            break;
-        }
+        if (encoding == DSP_ADPCM)
+            DSPADPCMInfos = region ? &region->DSPADPCMInfos[cwavChannel] : cwav_->DSPADPCMInfos[cwavChannel];
+        else if (encoding == IMA_ADPCM)
+            IMAADPCMInfos = region ? &region->IMAADPCMInfos[cwavChannel] : cwavAdpcmPlayImaInfo(cwav_, cwavChannel);
 
         float pan = 0.f;
         float volume = cwav->volume;
@@ -505,7 +1046,22 @@ cwavPlayResult cwavPlay(CWAV* cwav, int leftChannel, int rightChannel)
             pan = cwav->monoPan;
         }
         
-        cwavEnvPlay(cwav_->playingChanIds[cwav_->currMultiplePlay][i ? rightChannel : leftChannel], cwav_->cwavInfo->isLooped, encoding, cwav_->cwavInfo->sampleRate, volume, pan, pitch, block0, block1, cwav_->cwavInfo->loopStart, cwav_->cwavInfo->LoopEnd, size, IMAADPCMInfos, DSPADPCMInfos);
+        u32 envChannel = cwav_->playingChanIds[cwav_->currMultiplePlay][cwavChannel];
+        float categoryGain = cwavCategoryGetGain(cwav->category);
+        bool startPaused = cwavCategoryVoiceStarted(envChannel, cwav->category, volume, pan, i ? options->rightMix : options->leftMix, (float)(cwav_->cwavInfo->sampleRate) * pitch, categoryGain);
+        cwavVoice_t* voice = cwavVoiceGetActive(envChannel);
+        if (voice)
+            voice->firstSample = start;
+        bool scheduled = options->samplePosition != CWAV_PLAY_NOW;
+        if (scheduled || options->held)
+            cwavEnvSetHeld(envChannel, true);
+        cwavEnvPlay(envChannel, isLooped, encoding, cwav_->cwavInfo->sampleRate, cwavVoiceGetAppliedMix(envChannel), pitch, block0, block1, loopStart - start, end - start, size, IMAADPCMInfos, DSPADPCMInfos,
+            scheduled ? cwavSchedGetStartDelay(options->samplePosition) : 0);
+        cwav_->playingSerials[cwav_->currMultiplePlay * cwav_->channelcount + cwavChannel] = cwavEnvGetChannelSerial(envChannel);
+        if (startPaused)
+            cwavEnvSetPaused(envChannel, true);
+        if (scheduled)
+            cwavSchedVoiceQueued(envChannel, options->samplePosition);
         if (!i)
         {
             ret.monoLeftChannel = cwav_->playingChanIds[cwav_->currMultiplePlay][leftChannel];
@@ -519,14 +1075,101 @@ cwavPlayResult cwavPlay(CWAV* cwav, int leftChannel, int rightChannel)
     return ret;
 }
 
+static cwavPlayResult cwav_play(CWAV* cwav, int leftChannel, int rightChannel, const cwav_playOptions_t* options)
+{
+    CWAV_LATENCY_PLAY_BEGIN();
+    CWAV_TRACE_BEGIN(traceTick);
+    CWAV_STATS_TICK_START(startTick);
+    cwavPlayResult ret = cwav_playImpl(cwav, leftChannel, rightChannel, options);
+    CWAV_STATS_TICK_END(playTicks, startTick);
+    CWAV_TRACE_END(traceTick, CWAV_TRACE_PLAY, cwav, ret.playStatus, ret.playStatus == CWAV_SUCCESS ? ret.monoLeftChannel : -1,
+        (ret.playStatus == CWAV_SUCCESS && rightChannel >= 0) ? ret.rightChannel : -1);
+
+    CWAV_STATS_ADD(playsRequested, 1);
+    if (ret.playStatus == CWAV_SUCCESS)
+    {
+        cwavCategoryPlayFinished(cwav->category);
+        CWAV_STATS_ADD(playsSucceeded, 1);
+        CWAV_STATS_ADD(activeVoices, rightChannel < 0 ? 1 : 2);
+        CWAV_STATS_MAX(peakVoices, CWAV_STATS_GET(activeVoices));
+    }
+    else if (ret.playStatus == CWAV_NO_CHANNEL_AVAILABLE)
+        CWAV_STATS_ADD(playsFailedNoChannel, 1);
+    return ret;
+}
+
+cwavPlayResult cwavPlay(CWAV* cwav, int leftChannel, int rightChannel)
+{
+    cwav_playOptions_t options = {NULL, NULL, CWAV_PLAY_NOW, NULL, false};
+    return cwav_play(cwav, leftChannel, rightChannel, &options);
+}
+
+cwavPlayResult cwavPlayWithMix(CWAV* cwav, int leftChannel, int rightChannel, const float* leftMix, const float* rightMix)
+{
+    cwav_playOptions_t options = {leftMix, rightMix, CWAV_PLAY_NOW, NULL, false};
+    return cwav_play(cwav, leftChannel, rightChannel, &options);
+}
+
+cwavPlayResult cwavPlayAtTime(CWAV* cwav, int leftChannel, int rightChannel, u64 samplePosition)
+{
+    if (!cwavSchedIsRunning() || samplePosition == CWAV_PLAY_NOW)
+    {
+        cwavPlayResult ret;
+        ret.playStatus = CWAV_INVALID_ARGUMENT;
+        return ret;
+    }
+    cwav_playOptions_t options = {NULL, NULL, samplePosition, NULL, false};
+    return cwav_play(cwav, leftChannel, rightChannel, &options);
+}
+
+cwavPlayResult cwavRegionPlay(CWAV* cwav, const cwavRegionImpl_t* region, int leftChannel, int rightChannel)
+{
+    cwav_playOptions_t options = {NULL, NULL, CWAV_PLAY_NOW, region, false};
+    return cwav_play(cwav, leftChannel, rightChannel, &options);
+}
+
+cwavPlayResult cwavPlayRegion(CWAV* cwav, int region, int leftChannel, int rightChannel)
+{
+    cwav_playOptions_t options = {NULL, NULL, CWAV_PLAY_NOW, NULL, false};
+    if (cwav && cwav->loadStatus == CWAV_SUCCESS)
+    {
+        options.region = cwavRegionGet(CWAVTOIMPL(cwav), region);
+        if (!options.region)
+        {
+            cwavPlayResult ret;
+            ret.playStatus = CWAV_INVALID_ARGUMENT;
+            return ret;
+        }
+    }
+    return cwav_play(cwav, leftChannel, rightChannel, &options);
+}
+
+cwavPlayResult cwavStemPlayHeld(CWAV* cwav, int leftChannel, int rightChannel)
+{
+    cwav_playOptions_t options = {NULL, NULL, CWAV_PLAY_NOW, NULL, true};
+    return cwav_play(cwav, leftChannel, rightChannel, &options);
+}
+
+bool cwavSetChannelMix(u32 channel, const float* mix)
+{
+    cwavVoice_t* voice = cwavVoiceGetLive(channel);
+    if (!voice)
+        return false;
+
+    cwavVoiceSetCustomMix(voice, mix);
+    return cwavVoiceCommit(channel, voice);
+}
+
 void cwavStop(CWAV* cwav, int leftChannel, int rightChannel)
 {
     if (!cwav || cwav->loadStatus != CWAV_SUCCESS)
         return;
     
+    CWAV_TRACE_BEGIN(traceTick);
     cwav_t* cwav_ = CWAVTOIMPL(cwav);
     for (int i = 0; i < cwav_->totalMultiplePlay; i++)
         cwav_stopImpl(cwav_, leftChannel, rightChannel, i);
+    CWAV_TRACE_END(traceTick, CWAV_TRACE_STOP, cwav, CWAV_SUCCESS, leftChannel, rightChannel);
 }
 
 bool cwavIsPlaying(CWAV* cwav)
@@ -542,7 +1185,10 @@ bool cwavIsPlaying(CWAV* cwav)
             if (currCwav->playingChanIds[j][k] == -1)
                 continue;
             if (!cwavEnvChannelIsPlaying(currCwav->playingChanIds[j][k]))
+            {
+                CWAV_TRACE_INSTANT(CWAV_TRACE_VOICE_END, cwav, 0, currCwav->playingChanIds[j][k], -1);
                 currCwav->playingChanIds[j][k] = -1;
+            }
             else
                 isPlaying = true; // Could return here, but prefer to update the playing status for all channels.
         }
@@ -0,0 +1,165 @@
+#include "internal/cwav_adpcm.h"
+#include "internal/cwav_alloc.h"
+#include "internal/cwav_stats.h"
+#include "3ds.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const s8 cwav_imaIndexTable[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+static const u16 cwav_imaStepTable[89] =
+{
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97,
+    107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724,
+    796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026,
+    4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500,
+    20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static inline s32 cwav_clamp16(s32 sample)
+{
+    if (sample > 0x7FFF)
+        return 0x7FFF;
+    if (sample < -0x8000)
+        return -0x8000;
+    return sample;
+}
+
+// The predictor and scale come from the header of the frame.
+s16 cwavAdpcmDecodeDsp(const u8* data, u32 sample, const u16* coefs, s32* hist1, s32* hist2)
+{
+    const u8* frame = data + (sample / CWAV_DSP_ADPCM_FRAME_SAMPLES) * CWAV_DSP_ADPCM_FRAME_BYTES;
+    u32 index = sample % CWAV_DSP_ADPCM_FRAME_SAMPLES;
+    u8 byte = frame[1 + index / 2];
+    s32 nibble = (index & 1) ? (byte & 0xF) : (byte >> 4);
+    if (nibble >= 8)
+        nibble -= 16;
+
+    s32 predictor = (frame[0] >> 4) & 7;
+    s32 decoded = (nibble * (1 << (frame[0] & 0xF))) << 11;
+    decoded += 1024 + (s16)coefs[predictor * 2] * *hist1 + (s16)coefs[predictor * 2 + 1] * *hist2;
+    *hist2 = *hist1;
+    *hist1 = cwav_clamp16(decoded >> 11);
+    return (s16)*hist1;
+}
+
+s16 cwavAdpcmDecodeIma(u8 nibble, s32* predictor, s32* tableIndex)
+{
+    s32 step = cwav_imaStepTable[*tableIndex];
+    s32 diff = step >> 3;
+    if (nibble & 1)
+        diff += step >> 2;
+    if (nibble & 2)
+        diff += step >> 1;
+    if (nibble & 4)
+        diff += step;
+    *predictor = cwav_clamp16((nibble & 8) ? *predictor - diff : *predictor + diff);
+
+    *tableIndex += cwav_imaIndexTable[nibble & 7];
+    if (*tableIndex < 0)
+        *tableIndex = 0;
+    else if (*tableIndex > 88)
+        *tableIndex = 88;
+    return (s16)*predictor;
+}
+
+u8 cwavAdpcmEncodeIma(s16 sample, s32* predictor, s32* tableIndex)
+{
+    s32 step = cwav_imaStepTable[*tableIndex];
+    s32 diff = sample - *predictor;
+    u8 nibble = 0;
+    if (diff < 0)
+    {
+        nibble = 8;
+        diff = -diff;
+    }
+    for (u8 bit = 4; bit; bit >>= 1, step >>= 1)
+    {
+        if (diff >= step)
+        {
+            nibble |= bit;
+            diff -= step;
+        }
+    }
+    cwavAdpcmDecodeIma(nibble, predictor, tableIndex);
+    return nibble;
+}
+
+#ifndef CWAV_DISABLE_CSND
+void cwavAdpcmFreeTranscoded(cwav_t* cwav)
+{
+    if (cwav->transcodedData)
+    {
+        for (int i = 0; i < cwav->channelcount; i++)
+            cwavAllocFree(cwav->transcodedData[i]);
+    }
+    free(cwav->transcodedData);
+    free(cwav->transcodedInfos);
+    cwav->transcodedData = NULL;
+    cwav->transcodedInfos = NULL;
+}
+
+// The IMA ADPCM loop starts at an even sample (the low nibble of a byte), the loop context is the encoder state there.
+bool cwavAdpcmTranscode(cwav_t* cwav)
+{
+    u32 samples = cwav->cwavInfo->LoopEnd;
+    u32 loopStart = cwav->cwavInfo->loopStart & ~1u;
+    cwav->transcodedData = (void**)calloc(cwav->channelcount, sizeof(void*));
+    cwav->transcodedInfos = (cwavIMAADPCMInfo_t*)calloc(cwav->channelcount, sizeof(cwavIMAADPCMInfo_t));
+    if (!cwav->transcodedData || !cwav->transcodedInfos)
+    {
+        cwavAdpcmFreeTranscoded(cwav);
+        return false;
+    }
+
+    for (int i = 0; i < cwav->channelcount; i++)
+    {
+        u8* out = (u8*)cwavAllocLinear((samples + 1) / 2);
+        if (!out)
+        {
+            cwavAdpcmFreeTranscoded(cwav);
+            return false;
+        }
+        memset(out, 0, (samples + 1) / 2);
+        cwav->transcodedData[i] = out;
+
+        const u8* data = (const u8*)cwav->sampleData[i];
+        const cwavDSPADPCMInfo_t* info = cwav->DSPADPCMInfos[i];
+        s32 hist1 = (s16)info->context.prevSample;
+        s32 hist2 = (s16)info->context.secondPrevSample;
+        s32 predictor = 0, tableIndex = 0;
+        cwavIMAADPCMInfo_t* outInfo = &cwav->transcodedInfos[i];
+        for (u32 sample = 0; sample < samples; sample++)
+        {
+            s16 decoded = cwavAdpcmDecodeDsp(data, sample, info->param.coefs, &hist1, &hist2);
+            // Starting from the first sample avoids a ramp from silence.
+            if (sample == 0)
+                predictor = decoded;
+            if (sample == 0 || sample == loopStart)
+            {
+                cwavIMAADPCMContext_t* context = sample == 0 ? &outInfo->context : &outInfo->loopContext;
+                context->data = (u16)predictor;
+                context->tableIndex = (u8)tableIndex;
+                context->padding = 0;
+                if (loopStart == 0)
+                    outInfo->loopContext = outInfo->context;
+            }
+            u8 nibble = cwavAdpcmEncodeIma(decoded, &predictor, &tableIndex);
+            out[sample / 2] |= (sample & 1) ? nibble << 4 : nibble;
+        }
+        svcFlushProcessDataCache(CUR_PROCESS_HANDLE, (u32)(uintptr_t)out, (samples + 1) / 2);
+    }
+    return true;
+}
+
+bool cwavAdpcmPrepareCsnd(cwav_t* cwav)
+{
+    if (cwav->cwavInfo->encoding != DSP_ADPCM || cwav->transcodedData)
+        return true;
+    if (!cwavAdpcmTranscode(cwav))
+        return false;
+    // Freed with the CWAV, which removes it from the sample bytes with the DSP ADPCM data.
+    CWAV_STATS_ADD(sampleBytes, ((cwav->cwavInfo->LoopEnd + 1) / 2) * cwav->channelcount);
+    return true;
+}
+#endif
@@ -0,0 +1,242 @@
+#include "internal/cwav_alloc.h"
+#include "3ds.h"
+#include <string.h>
+
+#define CWAV_ARENA_ALIGNMENT 0x20
+#define CWAV_ARENA_MIN_CLASS_SIZE 0x100
+
+// Block header placed before every arena allocation. Padded so the payload keeps the arena alignment.
+typedef union cwavArenaBlock_u
+{
+    struct
+    {
+        u32 size;
+        u32 used;
+        union cwavArenaBlock_u* nextFree;
+    };
+    u8 padding[CWAV_ARENA_ALIGNMENT];
+} cwavArenaBlock_t;
+
+#define CWAV_ARENA_HEADER_SIZE sizeof(cwavArenaBlock_t)
+
+#if defined(_MSC_VER)
+#define __cwav__weak // This fixes intellisense
+#else
+#define __cwav__weak __attribute__((weak))
+#endif
+// By defining these as weak and in the case they are not defined, they won't be called instead of the compiler erroring.
+void* __cwav__weak linearAlloc(size_t size);
+void  __cwav__weak linearFree(void* mem);
+
+static void* cwav_defaultAlloc(void* userData, size_t size)
+{
+    return linearAlloc(size); // In the case linearAlloc is not defined, it will return NULL.
+}
+
+static void cwav_defaultFree(void* userData, void* mem)
+{
+    linearFree(mem);
+}
+
+static cwavAllocator g_currentAllocator = {cwav_defaultAlloc, cwav_defaultFree, NULL};
+
+void cwavSetAllocator(const cwavAllocator* allocator)
+{
+    if (allocator && allocator->alloc && allocator->free)
+        g_currentAllocator = *allocator;
+    else
+    {
+        g_currentAllocator.alloc = cwav_defaultAlloc;
+        g_currentAllocator.free = cwav_defaultFree;
+        g_currentAllocator.userData = NULL;
+    }
+}
+
+void* cwavAllocLinear(size_t size)
+{
+    return g_currentAllocator.alloc(g_currentAllocator.userData, size);
+}
+
+void cwavAllocFree(void* mem)
+{
+    if (mem)
+        g_currentAllocator.free(g_currentAllocator.userData, mem);
+}
+
+static inline size_t cwav_arenaAlign(size_t size)
+{
+    return (size + CWAV_ARENA_ALIGNMENT - 1) & ~(CWAV_ARENA_ALIGNMENT - 1);
+}
+
+static inline cwavArenaBlock_t* cwav_arenaBlockAt(cwavArena* arena, size_t offset)
+{
+    return (cwavArenaBlock_t*)(arena->base + offset);
+}
+
+static u32 cwav_arenaSizeClass(size_t size)
+{
+    u32 sizeClass = 0;
+    while (sizeClass < CWAV_ARENA_SIZE_CLASSES - 1 && ((size_t)CWAV_ARENA_MIN_CLASS_SIZE << (sizeClass + 1)) <= size)
+        sizeClass++;
+    return sizeClass;
+}
+
+static void cwav_arenaPushFree(cwavArena* arena, cwavArenaBlock_t* block)
+{
+    u32 sizeClass = cwav_arenaSizeClass(block->size);
+    block->used = false;
+    block->nextFree = arena->freeLists[sizeClass];
+    arena->freeLists[sizeClass] = block;
+}
+
+// Merges adjacent free blocks, gives trailing free space back to the bump pointer and rebuilds the free lists.
+static void cwav_arenaRebuild(cwavArena* arena)
+{
+    memset(arena->freeLists, 0, sizeof(arena->freeLists));
+
+    cwavArenaBlock_t* lastFree = NULL;
+    size_t lastFreeOffset = 0;
+    size_t offset = 0;
+    while (offset < arena->top)
+    {
+        cwavArenaBlock_t* block = cwav_arenaBlockAt(arena, offset);
+        size_t blockSize = CWAV_ARENA_HEADER_SIZE + block->size;
+        if (!block->used)
+        {
+            if (lastFree)
+                lastFree->size += blockSize;
+            else
+            {
+                lastFree = block;
+                lastFreeOffset = offset;
+            }
+        }
+        else if (lastFree)
+        {
+            cwav_arenaPushFree(arena, lastFree);
+            lastFree = NULL;
+        }
+        offset += blockSize;
+    }
+    if (lastFree)
+        arena->top = lastFreeOffset;
+}
+
+static void* cwav_arenaAlloc(void* userData, size_t size)
+{
+    cwavArena* arena = (cwavArena*)userData;
+    size = cwav_arenaAlign(size ? size : 1);
+
+    // Try to reuse a freed block first, starting from the smallest size class that may fit.
+    for (u32 sizeClass = cwav_arenaSizeClass(size); sizeClass < CWAV_ARENA_SIZE_CLASSES; sizeClass++)
+    {
+        cwavArenaBlock_t** prev = (cwavArenaBlock_t**)&arena->freeLists[sizeClass];
+        for (cwavArenaBlock_t* block = *prev; block; prev = &block->nextFree, block = block->nextFree)
+        {
+            if (block->size < size)
+                continue;
+            *prev = block->nextFree;
+            if (block->size - size >= CWAV_ARENA_HEADER_SIZE + CWAV_ARENA_ALIGNMENT)
+            {
+                cwavArenaBlock_t* rest = (cwavArenaBlock_t*)((u8*)block + CWAV_ARENA_HEADER_SIZE + size);
+                rest->size = block->size - size - CWAV_ARENA_HEADER_SIZE;
+                cwav_arenaPushFree(arena, rest);
+                block->size = size;
+            }
+            block->used = true;
+            block->nextFree = NULL;
+            return (u8*)block + CWAV_ARENA_HEADER_SIZE;
+        }
+    }
+
+    if (arena->size - arena->top < CWAV_ARENA_HEADER_SIZE + size)
+        return NULL;
+
+    cwavArenaBlock_t* block = cwav_arenaBlockAt(arena, arena->top);
+    block->size = size;
+    block->used = true;
+    block->nextFree = NULL;
+    arena->top += CWAV_ARENA_HEADER_SIZE + size;
+    return (u8*)block + CWAV_ARENA_HEADER_SIZE;
+}
+
+static void cwav_arenaFree(void* userData, void* mem)
+{
+    cwavArena* arena = (cwavArena*)userData;
+    if ((u8*)mem < arena->base + CWAV_ARENA_HEADER_SIZE || (u8*)mem >= arena->base + arena->top)
+        return;
+
+    cwavArenaBlock_t* block = (cwavArenaBlock_t*)((u8*)mem - CWAV_ARENA_HEADER_SIZE);
+    block->used = false;
+    cwav_arenaRebuild(arena);
+}
+
+bool cwavArenaInit(cwavArena* arena, void* buffer, size_t size)
+{
+    if (!arena)
+        return false;
+
+    memset(arena, 0, sizeof(cwavArena));
+    if (!buffer)
+        return false;
+
+    // Keep the blocks aligned even if the provided buffer is not.
+    u8* base = (u8*)cwav_arenaAlign((size_t)buffer);
+    if (size < (size_t)(base - (u8*)buffer) + CWAV_ARENA_HEADER_SIZE)
+        return false;
+
+    arena->base = base;
+    arena->size = (size - (base - (u8*)buffer)) & ~(CWAV_ARENA_ALIGNMENT - 1);
+    return true;
+}
+
+void cwavArenaGetAllocator(cwavArena* arena, cwavAllocator* out)
+{
+    if (!arena || !out)
+        return;
+
+    out->alloc = cwav_arenaAlloc;
+    out->free = cwav_arenaFree;
+    out->userData = arena;
+}
+
+size_t cwavArenaCompact(cwavArena* arena)
+{
+    if (!arena || !arena->base)
+        return 0;
+
+    size_t oldTop = arena->top;
+    size_t dst = 0;
+    size_t offset = 0;
+    while (offset < arena->top)
+    {
+        cwavArenaBlock_t* block = cwav_arenaBlockAt(arena, offset);
+        size_t blockSize = CWAV_ARENA_HEADER_SIZE + block->size;
+        if (block->used && dst != offset)
+        {
+            CWAV* owner = cwav_GetRelocatable((u8*)block + CWAV_ARENA_HEADER_SIZE, block->size);
+            if (owner)
+            {
+                cwavArenaBlock_t* newBlock = cwav_arenaBlockAt(arena, dst);
+                memmove(newBlock, block, blockSize);
+                svcFlushProcessDataCache(CUR_PROCESS_HANDLE, (u32)(uintptr_t)newBlock, blockSize);
+                cwav_Relocate(owner, (u8*)newBlock + CWAV_ARENA_HEADER_SIZE);
+                dst += blockSize;
+            }
+            else
+            {
+                // The block cannot be moved, so the space before it becomes a free block.
+                cwavArenaBlock_t* gap = cwav_arenaBlockAt(arena, dst);
+                gap->size = offset - dst - CWAV_ARENA_HEADER_SIZE;
+                gap->used = false;
+                dst = offset + blockSize;
+            }
+        }
+        else if (block->used)
+            dst += blockSize;
+        offset += blockSize;
+    }
+    arena->top = dst;
+    cwav_arenaRebuild(arena);
+    return oldTop - arena->top;
+}
@@ -0,0 +1,164 @@
+#include "internal/cwav_category.h"
+#include "internal/cwav_voice.h"
+#include "internal/cwav_env.h"
+
+typedef struct cwavCategoryState_s
+{
+    float volume;
+    bool muted;
+    bool paused;
+    float duckVolumes[CWAV_CATEGORY_COUNT]; // Indexed by the trigger category.
+} cwavCategoryState_t;
+
+static cwavCategoryState_t g_categories[CWAV_CATEGORY_COUNT] = {
+    {1.f, false, false, {1.f, 1.f, 1.f, 1.f}},
+    {1.f, false, false, {1.f, 1.f, 1.f, 1.f}},
+    {1.f, false, false, {1.f, 1.f, 1.f, 1.f}},
+    {1.f, false, false, {1.f, 1.f, 1.f, 1.f}},
+};
+static u32 g_triggerCategories = 0; // Categories that duck another category.
+static u32 g_playingTriggers = 0;
+
+static inline u8 cwav_categoryClamp(u8 category)
+{
+    return category < CWAV_CATEGORY_COUNT ? category : CWAV_CATEGORY_SFX;
+}
+
+static float cwav_categoryComputeGain(u8 category)
+{
+    cwavCategoryState_t* state = &g_categories[category];
+    if (state->muted)
+        return 0.f;
+
+    float gain = state->volume;
+    float duck = 1.f;
+    for (u32 trigger = 0; trigger < CWAV_CATEGORY_COUNT; trigger++)
+    {
+        if (((g_playingTriggers >> trigger) & 1) && state->duckVolumes[trigger] < duck)
+            duck = state->duckVolumes[trigger];
+    }
+    return gain * duck;
+}
+
+// Recomputes the gain of every live voice in one pass, only the changed voices are sent to the environment.
+static void cwav_categoryApply(bool refreshTriggers)
+{
+    u32 channelAmount = cwavEnvGetChannelAmount();
+
+    if (refreshTriggers)
+    {
+        g_playingTriggers = 0;
+        for (u32 i = 0; i < channelAmount; i++)
+        {
+            cwavVoice_t* voice = cwavVoiceGetLive(i);
+            if (voice)
+                g_playingTriggers |= (1u << voice->category) & g_triggerCategories;
+        }
+    }
+
+    float gains[CWAV_CATEGORY_COUNT];
+    for (u32 i = 0; i < CWAV_CATEGORY_COUNT; i++)
+        gains[i] = cwav_categoryComputeGain(i);
+
+    for (u32 i = 0; i < channelAmount; i++)
+    {
+        cwavVoice_t* voice = cwavVoiceGetActive(i);
+        if (!voice || voice->categoryGain == gains[voice->category])
+            continue;
+        voice->categoryGain = gains[voice->category];
+        cwavVoiceCommit(i, voice);
+    }
+}
+
+float cwavCategoryGetGain(u8 category)
+{
+    return cwav_categoryComputeGain(cwav_categoryClamp(category));
+}
+
+bool cwavCategoryVoiceStarted(u32 channel, u8 category, float volume, float pan, const float* mix, float rate, float gain)
+{
+    category = cwav_categoryClamp(category);
+    cwavVoiceStarted(channel, category, volume, pan, mix, rate, gain);
+    return g_categories[category].paused;
+}
+
+void cwavCategoryPlayFinished(u8 category)
+{
+    category = cwav_categoryClamp(category);
+    if (!((g_triggerCategories >> category) & 1) || ((g_playingTriggers >> category) & 1))
+        return;
+
+    g_playingTriggers |= 1u << category;
+    cwav_categoryApply(false);
+}
+
+void cwavCategorySetVolume(cwavCategory_t category, float volume)
+{
+    if (category >= CWAV_CATEGORY_COUNT)
+        return;
+    g_categories[category].volume = volume;
+    cwav_categoryApply(false);
+}
+
+float cwavCategoryGetVolume(cwavCategory_t category)
+{
+    if (category >= CWAV_CATEGORY_COUNT)
+        return 0.f;
+    return g_categories[category].volume;
+}
+
+void cwavCategorySetMute(cwavCategory_t category, bool mute)
+{
+    if (category >= CWAV_CATEGORY_COUNT)
+        return;
+    g_categories[category].muted = mute;
+    cwav_categoryApply(false);
+}
+
+bool cwavCategorySetPaused(cwavCategory_t category, bool paused)
+{
+    if (category >= CWAV_CATEGORY_COUNT || cwavEnvGetEnvironment() != CWAV_ENV_DSP)
+        return false;
+    if (g_categories[category].paused == paused)
+        return true;
+    g_categories[category].paused = paused;
+
+    u32 channelAmount = cwavEnvGetChannelAmount();
+    for (u32 i = 0; i < channelAmount; i++)
+    {
+        cwavVoice_t* voice = cwavVoiceGetLive(i);
+        if (!voice || voice->category != category)
+            continue;
+        if (cwavEnvChannelIsPaused(i) != paused)
+            cwavEnvSetPaused(i, paused);
+    }
+    return true;
+}
+
+bool cwavCategoryIsPaused(cwavCategory_t category)
+{
+    return category < CWAV_CATEGORY_COUNT && g_categories[category].paused;
+}
+
+void cwavCategorySetDucking(cwavCategory_t category, cwavCategory_t trigger, float duckVolume)
+{
+    if (category >= CWAV_CATEGORY_COUNT || trigger >= CWAV_CATEGORY_COUNT || category == trigger)
+        return;
+    g_categories[category].duckVolumes[trigger] = duckVolume;
+
+    g_triggerCategories = 0;
+    for (u32 i = 0; i < CWAV_CATEGORY_COUNT; i++)
+    {
+        for (u32 j = 0; j < CWAV_CATEGORY_COUNT; j++)
+        {
+            if (g_categories[i].duckVolumes[j] < 1.f)
+                g_triggerCategories |= 1u << j;
+        }
+    }
+    cwav_categoryApply(true);
+}
+
+void cwavCategoryUpdate()
+{
+    cwav_categoryApply(true);
+}
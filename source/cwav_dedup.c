@@ -0,0 +1,197 @@
+#include "internal/cwav_dedup.h"
+#include "internal/cwav_alloc.h"
+#include "internal/cwav_stats.h"
+#include "3ds.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Entries are indexed by the hash of their data (for loads) and by their address (for frees).
+typedef struct cwavDedupEntry_s
+{
+    struct cwavDedupEntry_s* nextByHash;
+    struct cwavDedupEntry_s* nextByData;
+    u32 hash;
+    u32 size;
+    u32 refCount;
+    void* data;
+} cwavDedupEntry_t;
+
+static bool g_dedupEnabled = false;
+static u32 g_dedupEntryCount = 0;
+// Power of two, grown to keep about one entry per bucket.
+static u32 g_dedupBucketCount = 0;
+static cwavDedupEntry_t** g_dedupByHash = NULL;
+static cwavDedupEntry_t** g_dedupByData = NULL;
+
+#define CWAV_HASH_PRIME1 0x9E3779B1U
+#define CWAV_HASH_PRIME2 0x85EBCA77U
+#define CWAV_HASH_PRIME3 0xC2B2AE3DU
+
+static inline u32 cwav_rotl(u32 x, u32 r)
+{
+    return (x << r) | (x >> (32 - r));
+}
+
+static inline u32 cwav_hashRound(u32 acc, u32 word)
+{
+    return cwav_rotl(acc + word * CWAV_HASH_PRIME2, 13) * CWAV_HASH_PRIME1;
+}
+
+// xxHash32 style hash. The 4 independent lanes have no dependencies between
+// them, so the main loop pipelines well and can be vectorized by the compiler.
+static u32 cwav_dedupHash(const u8* data, u32 size)
+{
+    u32 acc[4] = {CWAV_HASH_PRIME1 + CWAV_HASH_PRIME2, CWAV_HASH_PRIME2, 0, -CWAV_HASH_PRIME1};
+    u32 offset = 0;
+    for (; offset + 16 <= size; offset += 16)
+    {
+        u32 words[4];
+        memcpy(words, data + offset, sizeof(words));
+        for (int i = 0; i < 4; i++)
+            acc[i] = cwav_hashRound(acc[i], words[i]);
+    }
+
+    u32 hash = cwav_rotl(acc[0], 1) + cwav_rotl(acc[1], 7) + cwav_rotl(acc[2], 12) + cwav_rotl(acc[3], 18) + size;
+    for (; offset < size; offset++)
+        hash = cwav_rotl(hash + data[offset] * CWAV_HASH_PRIME3, 11) * CWAV_HASH_PRIME1;
+
+    hash ^= hash >> 15;
+    hash *= CWAV_HASH_PRIME2;
+    hash ^= hash >> 13;
+    hash *= CWAV_HASH_PRIME3;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+static inline u32 cwav_dedupDataBucket(const void* data)
+{
+    u32 address = (u32)(uintptr_t)data;
+    return (((address >> 4) * CWAV_HASH_PRIME1) >> 16) & (g_dedupBucketCount - 1);
+}
+
+static bool cwav_dedupGrow()
+{
+    u32 bucketCount = g_dedupBucketCount ? g_dedupBucketCount * 2 : 16;
+    cwavDedupEntry_t** byHash = calloc(bucketCount, sizeof(cwavDedupEntry_t*));
+    cwavDedupEntry_t** byData = calloc(bucketCount, sizeof(cwavDedupEntry_t*));
+    if (!byHash || !byData)
+    {
+        free(byHash);
+        free(byData);
+        return false;
+    }
+
+    cwavDedupEntry_t** oldByHash = g_dedupByHash;
+    u32 oldBucketCount = g_dedupBucketCount;
+    free(g_dedupByData);
+    g_dedupByHash = byHash;
+    g_dedupByData = byData;
+    g_dedupBucketCount = bucketCount;
+    for (u32 i = 0; i < oldBucketCount; i++)
+    {
+        cwavDedupEntry_t* entry = oldByHash[i];
+        while (entry)
+        {
+            cwavDedupEntry_t* next = entry->nextByHash;
+            u32 bucket = entry->hash & (bucketCount - 1);
+            entry->nextByHash = byHash[bucket];
+            byHash[bucket] = entry;
+            bucket = cwav_dedupDataBucket(entry->data);
+            entry->nextByData = byData[bucket];
+            byData[bucket] = entry;
+            entry = next;
+        }
+    }
+    free(oldByHash);
+    return true;
+}
+
+void cwavEnableDeduplication(bool enable)
+{
+    g_dedupEnabled = enable;
+}
+
+bool cwavDedupIsEnabled()
+{
+    return g_dedupEnabled;
+}
+
+void* cwavDedupAcquire(const void* sampleData, u32 size)
+{
+    if (!sampleData || !size)
+        return NULL;
+
+    u32 hash = cwav_dedupHash((const u8*)sampleData, size);
+    if (g_dedupBucketCount)
+    {
+        for (cwavDedupEntry_t* entry = g_dedupByHash[hash & (g_dedupBucketCount - 1)]; entry; entry = entry->nextByHash)
+        {
+            if (entry->hash == hash && entry->size == size && !memcmp(entry->data, sampleData, size))
+            {
+                entry->refCount++;
+                return entry->data;
+            }
+        }
+    }
+
+    if (g_dedupEntryCount >= g_dedupBucketCount && !cwav_dedupGrow())
+        return NULL;
+
+    cwavDedupEntry_t* entry = malloc(sizeof(cwavDedupEntry_t));
+    if (!entry)
+        return NULL;
+    void* data = cwavAllocLinear(size);
+    if (!data)
+    {
+        free(entry);
+        return NULL;
+    }
+    memcpy(data, sampleData, size);
+    svcFlushProcessDataCache(CUR_PROCESS_HANDLE, (u32)(uintptr_t)data, size);
+
+    entry->hash = hash;
+    entry->size = size;
+    entry->refCount = 1;
+    entry->data = data;
+    u32 bucket = hash & (g_dedupBucketCount - 1);
+    entry->nextByHash = g_dedupByHash[bucket];
+    g_dedupByHash[bucket] = entry;
+    bucket = cwav_dedupDataBucket(data);
+    entry->nextByData = g_dedupByData[bucket];
+    g_dedupByData[bucket] = entry;
+    g_dedupEntryCount++;
+    // Counted once, however many CWAVs use it.
+    CWAV_STATS_ADD(sampleBytes, size);
+    return data;
+}
+
+void cwavDedupRelease(void* sharedData)
+{
+    if (!g_dedupBucketCount)
+        return;
+
+    cwavDedupEntry_t** link = &g_dedupByData[cwav_dedupDataBucket(sharedData)];
+    while (*link && (*link)->data != sharedData)
+        link = &(*link)->nextByData;
+    cwavDedupEntry_t* entry = *link;
+    if (!entry || --entry->refCount)
+        return;
+
+    *link = entry->nextByData;
+    link = &g_dedupByHash[entry->hash & (g_dedupBucketCount - 1)];
+    while (*link != entry)
+        link = &(*link)->nextByHash;
+    *link = entry->nextByHash;
+    CWAV_STATS_SUB(sampleBytes, entry->size);
+    cwavAllocFree(entry->data);
+    free(entry);
+
+    if (--g_dedupEntryCount == 0)
+    {
+        free(g_dedupByHash);
+        free(g_dedupByData);
+        g_dedupByHash = NULL;
+        g_dedupByData = NULL;
+        g_dedupBucketCount = 0;
+    }
+}
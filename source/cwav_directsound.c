@@ -0,0 +1,323 @@
+#include "internal/cwav_directsound.h"
+#include "internal/cwav_defs.h"
+#include "internal/cwav_env.h"
+#include "3ds.h"
+#include <string.h>
+
+#ifndef CWAV_DISABLE_CSND
+
+#define CWAVTOIMPL(c) ((cwav_t*)c->cwav)
+
+#define CWAV_DIRECT_SOUND_MAX_PRIORITY 31
+#define CWAV_DIRECT_SOUND_LOOP_STACK_SIZE 0x1000
+// Longest sleep of the loop thread, so it sees the loops started while it sleeps before their first loop point.
+#define CWAV_DIRECT_SOUND_LOOP_MAX_SLEEP_MS 4
+
+typedef struct cwavDirectSoundRequest_s
+{
+    CWAV* cwav;
+    int leftChannel;
+    int rightChannel;
+    u32 priority;
+    ncsndDirectSoundModifiers modifiers;
+    u64 expireTick;
+    u32 order; // Requests with the same priority play in the order they were made.
+} cwavDirectSoundRequest_t;
+
+// CSND does not report when a direct sound ends, each channel is busy until the estimated end of its sound.
+// Direct sounds cannot loop, looped CWAVs are played again from their loop start at the estimated end of the previous
+// pass by the loop thread (or by cwavDirectSoundUpdate if the thread could not be created).
+typedef struct cwavDirectSoundChannel_s
+{
+    bool busy;
+    bool looping;
+    u64 endTick;
+    cwavDirectSoundRequest_t request;
+} cwavDirectSoundChannel_t;
+
+static cwavDirectSoundChannel_t g_directSoundChannels[CWAV_DIRECT_SOUND_CHANNELS];
+static cwavDirectSoundRequest_t g_directSoundQueue[CWAV_DIRECT_SOUND_QUEUE_SIZE];
+static u32 g_directSoundQueued = 0;
+static u32 g_directSoundOrder = 0;
+
+// The channels are shared with the loop thread, which runs while a channel loops.
+static u8 g_directSoundLock = 0;
+static Thread g_directSoundLoopThread = NULL;
+static bool g_directSoundLoopThreadRunning = false;
+
+static void cwav_directSoundLock()
+{
+    while (__atomic_test_and_set(&g_directSoundLock, __ATOMIC_ACQUIRE))
+        svcSleepThread(100000);
+}
+
+static void cwav_directSoundUnlock()
+{
+    __atomic_clear(&g_directSoundLock, __ATOMIC_RELEASE);
+}
+
+static u64 cwav_directSoundDuration(const CWAV* cwav, const ncsndDirectSoundModifiers* modifiers, bool loopPass)
+{
+    cwav_t* cwav_ = CWAVTOIMPL(cwav);
+    float speed = modifiers->speedMultiplier > 0.f ? modifiers->speedMultiplier : 1.f;
+    u32 samples = cwav_->cwavInfo->LoopEnd - (loopPass ? cwav_->cwavInfo->loopStart : 0);
+    return (u64)((double)samples * SYSCLOCK_ARM11 / ((double)cwav_->cwavInfo->sampleRate * speed));
+}
+
+// Free channel, or the one with the lowest priority if it is lower than the given one. -1 if there are none.
+static int cwav_directSoundPickChannel(u32 priority, u64 now)
+{
+    int picked = -1;
+    for (int i = 0; i < CWAV_DIRECT_SOUND_CHANNELS; i++)
+    {
+        cwavDirectSoundChannel_t* channel = &g_directSoundChannels[i];
+        if (channel->busy && now >= channel->endTick)
+            channel->busy = false;
+        if (!channel->busy)
+            return i;
+        if (channel->request.priority > priority && (picked < 0 || channel->request.priority > g_directSoundChannels[picked].request.priority))
+            picked = i;
+    }
+    return picked;
+}
+
+// Sends the next pass of the loops that reached their estimated end. Returns the earliest end of the remaining loops,
+// U64_MAX if no channel loops. Called with the lock held.
+static u64 cwav_directSoundContinueLoops(u64 now)
+{
+    u64 nextEnd = U64_MAX;
+    for (int i = 0; i < CWAV_DIRECT_SOUND_CHANNELS; i++)
+    {
+        cwavDirectSoundChannel_t* channel = &g_directSoundChannels[i];
+        if (!channel->busy || !channel->looping)
+            continue;
+        const cwavDirectSoundRequest_t* request = &channel->request;
+        if (now >= channel->endTick)
+        {
+            if (!cwavEnvPlayDirectSound(request->cwav, request->leftChannel, request->rightChannel, i, request->priority, &request->modifiers, true))
+            {
+                channel->busy = channel->looping = false;
+                continue;
+            }
+            channel->endTick = now + cwav_directSoundDuration(request->cwav, &request->modifiers, true);
+        }
+        if (channel->endTick < nextEnd)
+            nextEnd = channel->endTick;
+    }
+    return nextEnd;
+}
+
+// Sleeps until the next loop point, so the next pass starts right after the previous one instead of at the next
+// cwavDirectSoundUpdate. Exits once no channel loops.
+static void cwav_directSoundLoopThread(void* arg)
+{
+    while (true)
+    {
+        cwav_directSoundLock();
+        u64 now = svcGetSystemTick();
+        u64 nextEnd = cwav_directSoundContinueLoops(now);
+        if (nextEnd == U64_MAX)
+        {
+            g_directSoundLoopThreadRunning = false;
+            cwav_directSoundUnlock();
+            return;
+        }
+        cwav_directSoundUnlock();
+
+        u64 sleepTicks = nextEnd - now;
+        if (sleepTicks > (u64)CWAV_DIRECT_SOUND_LOOP_MAX_SLEEP_MS * SYSCLOCK_ARM11 / 1000)
+            sleepTicks = (u64)CWAV_DIRECT_SOUND_LOOP_MAX_SLEEP_MS * SYSCLOCK_ARM11 / 1000;
+        svcSleepThread((s64)(sleepTicks * 1000000000ULL / SYSCLOCK_ARM11));
+    }
+}
+
+static void cwav_directSoundJoinLoopThread()
+{
+    if (!g_directSoundLoopThread)
+        return;
+    threadJoin(g_directSoundLoopThread, U64_MAX);
+    threadFree(g_directSoundLoopThread);
+    g_directSoundLoopThread = NULL;
+}
+
+// Called with the lock held. The thread runs above the application priority so it is not delayed by the main loop.
+static void cwav_directSoundStartLoopThread()
+{
+    if (g_directSoundLoopThreadRunning)
+        return;
+
+    // A thread that exited still has to be joined, it does not use the lock anymore.
+    cwav_directSoundJoinLoopThread();
+    s32 prio = 0x30;
+    svcGetThreadPriority(&prio, CUR_THREAD_HANDLE);
+    if (prio > 0x18)
+        prio--;
+    g_directSoundLoopThread = threadCreate(cwav_directSoundLoopThread, NULL, CWAV_DIRECT_SOUND_LOOP_STACK_SIZE, prio, -2, false);
+    g_directSoundLoopThreadRunning = g_directSoundLoopThread != NULL;
+}
+
+// Called with the lock held.
+static bool cwav_directSoundStart(const cwavDirectSoundRequest_t* request, int channel, u64 now)
+{
+    if (!cwavEnvPlayDirectSound(request->cwav, request->leftChannel, request->rightChannel, channel, request->priority, &request->modifiers, false))
+        return false;
+
+    cwavDirectSoundChannel_t* state = &g_directSoundChannels[channel];
+    state->busy = true;
+    state->looping = request->cwav->isLooped && cwav_directSoundDuration(request->cwav, &request->modifiers, true) > 0;
+    state->endTick = now + cwav_directSoundDuration(request->cwav, &request->modifiers, false);
+    state->request = *request;
+    if (state->looping)
+        cwav_directSoundStartLoopThread();
+    return true;
+}
+
+static void cwav_directSoundRemove(u32 index)
+{
+    g_directSoundQueued--;
+    memmove(&g_directSoundQueue[index], &g_directSoundQueue[index + 1], sizeof(cwavDirectSoundRequest_t) * (g_directSoundQueued - index));
+}
+
+// Index of the queued request with the lowest priority (the newest one among equals).
+static u32 cwav_directSoundLowestQueued()
+{
+    u32 lowest = 0;
+    for (u32 i = 1; i < g_directSoundQueued; i++)
+    {
+        if (g_directSoundQueue[i].priority >= g_directSoundQueue[lowest].priority)
+            lowest = i;
+    }
+    return lowest;
+}
+
+cwavDirectSoundStatus_t cwavDirectSoundPlay(CWAV* cwav, int leftChannel, int rightChannel, u32 priority, const ncsndDirectSoundModifiers* soundModifiers, u32 maxWaitMs)
+{
+    if (cwavEnvGetEnvironment() != CWAV_ENV_CSND || !cwav || cwav->loadStatus != CWAV_SUCCESS ||
+        priority > CWAV_DIRECT_SOUND_MAX_PRIORITY || leftChannel < 0 || leftChannel >= CWAVTOIMPL(cwav)->channelcount || rightChannel >= CWAVTOIMPL(cwav)->channelcount)
+        return CWAV_DIRECT_SOUND_FAILED;
+
+    cwavDirectSoundRequest_t request;
+    request.cwav = cwav;
+    request.leftChannel = leftChannel;
+    request.rightChannel = rightChannel;
+    request.priority = priority;
+    if (soundModifiers)
+        request.modifiers = *soundModifiers;
+    else
+    {
+        ncsndDirectSound defaults;
+        ncsndInitializeDirectSound(&defaults);
+        request.modifiers = defaults.soundModifiers;
+    }
+
+    // Queued sounds go first, so a new sound does not take the channel a queued one with a higher priority waits for.
+    cwavDirectSoundUpdate();
+    u64 now = svcGetSystemTick();
+    bool higherQueued = false;
+    for (u32 i = 0; i < g_directSoundQueued; i++)
+        higherQueued |= g_directSoundQueue[i].priority <= priority;
+
+    if (!higherQueued)
+    {
+        cwav_directSoundLock();
+        int channel = cwav_directSoundPickChannel(priority, now);
+        bool started = channel >= 0 && cwav_directSoundStart(&request, channel, now);
+        cwav_directSoundUnlock();
+        if (channel >= 0)
+            return started ? CWAV_DIRECT_SOUND_PLAYING : CWAV_DIRECT_SOUND_FAILED;
+    }
+
+    if (!maxWaitMs)
+        return CWAV_DIRECT_SOUND_FAILED;
+    if (g_directSoundQueued == CWAV_DIRECT_SOUND_QUEUE_SIZE)
+    {
+        // A full queue makes room by dropping its lowest priority sound.
+        u32 lowest = cwav_directSoundLowestQueued();
+        if (g_directSoundQueue[lowest].priority <= priority)
+            return CWAV_DIRECT_SOUND_FAILED;
+        cwav_directSoundRemove(lowest);
+    }
+
+    request.expireTick = now + (u64)maxWaitMs * SYSCLOCK_ARM11 / 1000;
+    request.order = g_directSoundOrder++;
+    g_directSoundQueue[g_directSoundQueued++] = request;
+    return CWAV_DIRECT_SOUND_QUEUED;
+}
+
+void cwavDirectSoundUpdate()
+{
+    cwav_directSoundLock();
+    u64 now = svcGetSystemTick();
+    cwav_directSoundContinueLoops(now);
+    for (u32 i = 0; i < g_directSoundQueued;)
+    {
+        if (now >= g_directSoundQueue[i].expireTick)
+            cwav_directSoundRemove(i);
+        else
+            i++;
+    }
+
+    while (g_directSoundQueued)
+    {
+        u32 next = 0;
+        for (u32 i = 1; i < g_directSoundQueued; i++)
+        {
+            const cwavDirectSoundRequest_t* request = &g_directSoundQueue[i];
+            if (request->priority < g_directSoundQueue[next].priority ||
+                (request->priority == g_directSoundQueue[next].priority && (s32)(request->order - g_directSoundQueue[next].order) < 0))
+                next = i;
+        }
+
+        int channel = cwav_directSoundPickChannel(g_directSoundQueue[next].priority, now);
+        if (channel < 0)
+            break;
+        cwavDirectSoundRequest_t request = g_directSoundQueue[next];
+        cwav_directSoundRemove(next);
+        cwav_directSoundStart(&request, channel, now);
+    }
+    cwav_directSoundUnlock();
+}
+
+u32 cwavDirectSoundGetQueued()
+{
+    return g_directSoundQueued;
+}
+
+void cwavDirectSoundClearQueue()
+{
+    g_directSoundQueued = 0;
+}
+
+void cwavDirectSoundStop(CWAV* cwav)
+{
+    cwav_directSoundLock();
+    for (int i = 0; i < CWAV_DIRECT_SOUND_CHANNELS; i++)
+    {
+        if (!cwav || g_directSoundChannels[i].request.cwav == cwav)
+            g_directSoundChannels[i].looping = false;
+    }
+    cwav_directSoundUnlock();
+    for (u32 i = 0; i < g_directSoundQueued;)
+    {
+        if (!cwav || g_directSoundQueue[i].cwav == cwav)
+            cwav_directSoundRemove(i);
+        else
+            i++;
+    }
+}
+
+void cwavDirectSoundForget(const CWAV* cwav)
+{
+    cwavDirectSoundStop((CWAV*)cwav);
+
+    // The loop thread exits by itself once nothing loops, it is joined here so it does not outlive the last CWAV.
+    cwav_directSoundLock();
+    bool looping = false;
+    for (int i = 0; i < CWAV_DIRECT_SOUND_CHANNELS; i++)
+        looping |= g_directSoundChannels[i].busy && g_directSoundChannels[i].looping;
+    cwav_directSoundUnlock();
+    if (!looping)
+        cwav_directSoundJoinLoopThread();
+}
+
+#endif
@@ -0,0 +1,443 @@
+#include "cwav.h"
+#include "internal/cwav_env.h"
+#include "3ds.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CWAV_EFFECTS_AUX_BUSES 2
+#define CWAV_EFFECTS_FRAME_SAMPLES 160
+#define CWAV_EFFECTS_TICKS_PER_SAMPLE 8192
+#define CWAV_EFFECTS_SAMPLE_RATE ((float)SYSCLOCK_ARM11 / CWAV_EFFECTS_TICKS_PER_SAMPLE)
+#define CWAV_EFFECTS_MAX_SAMPLE 1073741823.f
+#define CWAV_EFFECTS_PI 3.14159265f
+
+// Schroeder reverb: parallel low pass feedback combs followed by series allpasses, the lengths
+// are the Freeverb ones scaled to the DSP rate. The right side lines are longer by CWAV_REVERB_SPREAD.
+#define CWAV_REVERB_COMBS 4
+#define CWAV_REVERB_ALLPASSES 2
+#define CWAV_REVERB_SPREAD 17
+#define CWAV_REVERB_INPUT_GAIN 0.03f
+#define CWAV_REVERB_ALLPASS_FEEDBACK 0.5f
+#ifndef CWAV_DISABLE_DSP
+static const u16 g_reverbCombLengths[CWAV_REVERB_COMBS] = {829, 881, 947, 1006};
+static const u16 g_reverbAllpassLengths[CWAV_REVERB_ALLPASSES] = {412, 327};
+#endif
+
+typedef struct cwavDelayLine_s
+{
+    float* buffer;
+    u32 length;
+    u32 position;
+    float store; // Low pass state of the reverb combs.
+} cwavDelayLine_t;
+
+typedef struct cwavEffectState_s
+{
+    cwavEffectType_t type;
+    float wet;
+    float feedback;
+    float damping;
+    // Filters: b0, b1, b2, a1, a2 (normalized), one pole filters only use b0.
+    float coefs[5];
+    float z1[2];
+    float z2[2];
+    cwavDelayLine_t lines[2][CWAV_REVERB_COMBS + CWAV_REVERB_ALLPASSES]; // Delays only use the first line.
+    float* memory;
+} cwavEffectState_t;
+
+typedef struct cwavEffectsChain_s
+{
+    u32 count;
+    cwavEffectState_t effects[CWAV_EFFECTS_MAX_CHAIN];
+
+    // Written by the ndsp thread.
+    u32 frames;
+    u32 lastTicks;
+    u32 peakTicks;
+    u64 totalTicks;
+} cwavEffectsChain_t;
+
+// The chains are swapped while the ndsp thread may be running the callback, the old chain
+// is only freed once the callback is not using it (see cwav_effectsSwapChain).
+static cwavEffectsChain_t* g_effectChains[CWAV_EFFECTS_AUX_BUSES];
+
+#ifndef CWAV_DISABLE_DSP
+static u32 g_effectsInCallback[CWAV_EFFECTS_AUX_BUSES];
+
+static inline float cwav_effectsClamp(float value, float min, float max)
+{
+    return value < min ? min : (value > max ? max : value);
+}
+
+// Processes a run of samples that does not wrap around the delay line.
+static inline void cwav_effectsCombRun(cwavDelayLine_t* line, const float* in, float* out, u32 count, float feedback, float damping)
+{
+    float* buffer = line->buffer + line->position;
+    float store = line->store;
+    for (u32 i = 0; i < count; i++)
+    {
+        float delayed = buffer[i];
+        store = delayed + (store - delayed) * damping;
+        buffer[i] = in[i] + store * feedback;
+        out[i] += delayed;
+    }
+    line->store = store;
+}
+
+static inline void cwav_effectsAllpassRun(cwavDelayLine_t* line, float* samples, u32 count)
+{
+    float* buffer = line->buffer + line->position;
+    for (u32 i = 0; i < count; i++)
+    {
+        float delayed = buffer[i];
+        buffer[i] = samples[i] + delayed * CWAV_REVERB_ALLPASS_FEEDBACK;
+        samples[i] = delayed - samples[i];
+    }
+}
+
+static inline void cwav_effectsDelayRun(cwavDelayLine_t* line, float* samples, u32 count, float feedback, float wet)
+{
+    float* buffer = line->buffer + line->position;
+    float dry = 1.f - wet;
+    for (u32 i = 0; i < count; i++)
+    {
+        float delayed = buffer[i];
+        buffer[i] = samples[i] + delayed * feedback;
+        samples[i] = samples[i] * dry + delayed * wet;
+    }
+}
+
+// Delay lines are longer than a frame, so a frame wraps around them at most once.
+static inline u32 cwav_effectsLineRun(const cwavDelayLine_t* line, u32 count)
+{
+    u32 left = line->length - line->position;
+    return count < left ? count : left;
+}
+
+static inline void cwav_effectsLineAdvance(cwavDelayLine_t* line, u32 count)
+{
+    line->position += count;
+    if (line->position >= line->length)
+        line->position -= line->length;
+}
+
+static void cwav_effectsOnePole(cwavEffectState_t* effect, float* samples, u32 count, int side)
+{
+    float coef = effect->coefs[0];
+    float z = effect->z1[side];
+    for (u32 i = 0; i < count; i++)
+    {
+        z += (samples[i] - z) * coef;
+        samples[i] = z;
+    }
+    effect->z1[side] = z;
+}
+
+// Transposed direct form II.
+static void cwav_effectsBiquad(cwavEffectState_t* effect, float* samples, u32 count, int side)
+{
+    float b0 = effect->coefs[0], b1 = effect->coefs[1], b2 = effect->coefs[2];
+    float a1 = effect->coefs[3], a2 = effect->coefs[4];
+    float z1 = effect->z1[side];
+    float z2 = effect->z2[side];
+    for (u32 i = 0; i < count; i++)
+    {
+        float x = samples[i];
+        float y = b0 * x + z1;
+        z1 = b1 * x - a1 * y + z2;
+        z2 = b2 * x - a2 * y;
+        samples[i] = y;
+    }
+    effect->z1[side] = z1;
+    effect->z2[side] = z2;
+}
+
+static void cwav_effectsDelay(cwavEffectState_t* effect, float* samples, u32 count, int side)
+{
+    cwavDelayLine_t* line = &effect->lines[side][0];
+    while (count)
+    {
+        u32 run = cwav_effectsLineRun(line, count);
+        cwav_effectsDelayRun(line, samples, run, effect->feedback, effect->wet);
+        cwav_effectsLineAdvance(line, run);
+        samples += run;
+        count -= run;
+    }
+}
+
+static void cwav_effectsReverb(cwavEffectState_t* effect, float* left, float* right, u32 count)
+{
+    float input[CWAV_EFFECTS_FRAME_SAMPLES];
+    for (u32 i = 0; i < count; i++)
+        input[i] = (left[i] + right[i]) * CWAV_REVERB_INPUT_GAIN;
+
+    float dry = 1.f - effect->wet;
+    for (int side = 0; side < 2; side++)
+    {
+        float output[CWAV_EFFECTS_FRAME_SAMPLES];
+        memset(output, 0, sizeof(float) * count);
+
+        for (int c = 0; c < CWAV_REVERB_COMBS; c++)
+        {
+            cwavDelayLine_t* line = &effect->lines[side][c];
+            u32 run = cwav_effectsLineRun(line, count);
+            cwav_effectsCombRun(line, input, output, run, effect->feedback, effect->damping);
+            cwav_effectsLineAdvance(line, run);
+            if (run < count)
+            {
+                cwav_effectsCombRun(line, input + run, output + run, count - run, effect->feedback, effect->damping);
+                cwav_effectsLineAdvance(line, count - run);
+            }
+        }
+
+        for (int a = 0; a < CWAV_REVERB_ALLPASSES; a++)
+        {
+            cwavDelayLine_t* line = &effect->lines[side][CWAV_REVERB_COMBS + a];
+            u32 run = cwav_effectsLineRun(line, count);
+            cwav_effectsAllpassRun(line, output, run);
+            cwav_effectsLineAdvance(line, run);
+            if (run < count)
+            {
+                cwav_effectsAllpassRun(line, output + run, count - run);
+                cwav_effectsLineAdvance(line, count - run);
+            }
+        }
+
+        float* samples = side ? right : left;
+        for (u32 i = 0; i < count; i++)
+            samples[i] = samples[i] * dry + output[i] * effect->wet;
+    }
+}
+
+static void cwav_effectsProcess(cwavEffectsChain_t* chain, s32** samples, u32 count)
+{
+    // The back outputs are folded into the front ones, the chain works in stereo.
+    float left[CWAV_EFFECTS_FRAME_SAMPLES];
+    float right[CWAV_EFFECTS_FRAME_SAMPLES];
+    for (u32 i = 0; i < count; i++)
+    {
+        left[i] = (float)(samples[0][i] + samples[2][i]);
+        right[i] = (float)(samples[1][i] + samples[3][i]);
+    }
+
+    for (u32 e = 0; e < chain->count; e++)
+    {
+        cwavEffectState_t* effect = &chain->effects[e];
+        switch (effect->type)
+        {
+        case CWAV_EFFECT_LOWPASS:
+            cwav_effectsOnePole(effect, left, count, 0);
+            cwav_effectsOnePole(effect, right, count, 1);
+            break;
+        case CWAV_EFFECT_BIQUAD_LOWPASS:
+        case CWAV_EFFECT_BIQUAD_HIGHPASS:
+            cwav_effectsBiquad(effect, left, count, 0);
+            cwav_effectsBiquad(effect, right, count, 1);
+            break;
+        case CWAV_EFFECT_DELAY:
+            cwav_effectsDelay(effect, left, count, 0);
+            cwav_effectsDelay(effect, right, count, 1);
+            break;
+        case CWAV_EFFECT_REVERB:
+            cwav_effectsReverb(effect, left, right, count);
+            break;
+        default:
+            break;
+        }
+    }
+
+    // Truncating conversions, a single VFP instruction unlike lrintf.
+    for (u32 i = 0; i < count; i++)
+    {
+        samples[0][i] = (s32)cwav_effectsClamp(left[i], -CWAV_EFFECTS_MAX_SAMPLE, CWAV_EFFECTS_MAX_SAMPLE);
+        samples[1][i] = (s32)cwav_effectsClamp(right[i], -CWAV_EFFECTS_MAX_SAMPLE, CWAV_EFFECTS_MAX_SAMPLE);
+        samples[2][i] = 0;
+        samples[3][i] = 0;
+    }
+}
+
+static void cwav_effectsAuxCallback(void* data, int nsamples, void* samples[4])
+{
+    u32 bus = (u32)(uintptr_t)data;
+    __atomic_store_n(&g_effectsInCallback[bus], 1, __ATOMIC_SEQ_CST);
+    cwavEffectsChain_t* chain = __atomic_load_n(&g_effectChains[bus], __ATOMIC_SEQ_CST);
+    if (chain)
+    {
+        u64 startTick = svcGetSystemTick();
+        s32* channels[4] = { samples[0], samples[1], samples[2], samples[3] };
+        for (u32 done = 0; done < (u32)nsamples; done += CWAV_EFFECTS_FRAME_SAMPLES)
+        {
+            u32 count = (u32)nsamples - done;
+            if (count > CWAV_EFFECTS_FRAME_SAMPLES)
+                count = CWAV_EFFECTS_FRAME_SAMPLES;
+            s32* offsetChannels[4] = { channels[0] + done, channels[1] + done, channels[2] + done, channels[3] + done };
+            cwav_effectsProcess(chain, offsetChannels, count);
+        }
+
+        u32 ticks = (u32)(svcGetSystemTick() - startTick);
+        chain->frames++;
+        chain->lastTicks = ticks;
+        chain->totalTicks += ticks;
+        if (ticks > chain->peakTicks)
+            chain->peakTicks = ticks;
+    }
+    __atomic_store_n(&g_effectsInCallback[bus], 0, __ATOMIC_RELEASE);
+}
+
+static void cwav_effectsFreeChain(cwavEffectsChain_t* chain)
+{
+    if (!chain)
+        return;
+    for (u32 i = 0; i < chain->count; i++)
+        free(chain->effects[i].memory);
+    free(chain);
+}
+
+// Allocates the delay lines of both sides in one block, the right side ones are longer by spread.
+static bool cwav_effectsAllocLines(cwavEffectState_t* effect, const u32* lengths, u32 lineCount, u32 spread)
+{
+    u32 total = 0;
+    for (int side = 0; side < 2; side++)
+    {
+        for (u32 i = 0; i < lineCount; i++)
+            total += lengths[i] + side * spread;
+    }
+
+    effect->memory = calloc(total, sizeof(float));
+    if (!effect->memory)
+        return false;
+
+    float* buffer = effect->memory;
+    for (int side = 0; side < 2; side++)
+    {
+        for (u32 i = 0; i < lineCount; i++)
+        {
+            effect->lines[side][i].buffer = buffer;
+            effect->lines[side][i].length = lengths[i] + side * spread;
+            buffer += effect->lines[side][i].length;
+        }
+    }
+    return true;
+}
+
+static bool cwav_effectsInit(cwavEffectState_t* effect, const cwavEffect* params)
+{
+    memset(effect, 0, sizeof(cwavEffectState_t));
+    effect->type = params->type;
+    effect->wet = cwav_effectsClamp(params->wet, 0.f, 1.f);
+
+    float nyquist = CWAV_EFFECTS_SAMPLE_RATE / 2.f;
+    float w0 = 2.f * CWAV_EFFECTS_PI * cwav_effectsClamp(params->frequency, 1.f, nyquist * 0.99f) / CWAV_EFFECTS_SAMPLE_RATE;
+    switch (params->type)
+    {
+    case CWAV_EFFECT_LOWPASS:
+        effect->coefs[0] = 1.f - expf(-w0);
+        return true;
+    case CWAV_EFFECT_BIQUAD_LOWPASS:
+    case CWAV_EFFECT_BIQUAD_HIGHPASS:
+    {
+        // Audio EQ cookbook filters.
+        float cosW0 = cosf(w0);
+        float alpha = sinf(w0) / (2.f * (params->q > 0.f ? params->q : 0.7071f));
+        float a0 = 1.f + alpha;
+        float side = params->type == CWAV_EFFECT_BIQUAD_LOWPASS ? 1.f - cosW0 : 1.f + cosW0;
+        effect->coefs[0] = side / 2.f / a0;
+        effect->coefs[1] = (params->type == CWAV_EFFECT_BIQUAD_LOWPASS ? side : -side) / a0;
+        effect->coefs[2] = effect->coefs[0];
+        effect->coefs[3] = -2.f * cosW0 / a0;
+        effect->coefs[4] = (1.f - alpha) / a0;
+        return true;
+    }
+    case CWAV_EFFECT_DELAY:
+    {
+        if (!(params->timeMs > 0.f) || params->timeMs > CWAV_EFFECTS_MAX_DELAY_MS)
+            return false;
+        effect->feedback = cwav_effectsClamp(params->feedback, 0.f, 0.99f);
+        u32 length = (u32)(params->timeMs * CWAV_EFFECTS_SAMPLE_RATE / 1000.f);
+        // The delay line must be longer than a frame, shorter delays are rounded up.
+        if (length < CWAV_EFFECTS_FRAME_SAMPLES)
+            length = CWAV_EFFECTS_FRAME_SAMPLES;
+        return cwav_effectsAllocLines(effect, &length, 1, 0);
+    }
+    case CWAV_EFFECT_REVERB:
+    {
+        effect->feedback = 0.7f + 0.28f * cwav_effectsClamp(params->feedback, 0.f, 1.f);
+        effect->damping = 0.4f * cwav_effectsClamp(params->damping, 0.f, 1.f);
+        u32 lengths[CWAV_REVERB_COMBS + CWAV_REVERB_ALLPASSES];
+        for (int i = 0; i < CWAV_REVERB_COMBS; i++)
+            lengths[i] = g_reverbCombLengths[i];
+        for (int i = 0; i < CWAV_REVERB_ALLPASSES; i++)
+            lengths[CWAV_REVERB_COMBS + i] = g_reverbAllpassLengths[i];
+        return cwav_effectsAllocLines(effect, lengths, CWAV_REVERB_COMBS + CWAV_REVERB_ALLPASSES, CWAV_REVERB_SPREAD);
+    }
+    default:
+        return false;
+    }
+}
+
+// Publishes the new chain and waits for the callback to be done with the old one before freeing it.
+static void cwav_effectsSwapChain(u32 auxBus, cwavEffectsChain_t* chain)
+{
+    cwavEffectsChain_t* old = __atomic_exchange_n(&g_effectChains[auxBus], chain, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&g_effectsInCallback[auxBus], __ATOMIC_SEQ_CST))
+        svcSleepThread(100000);
+    cwav_effectsFreeChain(old);
+}
+#endif
+
+bool cwavEffectsSetChain(u32 auxBus, const cwavEffect* effects, u32 count)
+{
+#ifndef CWAV_DISABLE_DSP
+    if (cwavEnvGetEnvironment() != CWAV_ENV_DSP || auxBus >= CWAV_EFFECTS_AUX_BUSES || count > CWAV_EFFECTS_MAX_CHAIN || (count && !effects))
+        return false;
+
+    if (!count)
+    {
+        ndspAuxSetCallback(auxBus, NULL, NULL);
+        ndspAuxSetEnable(auxBus, false);
+        cwav_effectsSwapChain(auxBus, NULL);
+        return true;
+    }
+
+    cwavEffectsChain_t* chain = calloc(1, sizeof(cwavEffectsChain_t));
+    if (!chain)
+        return false;
+    for (u32 i = 0; i < count; i++)
+    {
+        if (!cwav_effectsInit(&chain->effects[i], &effects[i]))
+        {
+            chain->count = i + 1;
+            cwav_effectsFreeChain(chain);
+            return false;
+        }
+    }
+    chain->count = count;
+
+    cwav_effectsSwapChain(auxBus, chain);
+    ndspAuxSetCallback(auxBus, cwav_effectsAuxCallback, (void*)(uintptr_t)auxBus);
+    ndspAuxSetEnable(auxBus, true);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void cwavEffectsGetStats(u32 auxBus, cwavEffectsStats* out)
+{
+    if (!out)
+        return;
+
+    memset(out, 0, sizeof(cwavEffectsStats));
+    if (auxBus >= CWAV_EFFECTS_AUX_BUSES || !g_effectChains[auxBus])
+        return;
+
+    const cwavEffectsChain_t* chain = g_effectChains[auxBus];
+    const float frameTicks = (float)(CWAV_EFFECTS_FRAME_SAMPLES * CWAV_EFFECTS_TICKS_PER_SAMPLE);
+    out->frames = chain->frames;
+    out->lastTicks = chain->lastTicks;
+    out->peakTicks = chain->peakTicks;
+    if (chain->frames)
+        out->averageLoad = (float)chain->totalTicks / chain->frames / frameTicks;
+    out->peakLoad = chain->peakTicks / frameTicks;
+}
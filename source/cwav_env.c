@@ -1,4 +1,8 @@
 #include "internal/cwav_env.h"
+#include "internal/cwav_trace.h"
+#include "internal/cwav_latency.h"
+#include "internal/cwav_stats.h"
+#include "internal/cwav_adpcm.h"
 #include "3ds.h"
 #include <string.h>
 #include <stdlib.h>
@@ -30,9 +34,64 @@ static u32 g_currentEnv = CWAV_ENV_DSP;
 #endif
 
 #ifndef CWAV_DISABLE_DSP
+// Block 0, block 1, the silence played before a delayed start and the segment buffers.
+#define CWAV_ENV_SILENCE_BLOCK 2
+#define CWAV_ENV_FIRST_SEGMENT_BLOCK 3
+#define CWAV_ENV_SEGMENT_WAVEBUFS 3
+#define CWAV_ENV_DSP_WAVEBUFS (CWAV_ENV_FIRST_SEGMENT_BLOCK + CWAV_ENV_SEGMENT_WAVEBUFS)
+#define CWAV_ENV_DSP_SAMPLE_RATE ((float)SYSCLOCK_ARM11 / 8192.f)
+#define CWAV_ENV_SILENCE_SIZE 0x1000
+#define CWAV_ENV_MAX_FRAME_HOOKS 4
 static ndspWaveBuf* g_ndspWaveBuffers = NULL;
+
+// Last settings sent to each DSP channel, replays skip the unchanged ones. Invalid after ndspChnReset.
+typedef struct cwavEnvDspState_s
+{
+    bool valid;
+    bool hasCoefs;
+    u16 format;
+    float rate;
+    float mix[12];
+    u16 coefs[16];
+} cwavEnvDspState_t;
+static cwavEnvDspState_t g_ndspStates[24];
+static u8* g_ndspSilence = NULL;
+static ndspAdpcmData g_ndspSilenceContext;
+static cwavEnvFrameHook g_frameHooks[CWAV_ENV_MAX_FRAME_HOOKS];
+
+// Application frame callback, set with cwavSetFrameCallback. The application thread fills the slot
+// not in use and then switches to it, so the ndsp thread never sees a callback with the data of another one.
+typedef struct cwavEnvAppCallback_s
+{
+    ndspCallback callback;
+    void* data;
+} cwavEnvAppCallback_t;
+static cwavEnvAppCallback_t g_appCallbacks[2];
+static u32 g_appCallbackIndex = 0;
 #endif
 
+// Paused and held channels count as playing, CSND does not report them as such.
+// Both masks can be changed from the ndsp thread (see cwavEnvApplyPause).
+static u32 g_pausedChannels = 0;
+static u32 g_heldChannels = 0;
+// Changed by every play and stop, so the ndsp thread can tell if a voice it feeds is still the same.
+static u32 g_channelSerials[32];
+// Channels libcwav may use, the other ones belong to the application and are never touched.
+static u32 g_channelMask = 0xFFFFFFFF;
+
+// Sample range of the last play of each channel, used to find the play position. Ranges are relative to block0.
+// CSND does not report the position, it is estimated from the time elapsed since basePosition.
+typedef struct cwavEnvPlayRange_s
+{
+    bool isLooped;
+    u32 loopStart;
+    u32 end;
+    float rate;
+    u64 baseTick;
+    u32 basePosition;
+} cwavEnvPlayRange_t;
+static cwavEnvPlayRange_t g_playRanges[32];
+
 #ifndef CWAV_DISABLE_CSND
 u32 cwav_defaultVAToPA(const void* addr)
 {
@@ -63,8 +122,9 @@ void cwavEnvInitialize()
     if (g_currentEnv == CWAV_ENV_DSP)
     {
 #ifndef CWAV_DISABLE_DSP
-        g_ndspWaveBuffers = malloc(sizeof(ndspWaveBuf) * 24 * 2);
-        memset(g_ndspWaveBuffers, 0, sizeof(ndspWaveBuf) * 24 * 2);
+        g_ndspWaveBuffers = malloc(sizeof(ndspWaveBuf) * 24 * CWAV_ENV_DSP_WAVEBUFS);
+        memset(g_ndspWaveBuffers, 0, sizeof(ndspWaveBuf) * 24 * CWAV_ENV_DSP_WAVEBUFS);
+        memset(g_ndspStates, 0, sizeof(g_ndspStates));
 #endif
     }
 }
@@ -77,6 +137,9 @@ void cwavEnvFinalize()
         if (g_ndspWaveBuffers)
             free(g_ndspWaveBuffers);
         g_ndspWaveBuffers = NULL;
+        if (g_ndspSilence)
+            linearFree(g_ndspSilence);
+        g_ndspSilence = NULL;
 #endif
     }
 }
@@ -84,9 +147,103 @@ void cwavEnvFinalize()
 #ifndef CWAV_DISABLE_DSP
 static inline ndspWaveBuf* cwavEnvGetNdspWaveBuffer(u32 channel, u32 block)
 {
-    return &g_ndspWaveBuffers[channel * 2 + block];
+    return &g_ndspWaveBuffers[channel * CWAV_ENV_DSP_WAVEBUFS + block];
+}
+
+// Queues the silence played before a delayed start, zeroed data is silent in every encoding.
+static void cwavEnvQueueStartDelay(u32 channel, u32 encFlag, float rate, u32 startDelay)
+{
+    if (!g_ndspSilence)
+    {
+        g_ndspSilence = linearAlloc(CWAV_ENV_SILENCE_SIZE);
+        if (!g_ndspSilence)
+            return;
+        memset(g_ndspSilence, 0, CWAV_ENV_SILENCE_SIZE);
+        svcFlushProcessDataCache(CUR_PROCESS_HANDLE, (u32)(uintptr_t)g_ndspSilence, CWAV_ENV_SILENCE_SIZE);
+    }
+
+    u32 maxSamples = encFlag == NDSP_FORMAT_PCM16 ? CWAV_ENV_SILENCE_SIZE / 2 :
+        (encFlag == NDSP_FORMAT_ADPCM ? CWAV_ENV_SILENCE_SIZE / 8 * 14 : CWAV_ENV_SILENCE_SIZE);
+    u32 samples = (u32)(startDelay * rate / CWAV_ENV_DSP_SAMPLE_RATE + 0.5f);
+    if (samples > maxSamples)
+        samples = maxSamples;
+    if (!samples)
+        return;
+
+    ndspWaveBuf* silenceBuff = cwavEnvGetNdspWaveBuffer(channel, CWAV_ENV_SILENCE_BLOCK);
+    memset(silenceBuff, 0, sizeof(ndspWaveBuf));
+    silenceBuff->data_vaddr = g_ndspSilence;
+    silenceBuff->nsamples = samples;
+    silenceBuff->adpcm_data = encFlag == NDSP_FORMAT_ADPCM ? &g_ndspSilenceContext : NULL;
+    ndspChnWaveBufAdd(channel, silenceBuff);
+}
+
+static void cwavEnvFrameCallback(void* data)
+{
+    for (int i = 0; i < CWAV_ENV_MAX_FRAME_HOOKS; i++)
+    {
+        cwavEnvFrameHook hook = __atomic_load_n(&g_frameHooks[i], __ATOMIC_ACQUIRE);
+        if (hook)
+            hook();
+    }
+
+    const cwavEnvAppCallback_t* app = &g_appCallbacks[__atomic_load_n(&g_appCallbackIndex, __ATOMIC_ACQUIRE)];
+    if (app->callback)
+        app->callback(app->data);
+}
+#endif
+
+bool cwavEnvSetAppFrameCallback(ndspCallback callback, void* data)
+{
+#ifndef CWAV_DISABLE_DSP
+    if (g_currentEnv != CWAV_ENV_DSP)
+        return false;
+    u32 next = __atomic_load_n(&g_appCallbackIndex, __ATOMIC_ACQUIRE) ^ 1;
+    g_appCallbacks[next].callback = callback;
+    g_appCallbacks[next].data = data;
+    __atomic_store_n(&g_appCallbackIndex, next, __ATOMIC_RELEASE);
+    ndspSetCallback(cwavEnvFrameCallback, NULL);
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool cwavEnvAddFrameHook(cwavEnvFrameHook hook)
+{
+#ifndef CWAV_DISABLE_DSP
+    if (g_currentEnv != CWAV_ENV_DSP)
+        return false;
+    int freeSlot = -1;
+    for (int i = 0; i < CWAV_ENV_MAX_FRAME_HOOKS; i++)
+    {
+        if (g_frameHooks[i] == hook)
+            return true;
+        if (!g_frameHooks[i] && freeSlot < 0)
+            freeSlot = i;
+    }
+    if (freeSlot < 0)
+        return false;
+    __atomic_store_n(&g_frameHooks[freeSlot], hook, __ATOMIC_RELEASE);
+    ndspSetCallback(cwavEnvFrameCallback, NULL);
+    return true;
+#else
+    return false;
+#endif
 }
+
+// The ndsp callback stays installed without hooks: it still runs the application callback, and clearing it
+// could remove a callback the application set with ndspSetCallback since.
+void cwavEnvRemoveFrameHook(cwavEnvFrameHook hook)
+{
+#ifndef CWAV_DISABLE_DSP
+    for (int i = 0; i < CWAV_ENV_MAX_FRAME_HOOKS; i++)
+    {
+        if (g_frameHooks[i] == hook)
+            __atomic_store_n(&g_frameHooks[i], NULL, __ATOMIC_RELEASE);
+    }
 #endif
+}
 
 bool cwavEnvCompatibleEncoding(cwavEncoding_t encoding)
 {
@@ -94,7 +251,8 @@ bool cwavEnvCompatibleEncoding(cwavEncoding_t encoding)
         return true;
 
 #ifndef CWAV_DISABLE_CSND
-    if (encoding == IMA_ADPCM && g_currentEnv == CWAV_ENV_CSND)
+    // DSP ADPCM is transcoded to IMA ADPCM the first time it is played.
+    if ((encoding == IMA_ADPCM || encoding == DSP_ADPCM) && g_currentEnv == CWAV_ENV_CSND)
         return true;
 #endif
 
@@ -123,8 +281,34 @@ u32 cwavEnvGetChannelAmount()
     return 0;
 }
 
+void cwavEnvSetChannelMask(u32 channelMask)
+{
+#ifndef CWAV_DISABLE_DSP
+    // The application may configure the channels it owns, so the cached state of every channel
+    // changing hands is dropped, playing or not.
+    u32 changed = g_channelMask ^ channelMask;
+    for (u32 channel = 0; changed && channel < 24; channel++, changed >>= 1)
+    {
+        if (changed & 1)
+        {
+            g_ndspStates[channel].valid = false;
+            g_ndspStates[channel].hasCoefs = false;
+        }
+    }
+#endif
+    g_channelMask = channelMask;
+}
+
+u32 cwavEnvGetChannelMask()
+{
+    return g_channelMask;
+}
+
 bool cwavEnvIsChannelAvailable(u32 channel) 
 {
+    if (!((g_channelMask >> channel) & 1))
+        return false;
+
     if (g_currentEnv == CWAV_ENV_CSND) 
     {
 #ifndef CWAV_DISABLE_CSND
@@ -141,7 +325,7 @@ bool cwavEnvIsChannelAvailable(u32 channel)
 }
 
 #ifndef CWAV_DISABLE_CSND
-bool cwavEnvPlayDirectSound(CWAV* cwav, int leftChannel, int rightChannel, u32 directSoundChannel, u32 directSoundPriority, ncsndDirectSoundModifiers* soundModifiers)
+bool cwavEnvPlayDirectSound(CWAV* cwav, int leftChannel, int rightChannel, u32 directSoundChannel, u32 directSoundPriority, const ncsndDirectSoundModifiers* soundModifiers, bool loopPass)
 {
     cwav_t* cwav_ = CWAVTOIMPL(cwav);
     ncsndDirectSound dirSound;
@@ -156,44 +340,56 @@ bool cwavEnvPlayDirectSound(CWAV* cwav, int leftChannel, int rightChannel, u32 d
     else
         return false;
     
-    u32 encoding = cwav_->cwavInfo->encoding;
+    if (!cwavAdpcmPrepareCsnd(cwav_))
+        return false;
+
+    u32 encoding = cwavAdpcmPlayEncoding(cwav_);
     u32 encFlag = 0;
+    u32 start = loopPass ? cwav_->cwavInfo->loopStart : 0;
+    u32 end = cwav_->cwavInfo->LoopEnd;
+    u32 offset = 0;
     u32 size = 0;
-    if (cwav_->cwavInfo->isLooped)
-        return false;
     
-    u8* leftSampleData = (u8*)((u32)cwav_->channelInfos[leftChannel]->samples.offset + (u8*)(&(cwav_->cwavData->data)));
-    u8* rightSampleData = 0;
-    if (channelCount == 2)
-        rightSampleData = (u8*)((u32)cwav_->channelInfos[rightChannel]->samples.offset + (u8*)(&(cwav_->cwavData->data)));
-
     switch (encoding)
     {
     case IMA_ADPCM:
         encFlag = NCSND_ENCODING_ADPCM;
-        size = (cwav_->cwavInfo->LoopEnd / 2);
+        offset = start / 2;
+        size = end / 2 - offset;
 
-        memcpy(&dirSound.channelData.leftAdpcmContext, &cwav_->IMAADPCMInfos[leftChannel]->context, sizeof(ncsndADPCMContext));
+        cwavIMAADPCMInfo_t* leftInfo = cwavAdpcmPlayImaInfo(cwav_, leftChannel);
+        memcpy(&dirSound.channelData.leftAdpcmContext, loopPass ? &leftInfo->loopContext : &leftInfo->context, sizeof(ncsndADPCMContext));
         if (channelCount == 2)
-            memcpy(&dirSound.channelData.rightAdpcmContext, &cwav_->IMAADPCMInfos[rightChannel]->context, sizeof(ncsndADPCMContext));
+        {
+            cwavIMAADPCMInfo_t* rightInfo = cwavAdpcmPlayImaInfo(cwav_, rightChannel);
+            memcpy(&dirSound.channelData.rightAdpcmContext, loopPass ? &rightInfo->loopContext : &rightInfo->context, sizeof(ncsndADPCMContext));
+        }
         
         break;
     case PCM8:
         encFlag = NCSND_ENCODING_PCM8;
-        size = (cwav_->cwavInfo->LoopEnd);
+        offset = start;
+        size = end - start;
         break;
     case PCM16:
         encFlag = NCSND_ENCODING_PCM16;
-        size = (cwav_->cwavInfo->LoopEnd * 2);
+        offset = start * 2;
+        size = (end - start) * 2;
         break;
     default:
-        break;
+        return false;
     }
 
-    soundModifiers->channelVolumes[0] = soundModifiers->channelVolumes[0] * cwav->volume;
-    soundModifiers->channelVolumes[1] = soundModifiers->channelVolumes[1] * cwav->volume;
+    u8* leftSampleData = (u8*)cwavAdpcmPlayData(cwav_, leftChannel) + offset;
+    u8* rightSampleData = 0;
+    if (channelCount == 2)
+        rightSampleData = (u8*)cwavAdpcmPlayData(cwav_, rightChannel) + offset;
 
-    memcpy(&dirSound.soundModifiers, soundModifiers, sizeof(ncsndDirectSoundModifiers));
+    // The volumes are scaled in the copy, the caller modifiers are left untouched.
+    if (soundModifiers)
+        memcpy(&dirSound.soundModifiers, soundModifiers, sizeof(ncsndDirectSoundModifiers));
+    dirSound.soundModifiers.channelVolumes[0] = dirSound.soundModifiers.channelVolumes[0] * cwav->volume;
+    dirSound.soundModifiers.channelVolumes[1] = dirSound.soundModifiers.channelVolumes[1] * cwav->volume;
 
     dirSound.channelData.channelAmount = channelCount;
     dirSound.channelData.channelEncoding = encFlag;
@@ -202,16 +398,26 @@ bool cwavEnvPlayDirectSound(CWAV* cwav, int leftChannel, int rightChannel, u32 d
     dirSound.channelData.isLeftPhys = true;
     dirSound.channelData.isRightPhys = true;
     if (leftSampleData)
-        dirSound.channelData.leftSampleData = (void*)cwavCurrentVAPAConvCallback(leftSampleData);
+        dirSound.channelData.leftSampleData = (void*)(uintptr_t)cwavCurrentVAPAConvCallback(leftSampleData);
     if (rightSampleData)
-        dirSound.channelData.rightSampleData = (void*)cwavCurrentVAPAConvCallback(rightSampleData);
+        dirSound.channelData.rightSampleData = (void*)(uintptr_t)cwavCurrentVAPAConvCallback(rightSampleData);
 
     return R_SUCCEEDED(ncsndPlayDirectSound(directSoundChannel, directSoundPriority, &dirSound));
 }
 #endif
 
-void cwavEnvPlay(u32 channel, bool isLooped, cwavEncoding_t encoding, u32 sampleRate, float volume, float pan, float pitch, void* block0, void* block1, u32 loopStart, u32 loopEnd, u32 totalSize, cwavIMAADPCMInfo_t* IMAADPCMInfos, cwavDSPADPCMInfo_t* DSPADPCMInfos)
+void cwavEnvPlay(u32 channel, bool isLooped, cwavEncoding_t encoding, u32 sampleRate, const float* mix, float pitch, void* block0, void* block1, u32 loopStart, u32 loopEnd, u32 totalSize, cwavIMAADPCMInfo_t* IMAADPCMInfos, cwavDSPADPCMInfo_t* DSPADPCMInfos, u32 startDelay)
 {
+    CWAV_TRACE_BEGIN(traceTick);
+    __atomic_fetch_and(&g_pausedChannels, ~(1u << channel), __ATOMIC_SEQ_CST);
+    __atomic_add_fetch(&g_channelSerials[channel], 1, __ATOMIC_SEQ_CST);
+    cwavEnvPlayRange_t* range = &g_playRanges[channel];
+    range->isLooped = isLooped;
+    range->loopStart = loopStart;
+    range->end = loopEnd;
+    range->rate = (float)(sampleRate) * pitch;
+    range->baseTick = svcGetSystemTick();
+    range->basePosition = 0;
     if (g_currentEnv == CWAV_ENV_CSND)
     {
 #ifndef CWAV_DISABLE_CSND
@@ -240,9 +446,9 @@ void cwavEnvPlay(u32 channel, bool isLooped, cwavEncoding_t encoding, u32 sample
         }
 
         sound.isPhysAddr = true;
-        sound.sampleData = (void*)cwavCurrentVAPAConvCallback(block0);
+        sound.sampleData = (void*)(uintptr_t)cwavCurrentVAPAConvCallback(block0);
         if (isLooped) {
-            sound.loopSampleData = (void*)cwavCurrentVAPAConvCallback(block1);
+            sound.loopSampleData = (void*)(uintptr_t)cwavCurrentVAPAConvCallback(block1);
         } else {
             sound.loopSampleData = sound.sampleData;
         }
@@ -250,9 +456,13 @@ void cwavEnvPlay(u32 channel, bool isLooped, cwavEncoding_t encoding, u32 sample
 
         sound.loopPlayback = isLooped;
         sound.sampleRate = sampleRate;
-        sound.volume = volume;
+        // CSND only has left and right volumes, the back outputs are folded into the front ones
+        // and the aux sends are ignored.
+        float left = mix[0] + mix[2];
+        float right = mix[1] + mix[3];
+        sound.volume = left + right;
         sound.pitch = pitch;
-        sound.pan = pan;
+        sound.pan = sound.volume > 0.f ? (right - left) / sound.volume : 0.f;
 
         ncsndPlaySound(channel, &sound);
 #endif
@@ -265,6 +475,8 @@ void cwavEnvPlay(u32 channel, bool isLooped, cwavEncoding_t encoding, u32 sample
         ndspWaveBuf* block0Buff = cwavEnvGetNdspWaveBuffer(channel, 0);
         ndspWaveBuf* block1Buff = cwavEnvGetNdspWaveBuffer(channel, 1);
 
+        cwavEnvDspState_t* state = &g_ndspStates[channel];
+
         switch (encoding)
         {
         case PCM8:
@@ -276,7 +488,14 @@ void cwavEnvPlay(u32 channel, bool isLooped, cwavEncoding_t encoding, u32 sample
         case DSP_ADPCM:
             encFlag = NDSP_FORMAT_ADPCM;
 
-            ndspChnSetAdpcmCoefs(channel, DSPADPCMInfos->param.coefs);
+            if (!state->hasCoefs || memcmp(state->coefs, DSPADPCMInfos->param.coefs, sizeof(state->coefs)))
+            {
+                ndspChnSetAdpcmCoefs(channel, DSPADPCMInfos->param.coefs);
+                memcpy(state->coefs, DSPADPCMInfos->param.coefs, sizeof(state->coefs));
+                state->hasCoefs = true;
+            }
+            else
+                CWAV_STATS_ADD(channelStateSkips, 1);
 
             if (isLooped)
             {
@@ -293,17 +512,33 @@ void cwavEnvPlay(u32 channel, bool isLooped, cwavEncoding_t encoding, u32 sample
             break;
         }
 
-        float mix[12] = {0};
-        float rightPan = (pan + 1.f) / 2.f;
-        float leftPan = 1.f - rightPan;
-        mix[0] = 0.8f * leftPan * volume; // Left front
-        mix[2] = 0.2f * leftPan * volume; // Left back
-        mix[1] = 0.8f * rightPan * volume; // Right front
-        mix[3] = 0.2f * rightPan * volume; // Right back
-
-        ndspChnSetFormat(channel, encFlag);
-        ndspChnSetRate(channel, (float)(sampleRate) * pitch);
-        ndspChnSetMix(channel, mix);
+        float rate = (float)(sampleRate) * pitch;
+        u32 skipped = 0;
+        if (!state->valid || state->format != encFlag)
+            ndspChnSetFormat(channel, encFlag);
+        else
+            skipped++;
+        if (!state->valid || state->rate != rate)
+            ndspChnSetRate(channel, rate);
+        else
+            skipped++;
+        if (!state->valid || memcmp(state->mix, mix, sizeof(state->mix)))
+        {
+            memcpy(state->mix, mix, sizeof(state->mix));
+            ndspChnSetMix(channel, state->mix);
+        }
+        else
+            skipped++;
+        state->valid = true;
+        state->format = encFlag;
+        state->rate = rate;
+        CWAV_STATS_ADD(channelStateSkips, skipped);
+
+        // Held channels are paused before anything is queued, so they cannot start early.
+        if (cwavEnvChannelIsHeld(channel))
+            ndspChnSetPaused(channel, true);
+        if (startDelay)
+            cwavEnvQueueStartDelay(channel, encFlag, (float)(sampleRate) * pitch, startDelay);
 
         block1Buff->data_vaddr = isLooped ? block1 : block0;
         block1Buff->nsamples = loopEnd - loopStart;
@@ -321,10 +556,22 @@ void cwavEnvPlay(u32 channel, bool isLooped, cwavEncoding_t encoding, u32 sample
         ndspChnWaveBufAdd(channel, block1Buff);
 #endif
     }
+    // Scheduled and held voices wait on purpose, that wait is not latency.
+    if (startDelay || cwavEnvChannelIsHeld(channel))
+        CWAV_LATENCY_VOICE_IGNORED(channel);
+    else
+        CWAV_LATENCY_VOICE_STARTED(channel);
+    CWAV_TRACE_END(traceTick, CWAV_TRACE_ENV_PLAY, NULL, 0, channel, -1);
 }
 
 bool cwavEnvChannelIsPlaying(u32 channel) 
 {
+    if (!((g_channelMask >> channel) & 1))
+        return false;
+
+    if (((__atomic_load_n(&g_pausedChannels, __ATOMIC_ACQUIRE) | __atomic_load_n(&g_heldChannels, __ATOMIC_ACQUIRE)) >> channel) & 1)
+        return true;
+
     if (g_currentEnv == CWAV_ENV_CSND)
     {
 #ifndef CWAV_DISABLE_CSND
@@ -333,12 +580,40 @@ bool cwavEnvChannelIsPlaying(u32 channel)
     }
     else if (g_currentEnv == CWAV_ENV_DSP)
     {
+#ifndef CWAV_DISABLE_DSP
+        for (u32 i = 0; i < CWAV_ENV_DSP_WAVEBUFS; i++)
+        {
+            ndspWaveBuf* buf = cwavEnvGetNdspWaveBuffer(channel, i);
+            if (i != CWAV_ENV_SILENCE_BLOCK && (buf->status == NDSP_WBUF_QUEUED || buf->status == NDSP_WBUF_PLAYING))
+                return true;
+        }
+        return false;
+#endif
+    }
+    return false;
+}
+
+bool cwavEnvChannelHasStarted(u32 channel)
+{
+    if (g_currentEnv == CWAV_ENV_CSND)
+    {
+#ifndef CWAV_DISABLE_CSND
+        // CSND does not report the play position, the channel is considered started once it is seen playing,
+        // so the latency depends on how often cwavLatencyUpdate is called.
+        return ncsndIsPlaying(channel);
+#endif
+    }
+    else if (g_currentEnv == CWAV_ENV_DSP)
+    {
 #ifndef CWAV_DISABLE_DSP
         ndspWaveBuf* block0Buff = cwavEnvGetNdspWaveBuffer(channel, 0);
         ndspWaveBuf* block1Buff = cwavEnvGetNdspWaveBuffer(channel, 1);
+        ndspWaveBuf* silenceBuff = cwavEnvGetNdspWaveBuffer(channel, CWAV_ENV_SILENCE_BLOCK);
 
-        return (block0Buff->status == NDSP_WBUF_QUEUED || block0Buff->status == NDSP_WBUF_PLAYING ||
-                block1Buff->status == NDSP_WBUF_QUEUED || block1Buff->status == NDSP_WBUF_PLAYING);
+        // The silence before a delayed start does not count.
+        if (silenceBuff->status == NDSP_WBUF_QUEUED || silenceBuff->status == NDSP_WBUF_PLAYING)
+            return false;
+        return ndspChnGetSamplePos(channel) > 0 || block0Buff->status == NDSP_WBUF_DONE || block1Buff->status == NDSP_WBUF_DONE;
 #endif
     }
     return false;
@@ -346,6 +621,13 @@ bool cwavEnvChannelIsPlaying(u32 channel)
 
 void cwavEnvStop(u32 channel)
 {
+    if (!((g_channelMask >> channel) & 1))
+        return;
+
+    CWAV_TRACE_INSTANT(CWAV_TRACE_ENV_STOP, NULL, 0, channel, -1);
+    __atomic_fetch_and(&g_pausedChannels, ~(1u << channel), __ATOMIC_SEQ_CST);
+    __atomic_fetch_and(&g_heldChannels, ~(1u << channel), __ATOMIC_SEQ_CST);
+    __atomic_add_fetch(&g_channelSerials[channel], 1, __ATOMIC_SEQ_CST);
     if (g_currentEnv == CWAV_ENV_CSND)
     {
 #ifndef CWAV_DISABLE_CSND
@@ -356,9 +638,172 @@ void cwavEnvStop(u32 channel)
     {
 #ifndef CWAV_DISABLE_DSP
         ndspChnReset(channel);
-        ndspWaveBuf* block0Buff = cwavEnvGetNdspWaveBuffer(channel, 0);
-        ndspWaveBuf* block1Buff = cwavEnvGetNdspWaveBuffer(channel, 1);
-        block0Buff->status = block1Buff->status = NDSP_WBUF_FREE;
+        g_ndspStates[channel].valid = false;
+        g_ndspStates[channel].hasCoefs = false;
+        for (u32 i = 0; i < CWAV_ENV_DSP_WAVEBUFS; i++)
+            cwavEnvGetNdspWaveBuffer(channel, i)->status = NDSP_WBUF_FREE;
+#endif
+    }
+}
+
+bool cwavEnvGetPlayPosition(u32 channel, u32* position)
+{
+    const cwavEnvPlayRange_t* range = &g_playRanges[channel];
+    if (!cwavEnvChannelIsPlaying(channel))
+        return false;
+
+    if (g_currentEnv == CWAV_ENV_CSND)
+    {
+#ifndef CWAV_DISABLE_CSND
+        u64 elapsed = (u64)((double)(svcGetSystemTick() - range->baseTick) * range->rate / SYSCLOCK_ARM11) + range->basePosition;
+        if (elapsed >= range->end)
+        {
+            if (!range->isLooped || range->end <= range->loopStart)
+                return false;
+            elapsed = range->loopStart + (elapsed - range->end) % (range->end - range->loopStart);
+        }
+        *position = (u32)elapsed;
+        return true;
+#endif
+    }
+    else if (g_currentEnv == CWAV_ENV_DSP)
+    {
+#ifndef CWAV_DISABLE_DSP
+        // Block 1 has the whole sound if it does not loop. The silence and segment buffers have no position.
+        if (cwavEnvGetNdspWaveBuffer(channel, 0)->status == NDSP_WBUF_PLAYING)
+            *position = ndspChnGetSamplePos(channel);
+        else if (cwavEnvGetNdspWaveBuffer(channel, 1)->status == NDSP_WBUF_PLAYING)
+            *position = (range->isLooped ? range->loopStart : 0) + ndspChnGetSamplePos(channel);
+        else
+            return false;
+        return true;
+#endif
+    }
+    return false;
+}
+
+u32 cwavEnvGetChannelSerial(u32 channel)
+{
+    return __atomic_load_n(&g_channelSerials[channel], __ATOMIC_SEQ_CST);
+}
+
+bool cwavEnvQueueSegment(u32 channel, void* data, u32 samples, cwavDSPADPCMContext_t* context)
+{
+#ifndef CWAV_DISABLE_DSP
+    if (g_currentEnv != CWAV_ENV_DSP)
+        return false;
+    for (u32 i = CWAV_ENV_FIRST_SEGMENT_BLOCK; i < CWAV_ENV_DSP_WAVEBUFS; i++)
+    {
+        ndspWaveBuf* buf = cwavEnvGetNdspWaveBuffer(channel, i);
+        if (buf->status != NDSP_WBUF_FREE && buf->status != NDSP_WBUF_DONE)
+            continue;
+        memset(buf, 0, sizeof(ndspWaveBuf));
+        buf->data_vaddr = data;
+        buf->nsamples = samples;
+        buf->adpcm_data = (ndspAdpcmData*)context;
+        ndspChnWaveBufAdd(channel, buf);
+        return true;
+    }
+#endif
+    return false;
+}
+
+u32 cwavEnvGetQueuedBuffers(u32 channel)
+{
+    u32 queued = 0;
+#ifndef CWAV_DISABLE_DSP
+    if (g_currentEnv != CWAV_ENV_DSP)
+        return 0;
+    for (u32 i = 0; i < CWAV_ENV_DSP_WAVEBUFS; i++)
+        queued += cwavEnvGetNdspWaveBuffer(channel, i)->status == NDSP_WBUF_QUEUED;
+#endif
+    return queued;
+}
+
+bool cwavEnvSetMix(u32 channel, const float* mix)
+{
+    // libncsnd cannot change the volume of a playing sound.
+    if (g_currentEnv == CWAV_ENV_DSP)
+    {
+#ifndef CWAV_DISABLE_DSP
+        memcpy(g_ndspStates[channel].mix, mix, sizeof(g_ndspStates[channel].mix));
+        ndspChnSetMix(channel, g_ndspStates[channel].mix);
+        return true;
+#endif
+    }
+    return false;
+}
+
+bool cwavEnvSetRate(u32 channel, float rate)
+{
+    // libncsnd cannot change the rate of a playing sound.
+    if (g_currentEnv == CWAV_ENV_DSP)
+    {
+#ifndef CWAV_DISABLE_DSP
+        g_ndspStates[channel].rate = rate;
+        ndspChnSetRate(channel, rate);
+        return true;
 #endif
     }
-}
\ No newline at end of file
+    return false;
+}
+
+// A channel is paused while it is paused or held. The ndsp thread releases held channels while the
+// application can pause them, so the state is applied again if the masks changed in the meantime.
+static void cwavEnvApplyPause(u32 channel)
+{
+    u32 mask;
+    do
+    {
+        mask = __atomic_load_n(&g_pausedChannels, __ATOMIC_SEQ_CST) | __atomic_load_n(&g_heldChannels, __ATOMIC_SEQ_CST);
+#ifndef CWAV_DISABLE_DSP
+        if (g_currentEnv == CWAV_ENV_DSP)
+            ndspChnSetPaused(channel, (mask >> channel) & 1);
+#endif
+    } while (mask != (__atomic_load_n(&g_pausedChannels, __ATOMIC_SEQ_CST) | __atomic_load_n(&g_heldChannels, __ATOMIC_SEQ_CST)));
+}
+
+bool cwavEnvSetPaused(u32 channel, bool paused)
+{
+    // libncsnd cannot pause a playing sound.
+    if (g_currentEnv != CWAV_ENV_DSP)
+        return false;
+
+    if (paused)
+    {
+        __atomic_fetch_or(&g_pausedChannels, 1u << channel, __ATOMIC_SEQ_CST);
+        CWAV_LATENCY_VOICE_IGNORED(channel);
+    }
+    else
+        __atomic_fetch_and(&g_pausedChannels, ~(1u << channel), __ATOMIC_SEQ_CST);
+    cwavEnvApplyPause(channel);
+    return true;
+}
+
+void cwavEnvSetHeld(u32 channel, bool held)
+{
+    if (held)
+        __atomic_fetch_or(&g_heldChannels, 1u << channel, __ATOMIC_SEQ_CST);
+    else if (__atomic_fetch_and(&g_heldChannels, ~(1u << channel), __ATOMIC_SEQ_CST) & (1u << channel))
+        cwavEnvApplyPause(channel);
+}
+
+void cwavEnvReleaseHeld(u32 channels)
+{
+    u32 released = __atomic_fetch_and(&g_heldChannels, ~channels, __ATOMIC_SEQ_CST) & channels;
+    for (u32 channel = 0; released; channel++, released >>= 1)
+    {
+        if (released & 1)
+            cwavEnvApplyPause(channel);
+    }
+}
+
+bool cwavEnvChannelIsHeld(u32 channel)
+{
+    return (__atomic_load_n(&g_heldChannels, __ATOMIC_ACQUIRE) >> channel) & 1;
+}
+
+bool cwavEnvChannelIsPaused(u32 channel)
+{
+    return (__atomic_load_n(&g_pausedChannels, __ATOMIC_ACQUIRE) >> channel) & 1;
+}
@@ -0,0 +1,141 @@
+#include "internal/cwav_latency.h"
+#include "internal/cwav_env.h"
+#include "3ds.h"
+#include <string.h>
+
+#define CWAV_LATENCY_MAX_CHANNELS 32
+#define CWAV_LATENCY_BUCKET_US 100
+#define CWAV_LATENCY_BUCKETS 256
+
+bool g_cwavLatencyEnabled = false;
+#ifndef CWAV_DISABLE_DSP
+static bool g_latencyUsesNdspCallback = false;
+#endif
+static u32 g_latencyPlayTick = 0;
+// Tick of the play call for each voice waiting for its first samples to be consumed, 0 if none.
+// Ticks are truncated to 32 bits (wraps every ~16 seconds), which is enough for latency deltas.
+static u32 g_latencyPendingTicks[CWAV_LATENCY_MAX_CHANNELS];
+static u32 g_latencyHistograms[2][CWAV_LATENCY_BUCKETS];
+static u32 g_latencyMin[2];
+static u32 g_latencyMax[2];
+
+void cwavLatencyPlayBegin()
+{
+    // Never 0, as 0 marks the voice as not pending.
+    g_latencyPlayTick = (u32)svcGetSystemTick() | 1;
+}
+
+void cwavLatencyVoiceStarted(u32 channel)
+{
+    if (channel < CWAV_LATENCY_MAX_CHANNELS)
+        __atomic_store_n(&g_latencyPendingTicks[channel], g_latencyPlayTick, __ATOMIC_RELEASE);
+}
+
+// The voice waits on purpose (scheduled, held or paused), it is not measured.
+void cwavLatencyVoiceIgnored(u32 channel)
+{
+    if (channel < CWAV_LATENCY_MAX_CHANNELS)
+        __atomic_store_n(&g_latencyPendingTicks[channel], 0, __ATOMIC_RELEASE);
+}
+
+static void cwav_latencyRecord(cwavEnvMode_t env, u32 latencyUs)
+{
+    u32 bucket = latencyUs / CWAV_LATENCY_BUCKET_US;
+    if (bucket >= CWAV_LATENCY_BUCKETS)
+        bucket = CWAV_LATENCY_BUCKETS - 1;
+    g_latencyHistograms[env][bucket]++;
+    if (latencyUs < g_latencyMin[env])
+        g_latencyMin[env] = latencyUs;
+    if (latencyUs > g_latencyMax[env])
+        g_latencyMax[env] = latencyUs;
+}
+
+void cwavLatencyUpdate()
+{
+    if (!g_cwavLatencyEnabled)
+        return;
+
+    cwavEnvMode_t env = cwavEnvGetEnvironment();
+    u32 now = (u32)svcGetSystemTick();
+    u32 channelAmount = cwavEnvGetChannelAmount();
+    if (channelAmount > CWAV_LATENCY_MAX_CHANNELS)
+        channelAmount = CWAV_LATENCY_MAX_CHANNELS;
+
+    for (u32 i = 0; i < channelAmount; i++)
+    {
+        u32 playTick = __atomic_load_n(&g_latencyPendingTicks[i], __ATOMIC_ACQUIRE);
+        if (!playTick || !cwavEnvChannelHasStarted(i))
+            continue;
+        // Only clear the voice if it was not restarted in the meantime.
+        if (__atomic_compare_exchange_n(&g_latencyPendingTicks[i], &playTick, 0, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            cwav_latencyRecord(env, (u32)((u64)(now - playTick) * 1000000 / SYSCLOCK_ARM11));
+    }
+}
+
+
+void cwavLatencyReset()
+{
+    memset(g_latencyPendingTicks, 0, sizeof(g_latencyPendingTicks));
+    memset(g_latencyHistograms, 0, sizeof(g_latencyHistograms));
+    g_latencyMin[0] = g_latencyMin[1] = 0xFFFFFFFF;
+    g_latencyMax[0] = g_latencyMax[1] = 0;
+}
+
+void cwavLatencyStart(bool useNdspCallback)
+{
+    cwavLatencyReset();
+    g_cwavLatencyEnabled = true;
+
+#ifndef CWAV_DISABLE_DSP
+    g_latencyUsesNdspCallback = useNdspCallback && cwavEnvAddFrameHook(cwavLatencyUpdate);
+#endif
+}
+
+void cwavLatencyStop()
+{
+    g_cwavLatencyEnabled = false;
+
+#ifndef CWAV_DISABLE_DSP
+    if (g_latencyUsesNdspCallback)
+        cwavEnvRemoveFrameHook(cwavLatencyUpdate);
+    g_latencyUsesNdspCallback = false;
+#endif
+}
+
+static u32 cwav_latencyPercentile(const u32* histogram, u32 total, u32 percent)
+{
+    u32 target = (total * percent + 99) / 100;
+    u32 count = 0;
+    for (u32 i = 0; i < CWAV_LATENCY_BUCKETS; i++)
+    {
+        count += histogram[i];
+        if (count >= target)
+            return (i + 1) * CWAV_LATENCY_BUCKET_US;
+    }
+    return CWAV_LATENCY_BUCKETS * CWAV_LATENCY_BUCKET_US;
+}
+
+void cwavLatencyGetReport(cwavEnvMode_t env, cwavLatencyReport* out)
+{
+    if (!out)
+        return;
+
+    memset(out, 0, sizeof(cwavLatencyReport));
+    if (env != CWAV_ENV_DSP && env != CWAV_ENV_CSND)
+        return;
+
+    const u32* histogram = g_latencyHistograms[env];
+    for (u32 i = 0; i < CWAV_LATENCY_BUCKETS; i++)
+        out->samples += histogram[i];
+    if (!out->samples)
+        return;
+
+    out->minUs = g_latencyMin[env];
+    out->maxUs = g_latencyMax[env];
+    out->p50Us = cwav_latencyPercentile(histogram, out->samples, 50);
+    out->p99Us = cwav_latencyPercentile(histogram, out->samples, 99);
+    out->bucketUs = CWAV_LATENCY_BUCKET_US;
+    out->bucketCount = CWAV_LATENCY_BUCKETS;
+    out->histogram = histogram;
+    out->approximate = env == CWAV_ENV_CSND;
+}
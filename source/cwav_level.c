@@ -0,0 +1,198 @@
+#include "internal/cwav_level.h"
+#include "internal/cwav_adpcm.h"
+#include "internal/cwav_env.h"
+#include "internal/cwav_voice.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__ARM_FEATURE_SIMD32)
+#include <arm_acle.h>
+#endif
+
+#define CWAVTOIMPL(c) ((cwav_t*)c->cwav)
+
+static bool g_levelEnabled = false;
+
+static inline u32 cwav_levelBlockCount(const cwav_t* cwav)
+{
+    return (cwav->cwavInfo->LoopEnd + CWAV_LEVEL_BLOCK_SAMPLES - 1) / CWAV_LEVEL_BLOCK_SAMPLES;
+}
+
+// Writes the peak and RMS of the samples. The squares of sample pairs are summed with one SMLALD on ARMv6.
+static void cwav_levelMeasure(const s16* samples, u32 count, u16* out)
+{
+    s32 peak = 0;
+    s64 sum = 0;
+    u32 i = 0;
+#if defined(__ARM_FEATURE_SIMD32)
+    for (; i + 1 < count; i += 2)
+    {
+        int16x2_t pair;
+        memcpy(&pair, &samples[i], sizeof(pair));
+        sum = __smlald(pair, pair, sum);
+        s32 a = samples[i] < 0 ? -samples[i] : samples[i];
+        s32 b = samples[i + 1] < 0 ? -samples[i + 1] : samples[i + 1];
+        peak = a > peak ? a : peak;
+        peak = b > peak ? b : peak;
+    }
+#endif
+    for (; i < count; i++)
+    {
+        s32 sample = samples[i];
+        s32 magnitude = sample < 0 ? -sample : sample;
+        peak = magnitude > peak ? magnitude : peak;
+        sum += sample * sample;
+    }
+    out[0] = (u16)(peak > 0x7FFF ? 0x7FFF : peak);
+    out[1] = (u16)sqrtf((float)sum / count);
+}
+
+static void cwav_levelBuildChannel(const cwav_t* cwav, int channel, u16* out)
+{
+    s16 block[CWAV_LEVEL_BLOCK_SAMPLES];
+    u32 samples = cwav->cwavInfo->LoopEnd;
+    const u8* data = (const u8*)cwav->sampleData[channel];
+    s32 hist1 = 0, hist2 = 0, predictor = 0, tableIndex = 0;
+    if (cwav->cwavInfo->encoding == DSP_ADPCM)
+    {
+        hist1 = (s16)cwav->DSPADPCMInfos[channel]->context.prevSample;
+        hist2 = (s16)cwav->DSPADPCMInfos[channel]->context.secondPrevSample;
+    }
+    else if (cwav->cwavInfo->encoding == IMA_ADPCM)
+    {
+        predictor = (s16)cwav->IMAADPCMInfos[channel]->context.data;
+        tableIndex = cwav->IMAADPCMInfos[channel]->context.tableIndex;
+    }
+
+    for (u32 start = 0; start < samples; start += CWAV_LEVEL_BLOCK_SAMPLES, out += 2)
+    {
+        u32 count = samples - start < CWAV_LEVEL_BLOCK_SAMPLES ? samples - start : CWAV_LEVEL_BLOCK_SAMPLES;
+        const s16* measured = block;
+        switch (cwav->cwavInfo->encoding)
+        {
+        case PCM8:
+            for (u32 i = 0; i < count; i++)
+                block[i] = (s16)(((s8)data[start + i]) * 256);
+            break;
+        case PCM16:
+            measured = (const s16*)data + start;
+            break;
+        case DSP_ADPCM:
+            for (u32 i = 0; i < count; i++)
+                block[i] = cwavAdpcmDecodeDsp(data, start + i, cwav->DSPADPCMInfos[channel]->param.coefs, &hist1, &hist2);
+            break;
+        case IMA_ADPCM:
+            for (u32 i = 0; i < count; i++)
+            {
+                u32 sample = start + i;
+                block[i] = cwavAdpcmDecodeIma((sample & 1) ? (data[sample / 2] >> 4) : (data[sample / 2] & 0xF), &predictor, &tableIndex);
+            }
+            break;
+        default:
+            memset(block, 0, sizeof(block));
+            break;
+        }
+        cwav_levelMeasure(measured, count, out);
+    }
+}
+
+bool cwavLevelIsEnabled()
+{
+    return g_levelEnabled;
+}
+
+void cwavLevelBuild(cwav_t* cwav)
+{
+    u32 blocks = cwav_levelBlockCount(cwav);
+    if (!blocks)
+        return;
+    cwav->levelEnvelope = (u16*)malloc(cwavLevelEnvelopeSize(cwav));
+    if (!cwav->levelEnvelope)
+        return;
+    for (int i = 0; i < cwav->channelcount; i++)
+        cwav_levelBuildChannel(cwav, i, cwav->levelEnvelope + i * blocks * 2);
+}
+
+void cwavLevelFree(cwav_t* cwav)
+{
+    free(cwav->levelEnvelope);
+    cwav->levelEnvelope = NULL;
+}
+
+u32 cwavLevelEnvelopeSize(const cwav_t* cwav)
+{
+    return cwav_levelBlockCount(cwav) * cwav->channelcount * 2 * sizeof(u16);
+}
+
+void cwavEnableLevelEnvelopes(bool enable)
+{
+    g_levelEnabled = enable;
+}
+
+// Whether the environment channel still plays the voice started by the play, and not one played after it.
+static bool cwav_levelIsOwnVoice(const cwav_t* cwav, int play, int cwavChannel)
+{
+    int channel = cwav->playingChanIds[play][cwavChannel];
+    return channel != -1 && cwavEnvGetChannelSerial(channel) == cwav->playingSerials[play * cwav->channelcount + cwavChannel];
+}
+
+// Level of the CWAV channel played on the environment channel at its current position, scaled by the voice volume.
+static void cwav_levelOfVoice(cwav_t* cwav, int cwavChannel, u32 channel, cwavLevel* out)
+{
+    out->peak = out->rms = 0.f;
+    cwavVoice_t* voice = cwavVoiceGetLive(channel);
+    u32 position;
+    if (!voice || !cwavEnvGetPlayPosition(channel, &position))
+        return;
+
+    u32 block = (voice->firstSample + position) / CWAV_LEVEL_BLOCK_SAMPLES;
+    u32 blocks = cwav_levelBlockCount(cwav);
+    if (block >= blocks)
+        return;
+    const u16* values = cwav->levelEnvelope + (cwavChannel * blocks + block) * 2;
+    float gain = voice->volume * voice->categoryGain * voice->stemGain;
+    out->peak = values[0] / 32768.f * gain;
+    out->rms = values[1] / 32768.f * gain;
+}
+
+bool cwavGetVoiceLevel(CWAV* cwav, u32 channel, cwavLevel* out)
+{
+    if (!cwav || cwav->loadStatus != CWAV_SUCCESS || !out || !CWAVTOIMPL(cwav)->levelEnvelope)
+        return false;
+
+    cwav_t* cwav_ = CWAVTOIMPL(cwav);
+    for (int i = 0; i < cwav_->totalMultiplePlay; i++)
+    {
+        for (int j = 0; j < cwav_->channelcount; j++)
+        {
+            if (cwav_->playingChanIds[i][j] == (int)channel && cwav_levelIsOwnVoice(cwav_, i, j))
+            {
+                cwav_levelOfVoice(cwav_, j, channel, out);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool cwavGetLevel(CWAV* cwav, cwavLevel* out)
+{
+    if (!cwav || cwav->loadStatus != CWAV_SUCCESS || !out || !CWAVTOIMPL(cwav)->levelEnvelope)
+        return false;
+
+    cwav_t* cwav_ = CWAVTOIMPL(cwav);
+    out->peak = out->rms = 0.f;
+    for (int i = 0; i < cwav_->totalMultiplePlay; i++)
+    {
+        for (int j = 0; j < cwav_->channelcount; j++)
+        {
+            if (!cwav_levelIsOwnVoice(cwav_, i, j))
+                continue;
+            cwavLevel level;
+            cwav_levelOfVoice(cwav_, j, cwav_->playingChanIds[i][j], &level);
+            out->peak = level.peak > out->peak ? level.peak : out->peak;
+            out->rms = level.rms > out->rms ? level.rms : out->rms;
+        }
+    }
+    return true;
+}
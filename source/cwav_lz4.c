@@ -0,0 +1,155 @@
+#include "internal/cwav_lz4.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define CWAV_LZ4_MIN_MATCH 4
+
+static inline bool cwav_lz4ReadLength(const u8** src, const u8* srcEnd, u32* length)
+{
+    u32 byte;
+    do
+    {
+        if (*src >= srcEnd)
+            return false;
+        byte = *(*src)++;
+        *length += byte;
+    } while (byte == 0xFF);
+    return true;
+}
+
+// Decompresses a raw LZ4 block, every read and write is bounds checked.
+// Returns the amount of decompressed bytes or -1 if the block is malformed.
+int cwavLz4DecompressBlock(const u8* src, u32 srcSize, u8* dst, u32 dstCapacity)
+{
+    const u8* srcEnd = src + srcSize;
+    u8* dstStart = dst;
+    u8* dstEnd = dst + dstCapacity;
+
+    while (src < srcEnd)
+    {
+        u32 token = *src++;
+
+        u32 literalLength = token >> 4;
+        if (literalLength == 0xF && !cwav_lz4ReadLength(&src, srcEnd, &literalLength))
+            return -1;
+        if (literalLength > (u32)(srcEnd - src) || literalLength > (u32)(dstEnd - dst))
+            return -1;
+        memcpy(dst, src, literalLength);
+        src += literalLength;
+        dst += literalLength;
+
+        // The last sequence only contains literals.
+        if (src >= srcEnd)
+            break;
+
+        if (srcEnd - src < 2)
+            return -1;
+        u32 matchOffset = src[0] | (src[1] << 8);
+        src += 2;
+        if (matchOffset == 0 || matchOffset > (u32)(dst - dstStart))
+            return -1;
+
+        u32 matchLength = token & 0xF;
+        if (matchLength == 0xF && !cwav_lz4ReadLength(&src, srcEnd, &matchLength))
+            return -1;
+        matchLength += CWAV_LZ4_MIN_MATCH;
+        if (matchLength > (u32)(dstEnd - dst))
+            return -1;
+
+        // Matches can overlap the output, so copy byte by byte in that case.
+        const u8* match = dst - matchOffset;
+        if (matchOffset >= matchLength)
+            memcpy(dst, match, matchLength);
+        else
+        {
+            for (u32 i = 0; i < matchLength; i++)
+                dst[i] = match[i];
+        }
+        dst += matchLength;
+    }
+    return (int)(dst - dstStart);
+}
+
+static void cwav_lz4Unfilter(const u8* src, u32 size, u32 filter, u8* dst)
+{
+    if (filter == CWAV_LZ4_BLOCK_DELTA8)
+    {
+        u8 prev = 0;
+        for (u32 i = 0; i < size; i++)
+            dst[i] = prev = (u8)(prev + src[i]);
+        return;
+    }
+
+    u32 half = size / 2;
+    u16 prev = 0;
+    for (u32 i = 0; i < half; i++)
+    {
+        prev = (u16)(prev + (src[i] | (src[half + i] << 8)));
+        dst[2 * i] = prev & 0xFF;
+        dst[2 * i + 1] = prev >> 8;
+    }
+    if (size & 1)
+        dst[size - 1] = src[size - 1];
+}
+
+bool cwavLz4ReadHeader(FILE* file, cwavLz4Header_t* header)
+{
+    if (fread(header, 1, sizeof(cwavLz4Header_t), file) == sizeof(cwavLz4Header_t) && header->magic == CWAV_LZ4_MAGIC)
+        return true;
+
+    header->magic = 0;
+    fseek(file, 0, SEEK_SET);
+    return false;
+}
+
+bool cwavLz4ReadFile(FILE* file, const cwavLz4Header_t* header, u8* dst)
+{
+    if (!header->blockSize)
+        return false;
+
+    // Worst case size of an LZ4 block that does not compress.
+    u32 maxCompressedSize = header->blockSize + header->blockSize / 255 + 16;
+    u8* compressed = malloc(maxCompressedSize);
+    if (!compressed)
+        return false;
+    // Filtered blocks are decompressed here first, only allocated if the file has any.
+    u8* filtered = NULL;
+
+    bool success = true;
+    u32 offset = 0;
+    while (success && offset < header->decompressedSize)
+    {
+        u32 remaining = header->decompressedSize - offset;
+        u32 expectedSize = remaining < header->blockSize ? remaining : header->blockSize;
+
+        u32 blockHeader = 0;
+        if (fread(&blockHeader, 1, sizeof(u32), file) != sizeof(u32))
+        {
+            success = false;
+            break;
+        }
+
+        u32 compressedSize = blockHeader & ~CWAV_LZ4_BLOCK_FLAGS;
+        u32 filter = blockHeader & (CWAV_LZ4_BLOCK_DELTA8 | CWAV_LZ4_BLOCK_DELTA16);
+        if (filter && !filtered)
+            filtered = malloc(header->blockSize);
+        if (blockHeader & CWAV_LZ4_BLOCK_STORED)
+        {
+            // Stored blocks are read directly into the destination.
+            success = compressedSize == expectedSize && fread(dst + offset, 1, expectedSize, file) == expectedSize;
+        }
+        else
+        {
+            u8* blockDst = filter ? filtered : dst + offset;
+            success = blockDst && compressedSize <= maxCompressedSize && fread(compressed, 1, compressedSize, file) == compressedSize &&
+                cwavLz4DecompressBlock(compressed, compressedSize, blockDst, expectedSize) == (int)expectedSize;
+            if (success && filter)
+                cwav_lz4Unfilter(filtered, expectedSize, filter, dst + offset);
+        }
+        offset += expectedSize;
+    }
+
+    free(compressed);
+    free(filtered);
+    return success;
+}
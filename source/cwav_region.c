@@ -0,0 +1,184 @@
+#include "internal/cwav_region.h"
+#include "internal/cwav_adpcm.h"
+#include "internal/cwav_env.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define CWAVTOIMPL(c) ((cwav_t*)c->cwav)
+
+u32 cwavRegionSampleOffset(u32 encoding, u32 sample)
+{
+    switch (encoding)
+    {
+    case DSP_ADPCM:
+        return (sample / CWAV_DSP_ADPCM_FRAME_SAMPLES) * CWAV_DSP_ADPCM_FRAME_BYTES;
+    case IMA_ADPCM:
+        return sample / 2;
+    case PCM8:
+        return sample;
+    case PCM16:
+        return sample * 2;
+    default:
+        return 0;
+    }
+}
+
+u32 cwavRegionAlign(u32 encoding, u32 sample)
+{
+    switch (encoding)
+    {
+    case DSP_ADPCM:
+        return sample - sample % CWAV_DSP_ADPCM_FRAME_SAMPLES;
+    case IMA_ADPCM:
+        return sample & ~1u;
+    default:
+        return sample;
+    }
+}
+
+// Decodes the channel from its start up to the region start, then up to the loop start (which is not before it).
+static void cwav_regionDspContexts(const u8* data, const cwavDSPADPCMInfo_t* info, u32 start, u32 loopStart, cwavDSPADPCMInfo_t* out)
+{
+    s32 hist1 = (s16)info->context.prevSample;
+    s32 hist2 = (s16)info->context.secondPrevSample;
+    u32 targets[2] = {start, loopStart};
+    cwavDSPADPCMContext_t* contexts[2] = {&out->context, &out->loopContext};
+
+    u32 sample = 0;
+    for (int t = 0; t < 2; t++)
+    {
+        for (; sample < targets[t]; sample++)
+            cwavAdpcmDecodeDsp(data, sample, info->param.coefs, &hist1, &hist2);
+
+        contexts[t]->predScale = data[(targets[t] / CWAV_DSP_ADPCM_FRAME_SAMPLES) * CWAV_DSP_ADPCM_FRAME_BYTES];
+        contexts[t]->prevSample = (u16)hist1;
+        contexts[t]->secondPrevSample = (u16)hist2;
+    }
+}
+
+// Same as above for IMA ADPCM, the low nibble of each byte is the first sample.
+static void cwav_regionImaContexts(const u8* data, const cwavIMAADPCMInfo_t* info, u32 start, u32 loopStart, cwavIMAADPCMInfo_t* out)
+{
+    s32 predictor = (s16)info->context.data;
+    s32 tableIndex = info->context.tableIndex;
+    u32 targets[2] = {start, loopStart};
+    cwavIMAADPCMContext_t* contexts[2] = {&out->context, &out->loopContext};
+
+    u32 sample = 0;
+    for (int t = 0; t < 2; t++)
+    {
+        for (; sample < targets[t]; sample++)
+            cwavAdpcmDecodeIma((sample & 1) ? (data[sample / 2] >> 4) : (data[sample / 2] & 0xF), &predictor, &tableIndex);
+
+        contexts[t]->data = (u16)predictor;
+        contexts[t]->tableIndex = (u8)tableIndex;
+        contexts[t]->padding = 0;
+    }
+}
+
+static void cwav_regionFree(cwavRegionImpl_t* region)
+{
+    free(region->IMAADPCMInfos);
+    free(region->DSPADPCMInfos);
+}
+
+const cwavRegionImpl_t* cwavRegionGet(cwav_t* cwav, int index)
+{
+    if (index < 0 || (u32)index >= cwav->regionCount)
+        return NULL;
+    return &cwav->regions[index];
+}
+
+void cwavRegionFreeAll(cwav_t* cwav)
+{
+    for (u32 i = 0; i < cwav->regionCount; i++)
+        cwav_regionFree(&cwav->regions[i]);
+    free(cwav->regions);
+    cwav->regions = NULL;
+    cwav->regionCount = 0;
+}
+
+int cwavAddRegion(CWAV* cwav, const char* name, const cwavRegion* region)
+{
+    if (!cwav || cwav->loadStatus != CWAV_SUCCESS || !region)
+        return -1;
+
+    // The region contexts would have to be computed on the transcoded data.
+    cwav_t* cwav_ = CWAVTOIMPL(cwav);
+    u32 encoding = cwav_->cwavInfo->encoding;
+    if (encoding == DSP_ADPCM && cwavEnvGetEnvironment() == CWAV_ENV_CSND)
+        return -1;
+
+    cwavRegionImpl_t impl;
+    memset(&impl, 0, sizeof(impl));
+    if (name)
+        strncpy(impl.name, name, CWAV_REGION_NAME_SIZE - 1);
+    impl.start = cwavRegionAlign(encoding, region->start);
+    impl.end = region->end;
+    impl.isLooped = region->isLooped;
+    impl.loopStart = region->isLooped ? cwavRegionAlign(encoding, region->loopStart) : impl.start;
+    if (impl.end > cwav_->cwavInfo->LoopEnd || impl.start >= impl.end || impl.loopStart < impl.start || impl.loopStart >= impl.end)
+        return -1;
+
+    if (encoding == DSP_ADPCM)
+    {
+        impl.DSPADPCMInfos = (cwavDSPADPCMInfo_t*)malloc(sizeof(cwavDSPADPCMInfo_t) * cwav_->channelcount);
+        if (!impl.DSPADPCMInfos)
+            return -1;
+        for (int i = 0; i < cwav_->channelcount; i++)
+        {
+            impl.DSPADPCMInfos[i] = *cwav_->DSPADPCMInfos[i];
+            cwav_regionDspContexts((const u8*)cwav_->sampleData[i], cwav_->DSPADPCMInfos[i], impl.start, impl.loopStart, &impl.DSPADPCMInfos[i]);
+        }
+    }
+    else if (encoding == IMA_ADPCM)
+    {
+        impl.IMAADPCMInfos = (cwavIMAADPCMInfo_t*)malloc(sizeof(cwavIMAADPCMInfo_t) * cwav_->channelcount);
+        if (!impl.IMAADPCMInfos)
+            return -1;
+        for (int i = 0; i < cwav_->channelcount; i++)
+            cwav_regionImaContexts((const u8*)cwav_->sampleData[i], cwav_->IMAADPCMInfos[i], impl.start, impl.loopStart, &impl.IMAADPCMInfos[i]);
+    }
+
+    cwavRegionImpl_t* regions = (cwavRegionImpl_t*)realloc(cwav_->regions, sizeof(cwavRegionImpl_t) * (cwav_->regionCount + 1));
+    if (!regions)
+    {
+        cwav_regionFree(&impl);
+        return -1;
+    }
+
+    cwav_->regions = regions;
+    cwav_->regions[cwav_->regionCount] = impl;
+    return (int)(cwav_->regionCount++);
+}
+
+int cwavFindRegion(CWAV* cwav, const char* name)
+{
+    if (!cwav || cwav->loadStatus != CWAV_SUCCESS || !name)
+        return -1;
+
+    cwav_t* cwav_ = CWAVTOIMPL(cwav);
+    for (u32 i = 0; i < cwav_->regionCount; i++)
+    {
+        if (strncmp(cwav_->regions[i].name, name, CWAV_REGION_NAME_SIZE - 1) == 0)
+            return (int)i;
+    }
+    return -1;
+}
+
+u32 cwavGetRegionCount(CWAV* cwav)
+{
+    if (!cwav || cwav->loadStatus != CWAV_SUCCESS)
+        return 0;
+    return CWAVTOIMPL(cwav)->regionCount;
+}
+
+void cwavClearRegions(CWAV* cwav)
+{
+    if (!cwav || cwav->loadStatus != CWAV_SUCCESS)
+        return;
+
+    // The voices playing a region read its ADPCM contexts.
+    cwavStop(cwav, -1, -1);
+    cwavRegionFreeAll(CWAVTOIMPL(cwav));
+}
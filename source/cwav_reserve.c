@@ -0,0 +1,150 @@
+#include "internal/cwav_reserve.h"
+#include "internal/cwav_env.h"
+#include "internal/cwav_voice.h"
+
+#define CWAV_RESERVE_MAX_CHANNELS 32
+
+// Owner of each reserved channel: a CWAV, or a category when the CWAV is NULL.
+typedef struct cwavReservation_s
+{
+    const CWAV* cwav;
+    u8 category;
+} cwavReservation_t;
+
+static cwavReservation_t g_reservations[CWAV_RESERVE_MAX_CHANNELS];
+static u32 g_reservedChannels = 0;
+static u32 g_channelBudget = CWAV_UNLIMITED_CHANNELS;
+static u32 g_categoryBudgets[CWAV_CATEGORY_COUNT] = {CWAV_UNLIMITED_CHANNELS, CWAV_UNLIMITED_CHANNELS, CWAV_UNLIMITED_CHANNELS, CWAV_UNLIMITED_CHANNELS};
+static bool g_hasBudget = false;
+
+static bool cwav_reserveValidMask(u32 channelMask)
+{
+    u32 channelAmount = cwavEnvGetChannelAmount();
+    for (u32 channel = 0; channelMask; channel++, channelMask >>= 1)
+    {
+        if ((channelMask & 1) && (channel >= channelAmount || !cwavEnvIsChannelAvailable(channel)))
+            return false;
+    }
+    return true;
+}
+
+static bool cwav_reserve(u32 channelMask, const CWAV* cwav, u8 category)
+{
+    if (!channelMask || !cwav_reserveValidMask(channelMask))
+        return false;
+
+    for (u32 channel = 0; channel < CWAV_RESERVE_MAX_CHANNELS; channel++)
+    {
+        if (!((channelMask >> channel) & 1))
+            continue;
+        g_reservations[channel].cwav = cwav;
+        g_reservations[channel].category = category;
+    }
+    g_reservedChannels |= channelMask;
+    return true;
+}
+
+bool cwavReserveChannels(u32 channelMask, CWAV* cwav)
+{
+    if (!cwav || cwav->loadStatus != CWAV_SUCCESS)
+        return false;
+    return cwav_reserve(channelMask, cwav, 0);
+}
+
+bool cwavReserveCategoryChannels(u32 channelMask, cwavCategory_t category)
+{
+    if (category >= CWAV_CATEGORY_COUNT)
+        return false;
+    return cwav_reserve(channelMask, NULL, category);
+}
+
+void cwavUnreserveChannels(u32 channelMask)
+{
+    g_reservedChannels &= ~channelMask;
+}
+
+u32 cwavGetReservedChannels()
+{
+    return g_reservedChannels;
+}
+
+u32 cwavReserveGetOwnChannels(const CWAV* cwav, u8 category)
+{
+    u32 own = 0;
+    for (u32 reserved = g_reservedChannels, channel = 0; reserved; channel++, reserved >>= 1)
+    {
+        if (!(reserved & 1))
+            continue;
+        const cwavReservation_t* reservation = &g_reservations[channel];
+        if (reservation->cwav ? reservation->cwav == cwav : reservation->category == category)
+            own |= 1u << channel;
+    }
+    return own;
+}
+
+void cwavReserveForget(const CWAV* cwav)
+{
+    for (u32 reserved = g_reservedChannels, channel = 0; reserved; channel++, reserved >>= 1)
+    {
+        if ((reserved & 1) && g_reservations[channel].cwav == cwav)
+            g_reservedChannels &= ~(1u << channel);
+    }
+}
+
+void cwavSetChannelMask(u32 channelMask)
+{
+    // The voices on the channels given back to the application are stopped while libcwav still owns them.
+    u32 removed = cwavEnvGetChannelMask() & ~channelMask;
+    u32 channelAmount = cwavEnvGetChannelAmount();
+    for (u32 channel = 0; channel < channelAmount; channel++)
+    {
+        if (((removed >> channel) & 1) && cwavEnvChannelIsPlaying(channel))
+            cwavEnvStop(channel);
+    }
+    cwavEnvSetChannelMask(channelMask);
+    g_reservedChannels &= channelMask;
+}
+
+u32 cwavGetChannelMask()
+{
+    return cwavEnvGetChannelMask();
+}
+
+static void cwav_reserveUpdateHasBudget()
+{
+    g_hasBudget = g_channelBudget != CWAV_UNLIMITED_CHANNELS;
+    for (u32 i = 0; i < CWAV_CATEGORY_COUNT; i++)
+        g_hasBudget |= g_categoryBudgets[i] != CWAV_UNLIMITED_CHANNELS;
+}
+
+void cwavSetChannelBudget(u32 maxChannels)
+{
+    g_channelBudget = maxChannels;
+    cwav_reserveUpdateHasBudget();
+}
+
+void cwavSetCategoryChannelBudget(cwavCategory_t category, u32 maxChannels)
+{
+    if (category >= CWAV_CATEGORY_COUNT)
+        return;
+    g_categoryBudgets[category] = maxChannels;
+    cwav_reserveUpdateHasBudget();
+}
+
+bool cwavReserveWithinBudget(u8 category, u32 channelCount)
+{
+    if (!g_hasBudget)
+        return true;
+
+    u32 playing = 0, categoryPlaying = 0;
+    u32 channelAmount = cwavEnvGetChannelAmount();
+    for (u32 channel = 0; channel < channelAmount; channel++)
+    {
+        if (!cwavEnvIsChannelAvailable(channel) || !cwavEnvChannelIsPlaying(channel))
+            continue;
+        playing++;
+        cwavVoice_t* voice = cwavVoiceGetActive(channel);
+        categoryPlaying += voice && voice->category == category;
+    }
+    return playing + channelCount <= g_channelBudget && (category >= CWAV_CATEGORY_COUNT || categoryPlaying + channelCount <= g_categoryBudgets[category]);
+}
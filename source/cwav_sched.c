@@ -0,0 +1,133 @@
+#include "internal/cwav_sched.h"
+#include "internal/cwav_env.h"
+
+#define CWAV_SCHED_MAX_CHANNELS 32
+#define CWAV_SEQUENCER_MAX_EVENTS 256
+
+// Written by the ndsp thread only, read from any thread.
+static u64 g_schedClock = 0;
+static bool g_schedRunning = false;
+// Start of the voices waiting on each held channel, valid while their bit is set in g_schedPending.
+static u64 g_schedStartTimes[CWAV_SCHED_MAX_CHANNELS];
+static u32 g_schedPending = 0;
+
+// Sequencer events not committed yet, only used from the application thread.
+static cwavSeqEvent g_seqEvents[CWAV_SEQUENCER_MAX_EVENTS];
+static u32 g_seqHead = 0;
+static u32 g_seqCount = 0;
+
+// Runs after every DSP frame: the clock moves to the start of the next frame and the voices
+// starting in it are released, their start delay places them on the right sample.
+static void cwav_schedFrameHook()
+{
+    u64 frameStart = __atomic_add_fetch(&g_schedClock, CWAV_SCHED_FRAME_SAMPLES, __ATOMIC_SEQ_CST);
+    u32 pending = __atomic_load_n(&g_schedPending, __ATOMIC_ACQUIRE);
+    for (u32 channel = 0; pending; channel++, pending >>= 1)
+    {
+        if (!(pending & 1) || g_schedStartTimes[channel] >= frameStart + CWAV_SCHED_FRAME_SAMPLES)
+            continue;
+        __atomic_fetch_and(&g_schedPending, ~(1u << channel), __ATOMIC_SEQ_CST);
+        cwavEnvSetHeld(channel, false);
+    }
+}
+
+bool cwavSchedIsRunning()
+{
+    return g_schedRunning;
+}
+
+u32 cwavSchedGetStartDelay(u64 samplePosition)
+{
+    // Late voices start as soon as possible.
+    if (samplePosition < cwavGetSampleClock())
+        return 0;
+    return (u32)(samplePosition % CWAV_SCHED_FRAME_SAMPLES);
+}
+
+void cwavSchedVoiceQueued(u32 channel, u64 samplePosition)
+{
+    if (channel >= CWAV_SCHED_MAX_CHANNELS)
+        return;
+    // The start time is not read by the ndsp thread while the pending bit is clear.
+    __atomic_fetch_and(&g_schedPending, ~(1u << channel), __ATOMIC_SEQ_CST);
+    g_schedStartTimes[channel] = samplePosition;
+    __atomic_fetch_or(&g_schedPending, 1u << channel, __ATOMIC_SEQ_CST);
+}
+
+bool cwavSchedulerStart()
+{
+    if (g_schedRunning)
+        return true;
+
+    __atomic_store_n(&g_schedClock, 0, __ATOMIC_SEQ_CST);
+    if (!cwavEnvAddFrameHook(cwav_schedFrameHook))
+        return false;
+    g_schedRunning = true;
+    return true;
+}
+
+void cwavSchedulerStop()
+{
+    if (!g_schedRunning)
+        return;
+
+    cwavEnvRemoveFrameHook(cwav_schedFrameHook);
+    g_schedRunning = false;
+    cwavSequencerClear();
+
+    // Voices that did not start yet are stopped.
+    u32 pending = __atomic_exchange_n(&g_schedPending, 0, __ATOMIC_SEQ_CST);
+    for (u32 channel = 0; pending; channel++, pending >>= 1)
+    {
+        if ((pending & 1) && cwavEnvChannelIsHeld(channel))
+            cwavEnvStop(channel);
+    }
+}
+
+u64 cwavGetSampleClock()
+{
+    return __atomic_load_n(&g_schedClock, __ATOMIC_SEQ_CST);
+}
+
+u32 cwavSequencerSubmit(const cwavSeqEvent* events, u32 count)
+{
+    if (!events)
+        return 0;
+
+    u32 accepted = 0;
+    for (; accepted < count && g_seqCount < CWAV_SEQUENCER_MAX_EVENTS; accepted++)
+    {
+        // Events must be sorted, also after the ones already queued.
+        if (g_seqCount && events[accepted].samplePosition < g_seqEvents[(g_seqHead + g_seqCount - 1) % CWAV_SEQUENCER_MAX_EVENTS].samplePosition)
+            break;
+        g_seqEvents[(g_seqHead + g_seqCount) % CWAV_SEQUENCER_MAX_EVENTS] = events[accepted];
+        g_seqCount++;
+    }
+    return accepted;
+}
+
+void cwavSequencerUpdate(u32 lookaheadSamples)
+{
+    if (!g_schedRunning)
+        return;
+
+    u64 horizon = cwavGetSampleClock() + lookaheadSamples;
+    while (g_seqCount && g_seqEvents[g_seqHead].samplePosition < horizon)
+    {
+        const cwavSeqEvent* event = &g_seqEvents[g_seqHead];
+        cwavPlayAtTime(event->cwav, event->leftChannel, event->rightChannel, event->samplePosition);
+        g_seqHead = (g_seqHead + 1) % CWAV_SEQUENCER_MAX_EVENTS;
+        g_seqCount--;
+    }
+}
+
+void cwavSequencerClear()
+{
+    g_seqHead = 0;
+    g_seqCount = 0;
+}
+
+u32 cwavSequencerGetPendingEvents()
+{
+    return g_seqCount;
+}
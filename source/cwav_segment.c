@@ -0,0 +1,240 @@
+#include "internal/cwav_segment.h"
+#include "internal/cwav_region.h"
+#include "internal/cwav_env.h"
+#include "3ds.h"
+#include <string.h>
+
+#define CWAVTOIMPL(c) ((cwav_t*)c->cwav)
+
+typedef struct cwavSegmentPlayer_s
+{
+    u32 active; // Cleared by the ndsp thread when the playback ends.
+    CWAV* cwav;
+    u32 encoding;
+    u32 channelCount;
+    int cwavChannels[2];
+    u32 envChannels[2];
+    u32 serials[2];
+    u32 beatSamples;
+
+    // Only used by the ndsp thread while the player is active.
+    cwavRegionImpl_t current;
+    int currentIndex;
+    u32 cursor;
+
+    // Written by the application while pendingReady is cleared.
+    cwavRegionImpl_t pending;
+    int pendingIndex;
+    cwavSegmentTransition_t pendingTransition;
+    u32 pendingReady;
+} cwavSegmentPlayer_t;
+
+static cwavSegmentPlayer_t g_segmentPlayers[CWAV_SEGMENT_PLAYERS];
+static u32 g_segmentInHook = 0;
+
+// End of the part of the segment starting at cursor, a beat long unless the rest of the segment is too short to split.
+static u32 cwav_segmentPartEnd(const cwavSegmentPlayer_t* player, u32 cursor)
+{
+    u32 end = player->current.end;
+    if (!player->beatSamples || end - cursor <= player->beatSamples + CWAV_SEGMENT_MIN_SAMPLES)
+        return end;
+    return cwavRegionAlign(player->encoding, cursor + player->beatSamples);
+}
+
+static cwavDSPADPCMContext_t* cwav_segmentContext(cwavSegmentPlayer_t* player, u32 channel, bool loop)
+{
+    if (!player->current.DSPADPCMInfos)
+        return NULL;
+    cwavDSPADPCMInfo_t* info = &player->current.DSPADPCMInfos[player->cwavChannels[channel]];
+    return loop ? &info->loopContext : &info->context;
+}
+
+// Queues the next part once the previous one started playing, so there is always one part waiting.
+static void cwav_segmentFeed(cwavSegmentPlayer_t* player)
+{
+    for (u32 i = 0; i < player->channelCount; i++)
+    {
+        // The voices were stopped or replaced.
+        if (cwavEnvGetChannelSerial(player->envChannels[i]) != player->serials[i])
+        {
+            __atomic_store_n(&player->active, 0, __ATOMIC_SEQ_CST);
+            return;
+        }
+    }
+    if (cwavEnvGetQueuedBuffers(player->envChannels[0]))
+        return;
+
+    bool passEnded = player->cursor >= player->current.end;
+    bool restart = false, loop = false;
+    if (__atomic_load_n(&player->pendingReady, __ATOMIC_SEQ_CST) && (passEnded || player->pendingTransition == CWAV_SEGMENT_AT_BEAT))
+    {
+        player->current = player->pending;
+        __atomic_store_n(&player->currentIndex, player->pendingIndex, __ATOMIC_RELEASE);
+        __atomic_store_n(&player->pendingReady, 0, __ATOMIC_SEQ_CST);
+        player->cursor = player->current.start;
+        restart = true;
+    }
+    else if (passEnded)
+    {
+        if (!player->current.isLooped)
+        {
+            // Waits for a next segment while the last part plays.
+            if (!cwavEnvChannelIsPlaying(player->envChannels[0]))
+                __atomic_store_n(&player->active, 0, __ATOMIC_SEQ_CST);
+            return;
+        }
+        player->cursor = player->current.loopStart;
+        restart = loop = true;
+    }
+
+    cwav_t* cwav_ = CWAVTOIMPL(player->cwav);
+    u32 end = cwav_segmentPartEnd(player, player->cursor);
+    for (u32 i = 0; i < player->channelCount; i++)
+    {
+        u8* data = (u8*)cwav_->sampleData[player->cwavChannels[i]] + cwavRegionSampleOffset(player->encoding, player->cursor);
+        // The ADPCM decoding continues from the previous part unless the segment (or its loop) starts again.
+        cwavEnvQueueSegment(player->envChannels[i], data, end - player->cursor, restart ? cwav_segmentContext(player, i, loop) : NULL);
+    }
+    player->cursor = end;
+}
+
+static void cwav_segmentFrameHook()
+{
+    __atomic_store_n(&g_segmentInHook, 1, __ATOMIC_SEQ_CST);
+    for (u32 i = 0; i < CWAV_SEGMENT_PLAYERS; i++)
+    {
+        if (__atomic_load_n(&g_segmentPlayers[i].active, __ATOMIC_SEQ_CST))
+            cwav_segmentFeed(&g_segmentPlayers[i]);
+    }
+    __atomic_store_n(&g_segmentInHook, 0, __ATOMIC_RELEASE);
+}
+
+// Waits until the frame hook is not using the players. Players cleared before this are not used anymore.
+static void cwav_segmentWaitHook()
+{
+    while (__atomic_load_n(&g_segmentInHook, __ATOMIC_SEQ_CST))
+        svcSleepThread(100000);
+}
+
+static void cwav_segmentStopImpl(cwavSegmentPlayer_t* player)
+{
+    __atomic_store_n(&player->active, 0, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&player->pendingReady, 0, __ATOMIC_SEQ_CST);
+    cwav_segmentWaitHook();
+    for (u32 i = 0; i < player->channelCount; i++)
+    {
+        if (cwavEnvGetChannelSerial(player->envChannels[i]) == player->serials[i])
+            cwavEnvStop(player->envChannels[i]);
+    }
+    player->channelCount = 0;
+}
+
+cwavPlayResult cwavSegmentPlay(u32 player, CWAV* cwav, int region, int leftChannel, int rightChannel, u32 beatSamples)
+{
+    cwavPlayResult ret;
+    ret.playStatus = CWAV_INVALID_ARGUMENT;
+    if (player >= CWAV_SEGMENT_PLAYERS || !cwav || cwav->loadStatus != CWAV_SUCCESS || cwavEnvGetEnvironment() != CWAV_ENV_DSP)
+        return ret;
+
+    const cwavRegionImpl_t* first = cwavRegionGet(CWAVTOIMPL(cwav), region);
+    if (!first || !cwavEnvAddFrameHook(cwav_segmentFrameHook))
+        return ret;
+
+    cwavSegmentPlayer_t* p = &g_segmentPlayers[player];
+    cwav_segmentStopImpl(p);
+
+    p->cwav = cwav;
+    p->encoding = CWAVTOIMPL(cwav)->cwavInfo->encoding;
+    p->beatSamples = beatSamples && beatSamples < CWAV_SEGMENT_MIN_SAMPLES ? CWAV_SEGMENT_MIN_SAMPLES : beatSamples;
+    p->current = *first;
+    p->currentIndex = region;
+
+    // The first part plays like a region that does not loop, the next ones are queued by the frame hook.
+    cwavRegionImpl_t part = *first;
+    part.end = cwav_segmentPartEnd(p, first->start);
+    part.isLooped = false;
+    part.loopStart = part.start;
+    ret = cwavRegionPlay(cwav, &part, leftChannel, rightChannel);
+    if (ret.playStatus != CWAV_SUCCESS)
+        return ret;
+
+    p->channelCount = rightChannel < 0 ? 1 : 2;
+    p->cwavChannels[0] = leftChannel;
+    p->cwavChannels[1] = rightChannel;
+    p->envChannels[0] = ret.monoLeftChannel;
+    p->envChannels[1] = rightChannel < 0 ? 0 : ret.rightChannel;
+    for (u32 i = 0; i < p->channelCount; i++)
+        p->serials[i] = cwavEnvGetChannelSerial(p->envChannels[i]);
+    p->cursor = part.end;
+    __atomic_store_n(&p->active, 1, __ATOMIC_SEQ_CST);
+    return ret;
+}
+
+bool cwavSegmentQueue(u32 player, int region, cwavSegmentTransition_t transition)
+{
+    if (player >= CWAV_SEGMENT_PLAYERS)
+        return false;
+
+    cwavSegmentPlayer_t* p = &g_segmentPlayers[player];
+    if (!__atomic_load_n(&p->active, __ATOMIC_SEQ_CST))
+        return false;
+    const cwavRegionImpl_t* next = cwavRegionGet(CWAVTOIMPL(p->cwav), region);
+    if (!next)
+        return false;
+
+    __atomic_store_n(&p->pendingReady, 0, __ATOMIC_SEQ_CST);
+    cwav_segmentWaitHook();
+    p->pending = *next;
+    p->pendingIndex = region;
+    p->pendingTransition = transition;
+    __atomic_store_n(&p->pendingReady, 1, __ATOMIC_SEQ_CST);
+    return true;
+}
+
+int cwavSegmentGetCurrent(u32 player)
+{
+    if (player >= CWAV_SEGMENT_PLAYERS || !__atomic_load_n(&g_segmentPlayers[player].active, __ATOMIC_SEQ_CST))
+        return -1;
+    return __atomic_load_n(&g_segmentPlayers[player].currentIndex, __ATOMIC_ACQUIRE);
+}
+
+bool cwavSegmentIsPlaying(u32 player)
+{
+    return player < CWAV_SEGMENT_PLAYERS && __atomic_load_n(&g_segmentPlayers[player].active, __ATOMIC_SEQ_CST);
+}
+
+static void cwav_segmentRemoveHookIfIdle()
+{
+    for (u32 i = 0; i < CWAV_SEGMENT_PLAYERS; i++)
+    {
+        if (__atomic_load_n(&g_segmentPlayers[i].active, __ATOMIC_SEQ_CST))
+            return;
+    }
+    cwavEnvRemoveFrameHook(cwav_segmentFrameHook);
+}
+
+void cwavSegmentStop(u32 player)
+{
+    if (player >= CWAV_SEGMENT_PLAYERS)
+        return;
+
+    cwav_segmentStopImpl(&g_segmentPlayers[player]);
+    cwav_segmentRemoveHookIfIdle();
+}
+
+void cwavSegmentForget(const CWAV* cwav)
+{
+    bool stopped = false;
+    for (u32 i = 0; i < CWAV_SEGMENT_PLAYERS; i++)
+    {
+        cwavSegmentPlayer_t* p = &g_segmentPlayers[i];
+        if (p->cwav != cwav)
+            continue;
+        // Also waits for the frame hook, which may be feeding the player.
+        cwav_segmentStopImpl(p);
+        p->cwav = NULL;
+        stopped = true;
+    }
+    if (stopped)
+        cwav_segmentRemoveHookIfIdle();
+}
@@ -0,0 +1,109 @@
+#include "cwav.h"
+#include "internal/cwav_voice.h"
+#include "internal/cwav_env.h"
+#include <math.h>
+
+#define CWAV_SPATIAL_BLOCK 16
+#define CWAV_SPATIAL_MIN_PITCH 0.5f
+#define CWAV_SPATIAL_MAX_PITCH 2.f
+
+// Front/back split: 0.8/0.2 straight ahead (same as cwavPlay), 0.5/0.5 on the sides and 0.2/0.8 behind.
+#define CWAV_SPATIAL_BACK_GAIN 0.2f
+#define CWAV_SPATIAL_FRONT_RANGE 0.6f
+
+static inline float cwav_spatialClamp(float value, float min, float max)
+{
+    return value < min ? min : (value > max ? max : value);
+}
+
+// Branch free structure-of-arrays pass over a block of emitters, so it can be vectorized by the compiler.
+static void cwav_spatialBlock(const cwavListener* listener, const cwavSpatialModel* model, const cwavEmitters* emitters, u32 start, u32 count, float (*gains)[4], float* pitch)
+{
+    const float* x = emitters->x + start;
+    const float* y = emitters->y + start;
+    const float* z = emitters->z + start;
+    float minDistance = model->minDistance > 0.f ? model->minDistance : 1.f;
+    float maxDistance = model->maxDistance > minDistance ? model->maxDistance : minDistance;
+    bool doppler = model->speedOfSound > 0.f && model->doppler != 0.f;
+    float speedOfSound = doppler ? model->speedOfSound : 1.f;
+
+    for (u32 i = 0; i < count; i++)
+    {
+        float dx = x[i] - listener->position[0];
+        float dy = y[i] - listener->position[1];
+        float dz = z[i] - listener->position[2];
+        float distance = sqrtf(dx * dx + dy * dy + dz * dz);
+        // Emitters at the listener position are centered in front.
+        float invDistance = distance > 1e-6f ? 1.f / distance : 0.f;
+        dx *= invDistance;
+        dy *= invDistance;
+        dz *= invDistance;
+
+        float clamped = cwav_spatialClamp(distance, minDistance, maxDistance);
+        float attenuation = minDistance / (minDistance + model->rolloff * (clamped - minDistance));
+
+        float side = dx * listener->right[0] + dy * listener->right[1] + dz * listener->right[2];
+        float front = dx * listener->forward[0] + dy * listener->forward[1] + dz * listener->forward[2];
+        front = distance > 1e-6f ? front : 1.f;
+        float rightPan = cwav_spatialClamp((side + 1.f) / 2.f, 0.f, 1.f);
+        float leftPan = 1.f - rightPan;
+        float frontGain = CWAV_SPATIAL_BACK_GAIN + CWAV_SPATIAL_FRONT_RANGE * cwav_spatialClamp((front + 1.f) / 2.f, 0.f, 1.f);
+        float backGain = 1.f - frontGain;
+
+        gains[i][0] = attenuation * leftPan * frontGain;
+        gains[i][1] = attenuation * rightPan * frontGain;
+        gains[i][2] = attenuation * leftPan * backGain;
+        gains[i][3] = attenuation * rightPan * backGain;
+
+        // Velocities towards each other raise the pitch.
+        float listenerSpeed = dx * listener->velocity[0] + dy * listener->velocity[1] + dz * listener->velocity[2];
+        float emitterSpeed = 0.f;
+        if (emitters->vx)
+            emitterSpeed = dx * emitters->vx[start + i] + dy * emitters->vy[start + i] + dz * emitters->vz[start + i];
+        float limit = speedOfSound * 0.5f;
+        listenerSpeed = cwav_spatialClamp(listenerSpeed * model->doppler, -limit, limit);
+        emitterSpeed = cwav_spatialClamp(emitterSpeed * model->doppler, -limit, limit);
+        float shift = (speedOfSound + listenerSpeed) / (speedOfSound + emitterSpeed);
+        pitch[i] = doppler ? cwav_spatialClamp(shift, CWAV_SPATIAL_MIN_PITCH, CWAV_SPATIAL_MAX_PITCH) : 1.f;
+    }
+}
+
+void cwavSpatialUpdate(const cwavListener* listener, const cwavSpatialModel* model, cwavEmitters* emitters)
+{
+    if (!listener || !model || !emitters || !emitters->x || !emitters->y || !emitters->z)
+        return;
+
+    float gains[CWAV_SPATIAL_BLOCK][4];
+    float pitch[CWAV_SPATIAL_BLOCK];
+    u32 channelAmount = cwavEnvGetChannelAmount();
+
+    for (u32 start = 0; start < emitters->count; start += CWAV_SPATIAL_BLOCK)
+    {
+        u32 count = emitters->count - start < CWAV_SPATIAL_BLOCK ? emitters->count - start : CWAV_SPATIAL_BLOCK;
+        cwav_spatialBlock(listener, model, emitters, start, count, gains, pitch);
+
+        for (u32 i = 0; i < count; i++)
+        {
+            if (emitters->gains)
+            {
+                for (int j = 0; j < 4; j++)
+                    emitters->gains[(start + i) * 4 + j] = gains[i][j];
+            }
+            if (emitters->pitch)
+                emitters->pitch[start + i] = pitch[i];
+
+            s8 channel = emitters->channels ? emitters->channels[start + i] : -1;
+            if (channel < 0 || (u32)channel >= channelAmount)
+                continue;
+            cwavVoice_t* voice = cwavVoiceGetLive(channel);
+            if (!voice)
+                continue;
+
+            voice->spatial = true;
+            for (int j = 0; j < 4; j++)
+                voice->spatialGains[j] = gains[i][j];
+            voice->spatialPitch = pitch[i];
+            cwavVoiceCommit(channel, voice);
+        }
+    }
+}
@@ -0,0 +1,30 @@
+#include "internal/cwav_stats.h"
+#include <string.h>
+
+#ifndef CWAV_DISABLE_STATS
+cwavStats g_cwavStats = {0};
+#endif
+
+void cwavGetStats(cwavStats* out)
+{
+    if (!out)
+        return;
+#ifndef CWAV_DISABLE_STATS
+    memcpy(out, &g_cwavStats, sizeof(cwavStats));
+#else
+    memset(out, 0, sizeof(cwavStats));
+#endif
+}
+
+void cwavResetStats()
+{
+#ifndef CWAV_DISABLE_STATS
+    // The values that represent the current state are kept.
+    cwavStats current = g_cwavStats;
+    memset(&g_cwavStats, 0, sizeof(cwavStats));
+    g_cwavStats.activeVoices = g_cwavStats.peakVoices = current.activeVoices;
+    g_cwavStats.registeredCwavs = current.registeredCwavs;
+    g_cwavStats.sampleBytes = current.sampleBytes;
+    g_cwavStats.metadataBytes = current.metadataBytes;
+#endif
+}
@@ -0,0 +1,233 @@
+#include "internal/cwav_stem.h"
+#include "internal/cwav_env.h"
+#include "internal/cwav_voice.h"
+#include "3ds.h"
+
+typedef struct cwavStemFade_s
+{
+    float from;
+    float to;
+    u64 startTick;
+    u64 durationTicks;
+} cwavStemFade_t;
+
+typedef struct cwavStemLayerState_s
+{
+    u32 channelCount;
+    u32 envChannels[2];
+    u32 serials[2];
+    cwavStemFade_t volume;
+} cwavStemLayerState_t;
+
+typedef struct cwavStemGroup_s
+{
+    u32 layerCount;
+    cwavStemLayerState_t layers[CWAV_STEM_MAX_LAYERS];
+    cwavStemFade_t volume;
+    bool stopAfterFade;
+} cwavStemGroup_t;
+
+static cwavStemGroup_t g_stemGroups[CWAV_STEM_GROUPS];
+// Held channels released by the frame hook, so the stems start in the same DSP frame.
+static u32 g_stemRelease = 0;
+static bool g_stemHookAdded = false;
+
+static float cwav_stemFadeValue(const cwavStemFade_t* fade, u64 now)
+{
+    u64 elapsed = now - fade->startTick;
+    if (elapsed >= fade->durationTicks)
+        return fade->to;
+    return fade->from + (fade->to - fade->from) * ((float)elapsed / (float)fade->durationTicks);
+}
+
+static void cwav_stemFadeTo(cwavStemFade_t* fade, float volume, u32 fadeMs, u64 now)
+{
+    fade->from = fadeMs ? cwav_stemFadeValue(fade, now) : volume;
+    fade->to = volume;
+    fade->startTick = now;
+    fade->durationTicks = (u64)fadeMs * SYSCLOCK_ARM11 / 1000;
+}
+
+// The voices of a layer can be stopped and their channels reused by other plays.
+static inline bool cwav_stemChannelIsOwned(const cwavStemLayerState_t* layer, u32 i)
+{
+    return cwavEnvGetChannelSerial(layer->envChannels[i]) == layer->serials[i];
+}
+
+static void cwav_stemStopImpl(cwavStemGroup_t* group)
+{
+    for (u32 i = 0; i < group->layerCount; i++)
+    {
+        cwavStemLayerState_t* layer = &group->layers[i];
+        for (u32 j = 0; j < layer->channelCount; j++)
+        {
+            __atomic_fetch_and(&g_stemRelease, ~(1u << layer->envChannels[j]), __ATOMIC_SEQ_CST);
+            if (cwav_stemChannelIsOwned(layer, j))
+                cwavEnvStop(layer->envChannels[j]);
+        }
+    }
+    group->layerCount = 0;
+    group->stopAfterFade = false;
+}
+
+// Sends the layer and group volumes to the voices, only the changed ones reach the environment.
+static void cwav_stemApply(cwavStemGroup_t* group, u64 now)
+{
+    float groupVolume = cwav_stemFadeValue(&group->volume, now);
+    if (group->stopAfterFade && now - group->volume.startTick >= group->volume.durationTicks)
+    {
+        cwav_stemStopImpl(group);
+        return;
+    }
+
+    for (u32 i = 0; i < group->layerCount; i++)
+    {
+        cwavStemLayerState_t* layer = &group->layers[i];
+        float gain = cwav_stemFadeValue(&layer->volume, now) * groupVolume;
+        for (u32 j = 0; j < layer->channelCount; j++)
+        {
+            cwavVoice_t* voice = cwav_stemChannelIsOwned(layer, j) ? cwavVoiceGetLive(layer->envChannels[j]) : NULL;
+            if (!voice || voice->stemGain == gain)
+                continue;
+            voice->stemGain = gain;
+            cwavVoiceCommit(layer->envChannels[j], voice);
+        }
+    }
+}
+
+static void cwav_stemFrameHook()
+{
+    u32 channels = __atomic_exchange_n(&g_stemRelease, 0, __ATOMIC_SEQ_CST);
+    if (channels)
+        cwavEnvReleaseHeld(channels);
+}
+
+static u32 cwav_stemFreeChannels()
+{
+    u32 freeChannels = 0;
+    u32 channelAmount = cwavEnvGetChannelAmount();
+    for (u32 i = 0; i < channelAmount; i++)
+        freeChannels += cwavEnvIsChannelAvailable(i) && !cwavEnvChannelIsPlaying(i);
+    return freeChannels;
+}
+
+cwavStatus_t cwavStemPlay(u32 group, const cwavStemLayer* layers, u32 count)
+{
+    if (group >= CWAV_STEM_GROUPS || !layers || !count || count > CWAV_STEM_MAX_LAYERS || cwavEnvGetEnvironment() != CWAV_ENV_DSP)
+        return CWAV_INVALID_ARGUMENT;
+
+    cwavStemGroup_t* g = &g_stemGroups[group];
+    cwav_stemStopImpl(g);
+
+    // All the voices are reserved before anything plays.
+    u32 neededChannels = 0;
+    for (u32 i = 0; i < count; i++)
+        neededChannels += layers[i].rightChannel < 0 ? 1 : 2;
+    if (cwav_stemFreeChannels() < neededChannels)
+        return CWAV_NO_CHANNEL_AVAILABLE;
+
+    u64 now = svcGetSystemTick();
+    u32 channels = 0;
+    for (u32 i = 0; i < count; i++)
+    {
+        cwavPlayResult ret = cwavStemPlayHeld(layers[i].cwav, layers[i].leftChannel, layers[i].rightChannel);
+        if (ret.playStatus != CWAV_SUCCESS)
+        {
+            cwav_stemStopImpl(g);
+            return ret.playStatus;
+        }
+
+        cwavStemLayerState_t* layer = &g->layers[g->layerCount++];
+        layer->channelCount = layers[i].rightChannel < 0 ? 1 : 2;
+        layer->envChannels[0] = ret.monoLeftChannel;
+        layer->envChannels[1] = layers[i].rightChannel < 0 ? 0 : ret.rightChannel;
+        for (u32 j = 0; j < layer->channelCount; j++)
+        {
+            layer->serials[j] = cwavEnvGetChannelSerial(layer->envChannels[j]);
+            channels |= 1u << layer->envChannels[j];
+        }
+        cwav_stemFadeTo(&layer->volume, layers[i].volume, 0, now);
+    }
+    cwav_stemFadeTo(&g->volume, 1.f, 0, now);
+    cwav_stemApply(g, now);
+
+    if (g_stemHookAdded || cwavEnvAddFrameHook(cwav_stemFrameHook))
+    {
+        g_stemHookAdded = true;
+        __atomic_fetch_or(&g_stemRelease, channels, __ATOMIC_SEQ_CST);
+    }
+    else
+        cwavEnvReleaseHeld(channels);
+    return CWAV_SUCCESS;
+}
+
+void cwavStemSetLayerVolume(u32 group, u32 layer, float volume, u32 fadeMs)
+{
+    if (group >= CWAV_STEM_GROUPS || layer >= g_stemGroups[group].layerCount)
+        return;
+
+    u64 now = svcGetSystemTick();
+    cwav_stemFadeTo(&g_stemGroups[group].layers[layer].volume, volume, fadeMs, now);
+    cwav_stemApply(&g_stemGroups[group], now);
+}
+
+void cwavStemSetVolume(u32 group, float volume, u32 fadeMs)
+{
+    if (group >= CWAV_STEM_GROUPS || !g_stemGroups[group].layerCount)
+        return;
+
+    u64 now = svcGetSystemTick();
+    cwav_stemFadeTo(&g_stemGroups[group].volume, volume, fadeMs, now);
+    cwav_stemApply(&g_stemGroups[group], now);
+}
+
+void cwavStemStop(u32 group, u32 fadeMs)
+{
+    if (group >= CWAV_STEM_GROUPS)
+        return;
+
+    cwavStemGroup_t* g = &g_stemGroups[group];
+    if (!fadeMs)
+    {
+        cwav_stemStopImpl(g);
+        return;
+    }
+    cwavStemSetVolume(group, 0.f, fadeMs);
+    g->stopAfterFade = true;
+}
+
+bool cwavStemIsPlaying(u32 group)
+{
+    if (group >= CWAV_STEM_GROUPS)
+        return false;
+
+    cwavStemGroup_t* g = &g_stemGroups[group];
+    for (u32 i = 0; i < g->layerCount; i++)
+    {
+        for (u32 j = 0; j < g->layers[i].channelCount; j++)
+        {
+            if (cwav_stemChannelIsOwned(&g->layers[i], j) && cwavEnvChannelIsPlaying(g->layers[i].envChannels[j]))
+                return true;
+        }
+    }
+    return false;
+}
+
+void cwavStemUpdate()
+{
+    u64 now = svcGetSystemTick();
+    bool anyLayer = false;
+    for (u32 i = 0; i < CWAV_STEM_GROUPS; i++)
+    {
+        if (g_stemGroups[i].layerCount)
+            cwav_stemApply(&g_stemGroups[i], now);
+        anyLayer |= g_stemGroups[i].layerCount != 0;
+    }
+
+    // The frame hook is only needed until the stems are released.
+    if (g_stemHookAdded && !anyLayer && !__atomic_load_n(&g_stemRelease, __ATOMIC_SEQ_CST))
+    {
+        cwavEnvRemoveFrameHook(cwav_stemFrameHook);
+        g_stemHookAdded = false;
+    }
+}
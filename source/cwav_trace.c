@@ -0,0 +1,100 @@
+#include "internal/cwav_trace.h"
+#include "3ds.h"
+
+#ifndef CWAV_DISABLE_TRACE
+cwavTraceEvent* g_cwavTraceEvents = NULL;
+static cwavTraceEvent* g_cwavTraceBuffer = NULL;
+static u32 g_cwavTraceCapacity = 0;
+static u32 g_cwavTraceWriteIndex = 0;
+
+static const char* const g_cwavTraceEventNames[] =
+{
+    "cwavLoad",
+    "cwavPlay",
+    "cwavStop",
+    "voiceEnd",
+    "cwavEnvPlay",
+    "cwavEnvStop",
+};
+
+void cwavTraceRecord(cwavTraceEventType_t type, u64 startTick, const void* cwav, u32 status, int channel0, int channel1)
+{
+    // Loaded once, cwavTraceStop can clear it from another thread after the macro checked it.
+    cwavTraceEvent* events = __atomic_load_n(&g_cwavTraceEvents, __ATOMIC_ACQUIRE);
+    if (!events)
+        return;
+
+    u64 now = svcGetSystemTick();
+    // Claiming the slot is the only synchronization, so events can be recorded from any thread.
+    u32 index = AtomicPostIncrement(&g_cwavTraceWriteIndex) & (g_cwavTraceCapacity - 1);
+    cwavTraceEvent* event = &events[index];
+
+    event->tick = startTick ? startTick : now;
+    event->duration = startTick ? (u32)(now - startTick) : 0;
+    event->cwav = cwav;
+    event->type = type;
+    event->status = status;
+    event->channels[0] = channel0;
+    event->channels[1] = channel1;
+}
+#endif
+
+bool cwavTraceStart(cwavTraceEvent* buffer, u32 capacity)
+{
+#ifndef CWAV_DISABLE_TRACE
+    // The capacity must be a power of two, so the ring index can be masked.
+    if (!buffer || !capacity || (capacity & (capacity - 1)))
+        return false;
+
+    __atomic_store_n(&g_cwavTraceEvents, NULL, __ATOMIC_SEQ_CST);
+    g_cwavTraceCapacity = capacity;
+    g_cwavTraceWriteIndex = 0;
+    g_cwavTraceBuffer = buffer;
+    __atomic_store_n(&g_cwavTraceEvents, buffer, __ATOMIC_RELEASE);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void cwavTraceStop()
+{
+#ifndef CWAV_DISABLE_TRACE
+    __atomic_store_n(&g_cwavTraceEvents, NULL, __ATOMIC_SEQ_CST);
+#endif
+}
+
+bool cwavTraceDumpJson(FILE* file)
+{
+#ifndef CWAV_DISABLE_TRACE
+    cwavTraceEvent* buffer = g_cwavTraceBuffer;
+    if (!file || !buffer)
+        return false;
+
+    u32 written = g_cwavTraceWriteIndex;
+    u32 count = written < g_cwavTraceCapacity ? written : g_cwavTraceCapacity;
+    u32 first = written - count;
+    const double ticksPerUs = SYSCLOCK_ARM11 / 1000000.0;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (u32 i = 0; i < count; i++)
+    {
+        cwavTraceEvent* event = &buffer[(first + i) & (g_cwavTraceCapacity - 1)];
+        const char* name = event->type < sizeof(g_cwavTraceEventNames) / sizeof(char*) ? g_cwavTraceEventNames[event->type] : "unknown";
+
+        // API calls go on the first track, voice and environment events on one track per hardware channel.
+        int track = (event->type >= CWAV_TRACE_VOICE_END && event->channels[0] >= 0) ? event->channels[0] + 1 : 0;
+        fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"cwav\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,", i ? "," : "", name, track, event->tick / ticksPerUs);
+        if (event->duration)
+            fprintf(file, "\"ph\":\"X\",\"dur\":%.3f,", event->duration / ticksPerUs);
+        else
+            fprintf(file, "\"ph\":\"i\",\"s\":\"t\",");
+        fprintf(file, "\"args\":{\"cwav\":\"%p\",\"status\":%u,\"channel0\":%d,\"channel1\":%d}}",
+            event->cwav, event->status, event->channels[0], event->channels[1]);
+    }
+    fprintf(file, "]}\n");
+    return !ferror(file);
+#else
+    return false;
+#endif
+}
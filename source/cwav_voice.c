@@ -0,0 +1,128 @@
+#include "internal/cwav_voice.h"
+#include "internal/cwav_env.h"
+#include <string.h>
+
+// Changes smaller than this are not sent to the environment.
+#define CWAV_VOICE_EPSILON (1.f / 4096.f)
+
+static cwavVoice_t g_voices[CWAV_VOICE_MAX];
+
+// Without a custom mix, the pan is split 0.8/0.2 between the front and back outputs.
+// Spatialization replaces the front/back outputs and keeps the aux sends.
+static void cwav_voiceComputeMix(const cwavVoice_t* voice, float* mix)
+{
+    float volume = voice->volume * voice->categoryGain * voice->stemGain;
+    if (voice->customMix)
+    {
+        for (int i = 0; i < CWAV_VOICE_MIX_SIZE; i++)
+            mix[i] = voice->mix[i] * volume;
+    }
+    else
+    {
+        memset(mix, 0, sizeof(float) * CWAV_VOICE_MIX_SIZE);
+        float rightPan = (voice->pan + 1.f) / 2.f;
+        float leftPan = 1.f - rightPan;
+        mix[0] = 0.8f * leftPan * volume;
+        mix[2] = 0.2f * leftPan * volume;
+        mix[1] = 0.8f * rightPan * volume;
+        mix[3] = 0.2f * rightPan * volume;
+    }
+
+    if (voice->spatial)
+    {
+        for (int i = 0; i < 4; i++)
+            mix[i] = voice->spatialGains[i] * volume;
+    }
+}
+
+static inline bool cwav_voiceChanged(float a, float b)
+{
+    float diff = a - b;
+    return diff > CWAV_VOICE_EPSILON || diff < -CWAV_VOICE_EPSILON;
+}
+
+void cwavVoiceStarted(u32 channel, u8 category, float volume, float pan, const float* mix, float rate, float categoryGain)
+{
+    if (channel >= CWAV_VOICE_MAX)
+        return;
+
+    cwavVoice_t* voice = &g_voices[channel];
+    voice->active = true;
+    voice->category = category;
+    voice->volume = volume;
+    voice->pan = pan;
+    voice->customMix = mix != NULL;
+    if (mix)
+        memcpy(voice->mix, mix, sizeof(float) * CWAV_VOICE_MIX_SIZE);
+    voice->rate = rate;
+    voice->categoryGain = categoryGain;
+    voice->stemGain = 1.f;
+    voice->spatial = false;
+    voice->spatialPitch = 1.f;
+    cwav_voiceComputeMix(voice, voice->appliedMix);
+    voice->appliedRate = rate;
+}
+
+const float* cwavVoiceGetAppliedMix(u32 channel)
+{
+    return channel < CWAV_VOICE_MAX ? g_voices[channel].appliedMix : NULL;
+}
+
+void cwavVoiceSetCustomMix(cwavVoice_t* voice, const float* mix)
+{
+    voice->customMix = mix != NULL;
+    if (mix)
+        memcpy(voice->mix, mix, sizeof(float) * CWAV_VOICE_MIX_SIZE);
+}
+
+cwavVoice_t* cwavVoiceGetActive(u32 channel)
+{
+    if (channel >= CWAV_VOICE_MAX || !g_voices[channel].active)
+        return NULL;
+    return &g_voices[channel];
+}
+
+cwavVoice_t* cwavVoiceGetLive(u32 channel)
+{
+    cwavVoice_t* voice = cwavVoiceGetActive(channel);
+    if (voice && !cwavEnvChannelIsPlaying(channel))
+    {
+        voice->active = false;
+        return NULL;
+    }
+    return voice;
+}
+
+bool cwavVoiceCommit(u32 channel, cwavVoice_t* voice)
+{
+    bool applied = true;
+    float mix[CWAV_VOICE_MIX_SIZE];
+    cwav_voiceComputeMix(voice, mix);
+    bool changed = false;
+    bool wasSilent = true;
+    bool isSilent = true;
+    for (int i = 0; i < CWAV_VOICE_MIX_SIZE; i++)
+    {
+        changed |= cwav_voiceChanged(mix[i], voice->appliedMix[i]);
+        wasSilent &= voice->appliedMix[i] == 0.f;
+        isSilent &= mix[i] == 0.f;
+    }
+    // Small changes are skipped, but muting and unmuting always go through.
+    if (changed || wasSilent != isSilent)
+    {
+        if (cwavEnvSetMix(channel, mix))
+            memcpy(voice->appliedMix, mix, sizeof(mix));
+        else
+            applied = false;
+    }
+
+    float rate = voice->rate * voice->spatialPitch;
+    if (cwav_voiceChanged(rate, voice->appliedRate))
+    {
+        if (cwavEnvSetRate(channel, rate))
+            voice->appliedRate = rate;
+        else
+            applied = false;
+    }
+    return applied;
+}
@@ -0,0 +1,261 @@
+// cwavlz - Compresses (b)cwav files into the block framed LZ4 container read by libcwav.
+// The container layout must match include/internal/cwav_lz4.h
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define CWAV_LZ4_MAGIC 0x5A4C5743 // "CWLZ"
+#define CWAV_LZ4_BLOCK_STORED 0x80000000
+#define CWAV_LZ4_BLOCK_DELTA8 0x40000000
+#define CWAV_LZ4_BLOCK_DELTA16 0x20000000
+#define CWAV_LZ4_DEFAULT_BLOCK_SIZE 0x10000
+
+#define LZ4_MIN_MATCH 4
+#define LZ4_LAST_LITERALS 5
+#define LZ4_MATCH_FIND_LIMIT 12
+#define LZ4_MAX_OFFSET 0xFFFF
+#define LZ4_HASH_BITS 12
+
+static uint32_t read32(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static void write32(uint8_t* p, uint32_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+}
+
+static uint32_t hashSequence(uint32_t sequence)
+{
+    return (sequence * 2654435761U) >> (32 - LZ4_HASH_BITS);
+}
+
+static uint8_t* writeLength(uint8_t* op, uint32_t length)
+{
+    for (; length >= 0xFF; length -= 0xFF)
+        *op++ = 0xFF;
+    *op++ = (uint8_t)length;
+    return op;
+}
+
+static uint8_t* writeSequence(uint8_t* op, const uint8_t* literals, uint32_t literalLength, uint32_t offset, uint32_t matchLength)
+{
+    uint8_t* token = op++;
+    *token = (literalLength >= 0xF ? 0xF : literalLength) << 4;
+    if (literalLength >= 0xF)
+        op = writeLength(op, literalLength - 0xF);
+    memcpy(op, literals, literalLength);
+    op += literalLength;
+
+    if (!matchLength)
+        return op;
+
+    *op++ = offset & 0xFF;
+    *op++ = (offset >> 8) & 0xFF;
+    matchLength -= LZ4_MIN_MATCH;
+    *token |= matchLength >= 0xF ? 0xF : matchLength;
+    if (matchLength >= 0xF)
+        op = writeLength(op, matchLength - 0xF);
+    return op;
+}
+
+// Greedy single pass LZ4 block compressor. dst must be able to hold srcSize + srcSize / 255 + 16 bytes.
+static uint32_t compressBlock(const uint8_t* src, uint32_t srcSize, uint8_t* dst)
+{
+    static uint32_t hashTable[1 << LZ4_HASH_BITS];
+    memset(hashTable, 0, sizeof(hashTable));
+
+    uint8_t* op = dst;
+    uint32_t ip = 0;
+    uint32_t anchor = 0;
+    uint32_t matchLimit = srcSize > LZ4_MATCH_FIND_LIMIT ? srcSize - LZ4_MATCH_FIND_LIMIT : 0;
+
+    while (ip < matchLimit)
+    {
+        uint32_t sequence = read32(src + ip);
+        uint32_t hash = hashSequence(sequence);
+        uint32_t ref = hashTable[hash];
+        hashTable[hash] = ip + 1;
+
+        if (!ref || ip - (ref - 1) > LZ4_MAX_OFFSET || read32(src + ref - 1) != sequence)
+        {
+            ip++;
+            continue;
+        }
+
+        ref--;
+        uint32_t matchLength = LZ4_MIN_MATCH;
+        while (ip + matchLength < srcSize - LZ4_LAST_LITERALS && src[ref + matchLength] == src[ip + matchLength])
+            matchLength++;
+
+        op = writeSequence(op, src + anchor, ip - anchor, ip - ref, matchLength);
+        ip += matchLength;
+        anchor = ip;
+    }
+
+    op = writeSequence(op, src + anchor, srcSize - anchor, 0, 0);
+    return (uint32_t)(op - dst);
+}
+
+// Reversible pre-filters, undone by libcwav after decompressing the block. Sample data rarely repeats
+// byte for byte, but the differences between neighbour samples are small and do.
+// DELTA8: difference with the previous byte (PCM8).
+// DELTA16: difference with the previous 16 bit sample, stored as a plane of the low bytes followed by
+// a plane of the high bytes (PCM16). An odd last byte is kept as is.
+static void filterBlock(const uint8_t* src, uint32_t size, uint32_t filter, uint8_t* dst)
+{
+    if (filter == CWAV_LZ4_BLOCK_DELTA8)
+    {
+        uint8_t prev = 0;
+        for (uint32_t i = 0; i < size; i++)
+        {
+            dst[i] = src[i] - prev;
+            prev = src[i];
+        }
+        return;
+    }
+
+    uint32_t half = size / 2;
+    uint16_t prev = 0;
+    for (uint32_t i = 0; i < half; i++)
+    {
+        uint16_t sample = src[2 * i] | (src[2 * i + 1] << 8);
+        uint16_t delta = sample - prev;
+        prev = sample;
+        dst[i] = delta & 0xFF;
+        dst[half + i] = delta >> 8;
+    }
+    if (size & 1)
+        dst[size - 1] = src[size - 1];
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        printf("Usage: %s <input.bcwav> <output.bcwav> [block size]\n", argv[0]);
+        return 1;
+    }
+
+    uint32_t blockSize = argc > 3 ? (uint32_t)strtoul(argv[3], NULL, 0) : CWAV_LZ4_DEFAULT_BLOCK_SIZE;
+    if (!blockSize || blockSize >= CWAV_LZ4_BLOCK_STORED)
+    {
+        printf("Invalid block size.\n");
+        return 1;
+    }
+
+    FILE* in = fopen(argv[1], "rb");
+    if (!in)
+    {
+        printf("Failed to open %s\n", argv[1]);
+        return 1;
+    }
+    fseek(in, 0, SEEK_END);
+    uint32_t inputSize = (uint32_t)ftell(in);
+    fseek(in, 0, SEEK_SET);
+
+    uint8_t* input = malloc(inputSize ? inputSize : 1);
+    uint8_t* block = malloc(blockSize + blockSize / 255 + 16);
+    uint8_t* bestBlock = malloc(blockSize + blockSize / 255 + 16);
+    uint8_t* filtered = malloc(blockSize);
+    if (!input || !block || !bestBlock || !filtered || fread(input, 1, inputSize, in) != inputSize)
+    {
+        printf("Failed to read %s\n", argv[1]);
+        fclose(in);
+        return 1;
+    }
+    fclose(in);
+
+    // Compresses every block with each filter and keeps the smallest result.
+    static const uint32_t filters[] = {0, CWAV_LZ4_BLOCK_DELTA8, CWAV_LZ4_BLOCK_DELTA16};
+    uint32_t blockCount = (inputSize + blockSize - 1) / blockSize;
+    uint8_t** blocks = calloc(blockCount ? blockCount : 1, sizeof(uint8_t*));
+    uint32_t* blockHeaders = calloc(blockCount ? blockCount : 1, sizeof(uint32_t));
+    if (!blocks || !blockHeaders)
+    {
+        printf("Out of memory\n");
+        return 1;
+    }
+
+    uint32_t outputSize = 12;
+    for (uint32_t b = 0; b < blockCount; b++)
+    {
+        uint32_t offset = b * blockSize;
+        uint32_t size = inputSize - offset < blockSize ? inputSize - offset : blockSize;
+        uint32_t bestSize = size;
+        blockHeaders[b] = size | CWAV_LZ4_BLOCK_STORED;
+        for (uint32_t f = 0; f < sizeof(filters) / sizeof(filters[0]); f++)
+        {
+            const uint8_t* src = input + offset;
+            if (filters[f])
+            {
+                filterBlock(src, size, filters[f], filtered);
+                src = filtered;
+            }
+            uint32_t compressedSize = compressBlock(src, size, block);
+            if (compressedSize < bestSize)
+            {
+                bestSize = compressedSize;
+                blockHeaders[b] = compressedSize | filters[f];
+                memcpy(bestBlock, block, compressedSize);
+            }
+        }
+
+        blocks[b] = malloc(bestSize ? bestSize : 1);
+        if (!blocks[b])
+        {
+            printf("Out of memory\n");
+            return 1;
+        }
+        memcpy(blocks[b], (blockHeaders[b] & CWAV_LZ4_BLOCK_STORED) ? input + offset : bestBlock, bestSize);
+        outputSize += 4 + bestSize;
+    }
+
+    FILE* out = fopen(argv[2], "wb");
+    if (!out)
+    {
+        printf("Failed to open %s\n", argv[2]);
+        return 1;
+    }
+
+    // Files that do not get smaller are written unchanged, libcwav loads them the same way.
+    if (outputSize >= inputSize)
+    {
+        fwrite(input, 1, inputSize, out);
+        outputSize = inputSize;
+    }
+    else
+    {
+        uint8_t header[12];
+        write32(header, CWAV_LZ4_MAGIC);
+        write32(header + 4, inputSize);
+        write32(header + 8, blockSize);
+        fwrite(header, 1, sizeof(header), out);
+        for (uint32_t b = 0; b < blockCount; b++)
+        {
+            uint8_t blockHeader[4];
+            write32(blockHeader, blockHeaders[b]);
+            fwrite(blockHeader, 1, sizeof(blockHeader), out);
+            fwrite(blocks[b], 1, blockHeaders[b] & ~(CWAV_LZ4_BLOCK_STORED | CWAV_LZ4_BLOCK_DELTA8 | CWAV_LZ4_BLOCK_DELTA16), out);
+        }
+    }
+    fclose(out);
+
+    printf("%s: %u -> %u bytes\n", argv[2], inputSize, outputSize);
+    for (uint32_t b = 0; b < blockCount; b++)
+        free(blocks[b]);
+    free(blocks);
+    free(blockHeaders);
+    free(input);
+    free(block);
+    free(bestBlock);
+    free(filtered);
+    return 0;
+}
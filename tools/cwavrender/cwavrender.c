@@ -0,0 +1,737 @@
+// cwavrender - Renders a libcwav play script to a WAV file using the host DSP simulator.
+// Every play goes through the real cwavPlay/cwavEnvPlay code, so the output follows the
+// library mix math (pan law, volume, pitch and block0/block1 loops).
+//
+// Script format, one command per line, '#' starts a comment:
+//   arena <size in bytes>
+//   load <name> <file.bcwav> [maxSPlays]
+//   region <name> <region name> <start sample> <end sample> [loop=<loop start sample>]
+//   <ms> play <name> [left=<chn>] [right=<chn>] [volume=<v>] [pan=<p>] [pitch=<p>] [category=<category>]
+//        [mix=<12 comma separated gains>] [start=<sample>] [region=<region name>]
+//   <ms> stop <name> [left=<chn>] [right=<chn>]
+//   <ms> category <sfx|voice|music|ui> [volume=<v>] [mute=<0|1>] [paused=<0|1>]
+//   <ms> duck <category> <trigger category> <volume>
+//   <ms> effects <aux bus> [<lowpass|biquad_lowpass|biquad_highpass|delay|reverb> [<parameter>=<value>]...]...
+//        parameters: frequency, q, time (ms), feedback, damping, wet. Without effects, the chain is removed.
+//   <ms> segment <player> play <name> <region name> [left=<chn>] [right=<chn>] [beat=<samples>]
+//   <ms> segment <player> next <region name> [beat]
+//   <ms> segment <player> stop
+//   <ms> stems <group> play <name>:<left chn>:<right chn or -1>:<volume>...
+//   <ms> stems <group> <layer <index>|volume|stop> [<volume>] [fade=<ms>]
+//   <ms> reserve <name|category> <channel mask>
+//   <ms> unreserve <channel mask>
+//   <ms> mask <channel mask>
+//   <ms> budget <all|category> <max channels>
+//   <ms> level <name> [peak=<expected peak>] [rms=<expected rms>]
+//   <ms> free <name>
+//   <ms> compact [<expected bytes>]
+//   <ms> end
+// Times are absolute and must not decrease. Relative file names are relative to the script.
+// Plays with a start sample go through the sequencer and start at that output sample.
+// Without an end command, rendering stops once every sound has finished.
+// Level commands print the peak and RMS level of the loudest voice of the sound, from its level envelope.
+// With expected values, the render fails if the printed ones differ.
+// After an arena command, the files loaded later are allocated from an arena of that size. Compact commands compact it
+// and print the amount of bytes given back, the render fails if it differs from the expected amount.
+#include "cwav.h"
+#include "host_sim.h"
+#include "3ds.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#define RENDER_MAX_SOUNDS 64
+#define RENDER_MAX_LINE 512
+#define RENDER_MAX_LENGTH_MS (10 * 60 * 1000)
+#define RENDER_SAMPLE_RATE (SYSCLOCK_ARM11 / HOST_SIM_DSP_TICKS_PER_SAMPLE)
+#define RENDER_LOOKAHEAD_SAMPLES (HOST_SIM_DSP_FRAME_SAMPLES * 3)
+
+typedef struct renderSound_s
+{
+    char name[64];
+    CWAV cwav;
+} renderSound_t;
+
+typedef struct renderOutput_s
+{
+    FILE* file;
+    u64 checksum;
+    u32 sampleCount;
+} renderOutput_t;
+
+static renderSound_t g_sounds[RENDER_MAX_SOUNDS];
+static u32 g_soundCount = 0;
+static renderSound_t* g_segmentSounds[CWAV_SEGMENT_PLAYERS];
+static cwavArena g_arena;
+static void* g_arenaBuffer = NULL;
+
+static void writeLE(FILE* file, u32 value, u32 size)
+{
+    for (u32 i = 0; i < size; i++)
+        fputc((value >> (i * 8)) & 0xFF, file);
+}
+
+static void writeWavHeader(FILE* file, u32 sampleCount)
+{
+    u32 dataSize = sampleCount * 4;
+    fwrite("RIFF", 1, 4, file);
+    writeLE(file, 36 + dataSize, 4);
+    fwrite("WAVEfmt ", 1, 8, file);
+    writeLE(file, 16, 4);
+    writeLE(file, 1, 2); // PCM
+    writeLE(file, 2, 2);
+    writeLE(file, RENDER_SAMPLE_RATE, 4);
+    writeLE(file, RENDER_SAMPLE_RATE * 4, 4);
+    writeLE(file, 4, 2);
+    writeLE(file, 16, 2);
+    fwrite("data", 1, 4, file);
+    writeLE(file, dataSize, 4);
+}
+
+// FNV-1a over the little endian output samples.
+static void renderOutputCallback(const s16* samples, u32 count, void* userData)
+{
+    renderOutput_t* output = (renderOutput_t*)userData;
+    u8 bytes[HOST_SIM_DSP_FRAME_SAMPLES * 4];
+    for (u32 i = 0; i < count * 2; i++)
+    {
+        bytes[i * 2] = (u16)samples[i] & 0xFF;
+        bytes[i * 2 + 1] = (u16)samples[i] >> 8;
+    }
+    for (u32 i = 0; i < count * 4; i++)
+        output->checksum = (output->checksum ^ bytes[i]) * 0x100000001B3ULL;
+
+    if (output->file)
+        fwrite(bytes, 1, count * 4, output->file);
+    output->sampleCount += count;
+}
+
+static renderSound_t* findSound(const char* name)
+{
+    for (u32 i = 0; i < g_soundCount; i++)
+    {
+        if (!strcmp(g_sounds[i].name, name))
+            return &g_sounds[i];
+    }
+    return NULL;
+}
+
+// Advances frame by frame, so ducking and the sequencer are updated like a game doing it every frame.
+static void advanceFrame()
+{
+    hostSimAdvanceFrames(1);
+    cwavCategoryUpdate();
+    cwavStemUpdate();
+    cwavSequencerUpdate(RENDER_LOOKAHEAD_SAMPLES);
+}
+
+static void advanceTo(u64 ms)
+{
+    u64 tick = ms * SYSCLOCK_ARM11 / 1000;
+    while ((hostSimGetFrameCount() + 1) * HOST_SIM_DSP_FRAME_TICKS <= tick)
+        advanceFrame();
+    if (tick > hostSimGetTick())
+        hostSimAdvanceTicks(tick - hostSimGetTick());
+}
+
+static int parseCategory(const char* name)
+{
+    static const char* names[CWAV_CATEGORY_COUNT] = {"sfx", "voice", "music", "ui"};
+    for (int i = 0; i < CWAV_CATEGORY_COUNT; i++)
+    {
+        if (!strcmp(names[i], name))
+            return i;
+    }
+    return -1;
+}
+
+static int parseEffect(const char* name)
+{
+    static const char* names[] = {"lowpass", "biquad_lowpass", "biquad_highpass", "delay", "reverb"};
+    for (int i = 0; i < (int)(sizeof(names) / sizeof(names[0])); i++)
+    {
+        if (!strcmp(names[i], name))
+            return i;
+    }
+    return -1;
+}
+
+static bool runEffects(char** args, u32 argCount, u32 lineNumber)
+{
+    cwavEffect effects[CWAV_EFFECTS_MAX_CHAIN];
+    u32 count = 0;
+    for (u32 i = 3; i < argCount; i++)
+    {
+        char* value = strchr(args[i], '=');
+        if (!value)
+        {
+            int type = parseEffect(args[i]);
+            if (type < 0 || count == CWAV_EFFECTS_MAX_CHAIN)
+            {
+                fprintf(stderr, "line %u: invalid effect %s\n", lineNumber, args[i]);
+                return false;
+            }
+            cwavEffect* effect = &effects[count++];
+            memset(effect, 0, sizeof(cwavEffect));
+            effect->type = type;
+            effect->q = 0.7071f;
+            effect->wet = 1.f;
+            continue;
+        }
+        if (!count)
+        {
+            fprintf(stderr, "line %u: parameter before effect\n", lineNumber);
+            return false;
+        }
+        *value++ = '\0';
+        cwavEffect* effect = &effects[count - 1];
+        if (!strcmp(args[i], "frequency"))
+            effect->frequency = strtof(value, NULL);
+        else if (!strcmp(args[i], "q"))
+            effect->q = strtof(value, NULL);
+        else if (!strcmp(args[i], "time"))
+            effect->timeMs = strtof(value, NULL);
+        else if (!strcmp(args[i], "feedback"))
+            effect->feedback = strtof(value, NULL);
+        else if (!strcmp(args[i], "damping"))
+            effect->damping = strtof(value, NULL);
+        else if (!strcmp(args[i], "wet"))
+            effect->wet = strtof(value, NULL);
+        else
+            fprintf(stderr, "line %u: unknown parameter %s\n", lineNumber, args[i]);
+    }
+
+    if (argCount < 3 || !cwavEffectsSetChain(atoi(args[2]), effects, count))
+    {
+        fprintf(stderr, "line %u: invalid effects command\n", lineNumber);
+        return false;
+    }
+    return true;
+}
+
+static bool runSegment(char** args, u32 argCount, u32 lineNumber)
+{
+    u32 player = argCount > 3 ? (u32)atoi(args[2]) : CWAV_SEGMENT_PLAYERS;
+    if (player < CWAV_SEGMENT_PLAYERS && !strcmp(args[3], "stop"))
+    {
+        cwavSegmentStop(player);
+        return true;
+    }
+    if (player < CWAV_SEGMENT_PLAYERS && !strcmp(args[3], "next") && argCount > 4)
+    {
+        renderSound_t* sound = g_segmentSounds[player];
+        int region = sound ? cwavFindRegion(&sound->cwav, args[4]) : -1;
+        cwavSegmentTransition_t transition = argCount > 5 && !strcmp(args[5], "beat") ? CWAV_SEGMENT_AT_BEAT : CWAV_SEGMENT_AT_END;
+        if (!cwavSegmentQueue(player, region, transition))
+            fprintf(stderr, "line %u: could not queue segment %s\n", lineNumber, args[4]);
+        return true;
+    }
+    if (player < CWAV_SEGMENT_PLAYERS && !strcmp(args[3], "play") && argCount > 5)
+    {
+        renderSound_t* sound = findSound(args[4]);
+        int region = sound ? cwavFindRegion(&sound->cwav, args[5]) : -1;
+        int left = 0, right = -1;
+        u32 beat = 0;
+        for (u32 i = 6; i < argCount; i++)
+        {
+            if (!strncmp(args[i], "left=", 5))
+                left = atoi(args[i] + 5);
+            else if (!strncmp(args[i], "right=", 6))
+                right = atoi(args[i] + 6);
+            else if (!strncmp(args[i], "beat=", 5))
+                beat = (u32)atoi(args[i] + 5);
+            else
+                fprintf(stderr, "line %u: unknown parameter %s\n", lineNumber, args[i]);
+        }
+        cwavPlayResult result = cwavSegmentPlay(player, sound ? &sound->cwav : NULL, region, left, right, beat);
+        if (result.playStatus != CWAV_SUCCESS)
+            fprintf(stderr, "line %u: segment play failed (status %d)\n", lineNumber, result.playStatus);
+        g_segmentSounds[player] = sound;
+        return true;
+    }
+    fprintf(stderr, "line %u: invalid segment command\n", lineNumber);
+    return false;
+}
+
+static bool runStems(char** args, u32 argCount, u32 lineNumber)
+{
+    u32 group = argCount > 3 ? (u32)atoi(args[2]) : CWAV_STEM_GROUPS;
+    if (group < CWAV_STEM_GROUPS && !strcmp(args[3], "play"))
+    {
+        cwavStemLayer layers[CWAV_STEM_MAX_LAYERS];
+        u32 count = 0;
+        for (u32 i = 4; i < argCount && count < CWAV_STEM_MAX_LAYERS; i++)
+        {
+            char* fields[4];
+            fields[0] = strtok(args[i], ":");
+            for (u32 j = 1; j < 4; j++)
+                fields[j] = fields[j - 1] ? strtok(NULL, ":") : NULL;
+            renderSound_t* sound = fields[0] ? findSound(fields[0]) : NULL;
+            if (!sound || !fields[3])
+            {
+                fprintf(stderr, "line %u: invalid stem layer\n", lineNumber);
+                return false;
+            }
+            layers[count].cwav = &sound->cwav;
+            layers[count].leftChannel = (s8)atoi(fields[1]);
+            layers[count].rightChannel = (s8)atoi(fields[2]);
+            layers[count++].volume = strtof(fields[3], NULL);
+        }
+        cwavStatus_t status = cwavStemPlay(group, layers, count);
+        if (status != CWAV_SUCCESS)
+            fprintf(stderr, "line %u: stems play failed (status %d)\n", lineNumber, status);
+        return true;
+    }
+
+    u32 fadeMs = 0;
+    for (u32 i = 4; i < argCount; i++)
+    {
+        if (!strncmp(args[i], "fade=", 5))
+            fadeMs = (u32)atoi(args[i] + 5);
+    }
+    if (group < CWAV_STEM_GROUPS && !strcmp(args[3], "stop"))
+    {
+        cwavStemStop(group, fadeMs);
+        return true;
+    }
+    if (group < CWAV_STEM_GROUPS && !strcmp(args[3], "volume") && argCount > 4)
+    {
+        cwavStemSetVolume(group, strtof(args[4], NULL), fadeMs);
+        return true;
+    }
+    if (group < CWAV_STEM_GROUPS && !strcmp(args[3], "layer") && argCount > 5)
+    {
+        cwavStemSetLayerVolume(group, (u32)atoi(args[4]), strtof(args[5], NULL), fadeMs);
+        return true;
+    }
+    fprintf(stderr, "line %u: invalid stems command\n", lineNumber);
+    return false;
+}
+
+static bool anySoundPlaying()
+{
+    if (cwavSequencerGetPendingEvents())
+        return true;
+    for (u32 i = 0; i < g_soundCount; i++)
+    {
+        if (cwavIsPlaying(&g_sounds[i].cwav))
+            return true;
+    }
+    return false;
+}
+
+static bool runCommand(const char* scriptDir, char* line, u32 lineNumber, bool* ended)
+{
+    char* args[16];
+    u32 argCount = 0;
+    for (char* tok = strtok(line, " \t\r\n"); tok && argCount < 16; tok = strtok(NULL, " \t\r\n"))
+    {
+        if (tok[0] == '#')
+            break;
+        args[argCount++] = tok;
+    }
+    if (!argCount)
+        return true;
+
+    if (!strcmp(args[0], "arena"))
+    {
+        size_t size = argCount > 1 ? (size_t)strtoul(args[1], NULL, 0) : 0;
+        if (g_arenaBuffer || !size || !(g_arenaBuffer = linearAlloc(size)) || !cwavArenaInit(&g_arena, g_arenaBuffer, size))
+        {
+            fprintf(stderr, "line %u: invalid arena command\n", lineNumber);
+            return false;
+        }
+        cwavAllocator allocator;
+        cwavArenaGetAllocator(&g_arena, &allocator);
+        cwavSetAllocator(&allocator);
+        return true;
+    }
+
+    if (!strcmp(args[0], "load"))
+    {
+        if (argCount < 3 || g_soundCount == RENDER_MAX_SOUNDS || findSound(args[1]))
+        {
+            fprintf(stderr, "line %u: invalid load command\n", lineNumber);
+            return false;
+        }
+        char path[1024];
+        if (args[2][0] == '/')
+            snprintf(path, sizeof(path), "%s", args[2]);
+        else
+            snprintf(path, sizeof(path), "%s%s", scriptDir, args[2]);
+
+        renderSound_t* sound = &g_sounds[g_soundCount];
+        snprintf(sound->name, sizeof(sound->name), "%s", args[1]);
+        cwavFileLoad(&sound->cwav, path, argCount > 3 ? atoi(args[3]) : 1);
+        if (sound->cwav.loadStatus != CWAV_SUCCESS)
+        {
+            fprintf(stderr, "line %u: failed to load %s (status %d)\n", lineNumber, path, sound->cwav.loadStatus);
+            return false;
+        }
+        g_soundCount++;
+        return true;
+    }
+
+    if (!strcmp(args[0], "region"))
+    {
+        renderSound_t* sound = argCount > 4 ? findSound(args[1]) : NULL;
+        if (!sound)
+        {
+            fprintf(stderr, "line %u: invalid region command\n", lineNumber);
+            return false;
+        }
+        cwavRegion region = {(u32)atoi(args[3]), (u32)atoi(args[4]), false, 0};
+        if (argCount > 5 && !strncmp(args[5], "loop=", 5))
+        {
+            region.isLooped = true;
+            region.loopStart = (u32)atoi(args[5] + 5);
+        }
+        if (cwavAddRegion(&sound->cwav, args[2], &region) < 0)
+        {
+            fprintf(stderr, "line %u: invalid region range\n", lineNumber);
+            return false;
+        }
+        return true;
+    }
+
+    char* end;
+    u64 ms = strtoull(args[0], &end, 10);
+    if (*end || argCount < 2)
+    {
+        fprintf(stderr, "line %u: expected <ms> <command>\n", lineNumber);
+        return false;
+    }
+    if (ms * SYSCLOCK_ARM11 / 1000 < hostSimGetTick())
+    {
+        fprintf(stderr, "line %u: time goes backwards\n", lineNumber);
+        return false;
+    }
+    advanceTo(ms);
+
+    if (!strcmp(args[1], "end"))
+    {
+        *ended = true;
+        return true;
+    }
+
+    if (!strcmp(args[1], "effects"))
+        return runEffects(args, argCount, lineNumber);
+
+    if (!strcmp(args[1], "segment"))
+        return runSegment(args, argCount, lineNumber);
+
+    if (!strcmp(args[1], "stems"))
+        return runStems(args, argCount, lineNumber);
+
+    if (!strcmp(args[1], "level") && argCount > 2)
+    {
+        renderSound_t* sound = findSound(args[2]);
+        cwavLevel level;
+        if (!sound || !cwavGetLevel(&sound->cwav, &level))
+        {
+            fprintf(stderr, "line %u: invalid level command\n", lineNumber);
+            return false;
+        }
+        printf("%" PRIu64 " ms: %s peak %.3f rms %.3f\n", ms, sound->name, level.peak, level.rms);
+
+        // Compared as printed, so the expected values can be copied from the output.
+        char printed[16], expected[16];
+        for (u32 i = 3; i < argCount; i++)
+        {
+            char* value = strchr(args[i], '=');
+            if (!value)
+                continue;
+            *value++ = '\0';
+            bool isPeak = !strcmp(args[i], "peak");
+            if (!isPeak && strcmp(args[i], "rms"))
+                continue;
+            snprintf(printed, sizeof(printed), "%.3f", isPeak ? level.peak : level.rms);
+            snprintf(expected, sizeof(expected), "%.3f", strtof(value, NULL));
+            if (strcmp(printed, expected))
+            {
+                fprintf(stderr, "line %u: %s %s is %s, expected %s\n", lineNumber, sound->name, args[i], printed, expected);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    if (!strcmp(args[1], "free") && argCount > 2)
+    {
+        renderSound_t* sound = findSound(args[2]);
+        if (!sound)
+        {
+            fprintf(stderr, "line %u: invalid free command\n", lineNumber);
+            return false;
+        }
+        cwavFileFree(&sound->cwav);
+        sound->cwav.dataBuffer = NULL;
+        sound->name[0] = '\0';
+        return true;
+    }
+
+    if (!strcmp(args[1], "compact"))
+    {
+        size_t compacted = cwavArenaCompact(&g_arena);
+        printf("%" PRIu64 " ms: compacted %zu bytes\n", ms, compacted);
+        if (argCount > 2 && compacted != (size_t)strtoul(args[2], NULL, 0))
+        {
+            fprintf(stderr, "line %u: compacted %zu bytes, expected %s\n", lineNumber, compacted, args[2]);
+            return false;
+        }
+        return true;
+    }
+
+    if (!strcmp(args[1], "mask") && argCount > 2)
+    {
+        cwavSetChannelMask((u32)strtoul(args[2], NULL, 0));
+        return true;
+    }
+
+    if (!strcmp(args[1], "budget") && argCount > 3)
+    {
+        u32 maxChannels = (u32)strtoul(args[3], NULL, 0);
+        if (!strcmp(args[2], "all"))
+            cwavSetChannelBudget(maxChannels);
+        else if (parseCategory(args[2]) >= 0)
+            cwavSetCategoryChannelBudget(parseCategory(args[2]), maxChannels);
+        else
+            fprintf(stderr, "line %u: unknown category %s\n", lineNumber, args[2]);
+        return true;
+    }
+
+    if (!strcmp(args[1], "unreserve") && argCount > 2)
+    {
+        cwavUnreserveChannels((u32)strtoul(args[2], NULL, 0));
+        return true;
+    }
+
+    if (!strcmp(args[1], "reserve") && argCount > 3)
+    {
+        renderSound_t* sound = findSound(args[2]);
+        u32 mask = (u32)strtoul(args[3], NULL, 0);
+        bool reserved = sound ? cwavReserveChannels(mask, &sound->cwav) : parseCategory(args[2]) >= 0 && cwavReserveCategoryChannels(mask, parseCategory(args[2]));
+        if (!reserved)
+            fprintf(stderr, "line %u: could not reserve channels %s\n", lineNumber, args[3]);
+        return true;
+    }
+
+    if (!strcmp(args[1], "category") || !strcmp(args[1], "duck"))
+    {
+        int category = argCount > 2 ? parseCategory(args[2]) : -1;
+        int trigger = argCount > 3 ? parseCategory(args[3]) : -1;
+        if (category < 0 || (args[1][0] == 'd' && (trigger < 0 || argCount < 5)))
+        {
+            fprintf(stderr, "line %u: invalid %s command\n", lineNumber, args[1]);
+            return false;
+        }
+        if (args[1][0] == 'd')
+        {
+            cwavCategorySetDucking(category, trigger, strtof(args[4], NULL));
+            return true;
+        }
+        for (u32 i = 3; i < argCount; i++)
+        {
+            char* value = strchr(args[i], '=');
+            if (!value)
+                continue;
+            *value++ = '\0';
+            if (!strcmp(args[i], "volume"))
+                cwavCategorySetVolume(category, strtof(value, NULL));
+            else if (!strcmp(args[i], "mute"))
+                cwavCategorySetMute(category, atoi(value));
+            else if (!strcmp(args[i], "paused"))
+                cwavCategorySetPaused(category, atoi(value));
+            else
+                fprintf(stderr, "line %u: unknown parameter %s\n", lineNumber, args[i]);
+        }
+        return true;
+    }
+
+    renderSound_t* sound = argCount > 2 ? findSound(args[2]) : NULL;
+    if (!sound)
+    {
+        fprintf(stderr, "line %u: unknown sound\n", lineNumber);
+        return false;
+    }
+
+    int left = 0, right = -1;
+    float mix[12];
+    bool customMix = false;
+    long long start = -1;
+    int region = -1;
+    if (!strcmp(args[1], "stop"))
+        left = -1;
+    for (u32 i = 3; i < argCount; i++)
+    {
+        char* value = strchr(args[i], '=');
+        if (!value)
+            continue;
+        *value++ = '\0';
+        if (!strcmp(args[i], "left"))
+            left = atoi(value);
+        else if (!strcmp(args[i], "right"))
+            right = atoi(value);
+        else if (!strcmp(args[i], "volume"))
+            sound->cwav.volume = strtof(value, NULL);
+        else if (!strcmp(args[i], "pan"))
+            sound->cwav.monoPan = strtof(value, NULL);
+        else if (!strcmp(args[i], "pitch"))
+            sound->cwav.pitch = strtof(value, NULL);
+        else if (!strcmp(args[i], "category") && parseCategory(value) >= 0)
+            sound->cwav.category = parseCategory(value);
+        else if (!strcmp(args[i], "start"))
+            start = atoll(value);
+        else if (!strcmp(args[i], "region"))
+        {
+            region = cwavFindRegion(&sound->cwav, value);
+            if (region < 0)
+                fprintf(stderr, "line %u: unknown region %s\n", lineNumber, value);
+        }
+        else if (!strcmp(args[i], "mix"))
+        {
+            char* next = value;
+            for (u32 j = 0; j < 12; j++)
+            {
+                mix[j] = strtof(next, &next);
+                if (*next == ',')
+                    next++;
+            }
+            customMix = true;
+        }
+        else
+            fprintf(stderr, "line %u: unknown parameter %s\n", lineNumber, args[i]);
+    }
+
+    if (!strcmp(args[1], "play") && start >= 0)
+    {
+        cwavSeqEvent event = {(u64)start, &sound->cwav, (s8)left, (s8)right};
+        if (customMix || region >= 0 || !cwavSequencerSubmit(&event, 1))
+            fprintf(stderr, "line %u: could not sequence the play\n", lineNumber);
+    }
+    else if (!strcmp(args[1], "play"))
+    {
+        cwavPlayResult result;
+        if (region >= 0)
+            result = cwavPlayRegion(&sound->cwav, region, left, right);
+        else if (customMix)
+            result = cwavPlayWithMix(&sound->cwav, left, right, mix, mix);
+        else
+            result = cwavPlay(&sound->cwav, left, right);
+        if (result.playStatus != CWAV_SUCCESS)
+            fprintf(stderr, "line %u: play failed (status %d)\n", lineNumber, result.playStatus);
+    }
+    else if (!strcmp(args[1], "stop"))
+    {
+        cwavStop(&sound->cwav, left, right);
+    }
+    else
+    {
+        fprintf(stderr, "line %u: unknown command %s\n", lineNumber, args[1]);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    const char* scriptName = NULL;
+    const char* outputName = NULL;
+    const char* expected = NULL;
+    ndspInterpType interp = NDSP_INTERP_LINEAR;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-o") && i + 1 < argc)
+            outputName = argv[++i];
+        else if (!strcmp(argv[i], "-c") && i + 1 < argc)
+            expected = argv[++i];
+        else if (!strcmp(argv[i], "-i") && i + 1 < argc)
+        {
+            i++;
+            interp = !strcmp(argv[i], "polyphase") ? NDSP_INTERP_POLYPHASE : !strcmp(argv[i], "none") ? NDSP_INTERP_NONE : NDSP_INTERP_LINEAR;
+        }
+        else if (!scriptName)
+            scriptName = argv[i];
+    }
+    if (!scriptName)
+    {
+        printf("Usage: %s <script> [-o output.wav] [-c expected checksum] [-i linear|polyphase|none]\n", argv[0]);
+        return 1;
+    }
+
+    FILE* script = fopen(scriptName, "r");
+    if (!script)
+    {
+        fprintf(stderr, "Failed to open %s\n", scriptName);
+        return 1;
+    }
+    char scriptDir[1024];
+    snprintf(scriptDir, sizeof(scriptDir), "%s", scriptName);
+    char* slash = strrchr(scriptDir, '/');
+    if (slash)
+        slash[1] = '\0';
+    else
+        scriptDir[0] = '\0';
+
+    renderOutput_t output = {NULL, 0xCBF29CE484222325ULL, 0};
+    if (outputName)
+    {
+        output.file = fopen(outputName, "wb");
+        if (!output.file)
+        {
+            fprintf(stderr, "Failed to open %s\n", outputName);
+            return 1;
+        }
+        writeWavHeader(output.file, 0);
+    }
+
+    hostSimReset();
+    hostSimSetOutputCallback(renderOutputCallback, &output);
+    hostSimSetDefaultInterp(interp);
+    cwavUseEnvironment(CWAV_ENV_DSP);
+    cwavEnableLevelEnvelopes(true);
+    cwavSchedulerStart();
+
+    char line[RENDER_MAX_LINE];
+    u32 lineNumber = 0;
+    bool ended = false;
+    bool success = true;
+    while (success && !ended && fgets(line, sizeof(line), script))
+        success = runCommand(scriptDir, line, ++lineNumber, &ended);
+    fclose(script);
+
+    while (success && !ended && anySoundPlaying() && hostSimGetTick() < (u64)RENDER_MAX_LENGTH_MS * SYSCLOCK_ARM11 / 1000)
+        advanceFrame();
+
+    for (u32 i = 0; i < CWAV_SEGMENT_PLAYERS; i++)
+        cwavSegmentStop(i);
+    for (u32 i = 0; i < g_soundCount; i++)
+        cwavFree(&g_sounds[i].cwav);
+    if (g_arenaBuffer)
+    {
+        cwavSetAllocator(NULL);
+        linearFree(g_arenaBuffer);
+    }
+    cwavEffectsSetChain(0, NULL, 0);
+    cwavEffectsSetChain(1, NULL, 0);
+
+    if (output.file)
+    {
+        fseek(output.file, 0, SEEK_SET);
+        writeWavHeader(output.file, output.sampleCount);
+        fclose(output.file);
+    }
+    if (!success)
+        return 1;
+
+    char checksum[17];
+    snprintf(checksum, sizeof(checksum), "%016" PRIx64, output.checksum);
+    printf("%s %s\n", checksum, scriptName);
+    if (expected && strcmp(expected, checksum))
+    {
+        fprintf(stderr, "%s: checksum mismatch, expected %s\n", scriptName, expected);
+        return 2;
+    }
+    return 0;
+}